@@ -0,0 +1,727 @@
+#!/usr/bin/env python3
+"""
+Generate the Brainfuck programs of the benchmark corpus and their manifest
+Usage: python generate_programs.py
+
+Each program is built from a few cell primitives, and its expected output is computed by a
+Python model of the same integer algorithm, so the manifest can check every backend's output.
+"""
+
+import contextlib
+import hashlib
+import json
+import os
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROGRAM_DIR = os.path.join(SCRIPT_DIR, "programs")
+
+BF_COMMANDS = set("+-<>[].,")
+
+
+class Emitter:
+    """Brainfuck code builder that tracks the data pointer over numbered cells"""
+
+    def __init__(self):
+        self.code = []
+        self.ptr = 0
+        self.top = 0  # First free cell, variables and temporaries are allocated as a stack
+
+    def emit(self, text):
+        self.code.append(text)
+
+    def text(self):
+        return "".join(self.code)
+
+    def var(self, pad=0):
+        """Allocate a cell, pad reserves the zero cells a branch on it needs"""
+        cell = self.top
+        self.top += 1 + pad
+        return cell
+
+    @contextlib.contextmanager
+    def temps(self, count):
+        """Allocate consecutive temporary cells, they must be zero again when released"""
+        start = self.top
+        self.top += count
+        yield list(range(start, start + count))
+        assert self.top == start + count
+        self.top = start
+
+    @contextlib.contextmanager
+    def region(self, start):
+        """Allocate temporaries from start on, such as cells of a group walked over at run time"""
+        saved = self.top
+        self.top = start
+        yield
+        self.top = saved
+
+    def at(self, cell):
+        offset = cell - self.ptr
+        self.emit(">" * offset if offset > 0 else "<" * -offset)
+        self.ptr = cell
+
+    def add(self, cell, amount):
+        self.at(cell)
+        self.emit("+" * amount if amount > 0 else "-" * -amount)
+
+    def add_const(self, cell, amount):
+        """Add a constant, large ones through a multiplication loop"""
+        magnitude = abs(amount)
+        if magnitude <= 16:
+            self.add(cell, amount)
+            return
+        sign = 1 if amount > 0 else -1
+        factor = int(magnitude**0.5)
+        count, rest = divmod(magnitude, factor)
+        with self.temps(1) as (counter,):
+            self.add(counter, count)
+            self.move(counter, (cell, sign * factor))
+        self.add(cell, sign * rest)
+
+    def clear(self, cell):
+        self.at(cell)
+        self.emit("[-]")
+
+    def set(self, cell, value):
+        self.clear(cell)
+        self.add_const(cell, value)
+
+    @contextlib.contextmanager
+    def loop(self, cell):
+        self.at(cell)
+        self.emit("[")
+        yield
+        self.at(cell)
+        self.emit("]")
+
+    def move(self, source, *targets):
+        """Add the source to the targets, each a cell or a (cell, factor) pair, and clear it"""
+        with self.loop(source):
+            self.add(source, -1)
+            for target in targets:
+                cell, factor = target if isinstance(target, tuple) else (target, 1)
+                self.add(cell, factor)
+
+    def copy(self, source, *targets):
+        """Add the source to the targets, keeping it"""
+        with self.temps(1) as (saved,):
+            self.move(source, saved, *targets)
+            self.move(saved, source)
+
+    def subtract(self, cell, source):
+        self.copy(source, (cell, -1))
+
+    def branch(self, cell, nonzero=None, zero=None):
+        """Run one of two blocks depending on a cell, the two cells after it must be zero
+
+        The blocks start and must end at the cell, respectively the cell after it, and must not
+        touch the two cells after it.
+        """
+        flag, landing = cell + 1, cell + 2
+        self.add(flag, 1)
+        self.at(cell)
+        self.emit("[")
+        if nonzero:
+            nonzero()
+        self.at(cell)
+        self.emit(">-]>[-")
+        self.ptr = flag
+        if zero:
+            zero()
+        self.at(flag)
+        self.emit(">]")
+        self.ptr = landing
+
+    @contextlib.contextmanager
+    def if_(self, cell):
+        """Run a block once if a cell is not zero, keeping the cell"""
+        with self.temps(1) as (condition,):
+            self.copy(cell, condition)
+            with self.loop(condition):
+                yield
+                self.clear(condition)
+
+    def if_else(self, cell, nonzero=None, zero=None):
+        """Branch on any cell through a copy of it"""
+        with self.temps(3) as (condition, _, _):
+            self.copy(cell, condition)
+
+            def taken():
+                self.clear(condition)
+                if nonzero:
+                    nonzero()
+
+            self.branch(condition, taken, zero)
+
+    def less_than(self, a, b, result):
+        """result += 1 if a < b, for nonnegative a and b"""
+        with self.temps(3) as (left, _, _), self.temps(1) as (steps,):
+            self.copy(a, left)
+            self.copy(b, steps)
+
+            def reached():
+                self.add(result, 1)
+                self.clear(steps)
+
+            # Count b down and a along with it, until one of them runs out
+            with self.loop(steps):
+                self.add(steps, -1)
+                self.branch(left, lambda: self.add(left, -1), reached)
+            self.clear(left)
+
+    def less_than_const(self, a, value, result):
+        with self.temps(1) as (b,):
+            self.add_const(b, value)
+            self.less_than(a, b, result)
+            self.clear(b)
+
+    def divmod(self, block):
+        """Divide block[0] by block[1] in six cells: block[2] gets the remainder, block[3] the quotient
+
+        block[0] ends as zero and block[1] as the divisor minus the remainder.
+        """
+        assert block == list(range(block[0], block[0] + 6))
+        self.at(block[0])
+        self.emit("[->-[>+>>]>[+[-<+>]>+>>]<<<<<]")
+
+    def divide_const(self, value, divisor, quotient, remainder=None):
+        """quotient += value / divisor, remainder += value % divisor, keeping value"""
+        with self.temps(6) as block:
+            self.copy(value, block[0])
+            self.add_const(block[1], divisor)
+            self.divmod(block)
+            self.clear(block[1])
+            if remainder is None:
+                self.clear(block[2])
+            else:
+                self.move(block[2], remainder)
+            self.move(block[3], quotient)
+
+    def print_text(self, text):
+        with self.temps(1) as (char,):
+            value = 0
+            for c in text:
+                self.add_const(char, ord(c) - value)
+                self.emit(".")
+                value = ord(c)
+            self.clear(char)
+
+    def print_digit(self, cell):
+        self.add_const(cell, ord("0"))
+        self.emit(".")
+        self.add_const(cell, -ord("0"))
+
+    def print_decimal(self, value, digits):
+        """Print a nonnegative cell in decimal, up to the given number of digits"""
+        with self.temps(digits) as places, self.temps(1) as (rest,), self.temps(1) as (started,):
+            self.copy(value, rest)
+            for place in places[:-1]:
+                with self.temps(1) as (quotient,):
+                    self.divide_const(rest, 10, quotient, place)
+                    self.clear(rest)
+                    self.move(quotient, rest)
+            self.move(rest, places[-1])
+
+            # Leading zeros are skipped, the last digit is always printed
+            for place in reversed(places[1:]):
+                with self.if_(place):
+                    self.set(started, 1)
+                with self.if_(started):
+                    self.print_digit(place)
+                self.clear(place)
+            self.print_digit(places[0])
+            self.clear(places[0])
+            self.clear(started)
+
+
+def absolute_difference(e, value, bias, result):
+    """result = |value - bias| for a nonnegative value"""
+    with e.temps(3) as (below, _, _):
+        e.less_than_const(value, bias, below)
+
+        def negative():
+            e.clear(below)
+            e.add_const(result, bias)
+            e.subtract(result, value)
+
+        def positive():
+            e.copy(value, result)
+            e.add_const(result, -bias)
+
+        e.branch(below, negative, positive)
+
+
+def square_divided(e, value, scale, result):
+    """result = value * value / scale"""
+    with e.temps(1) as (square,), e.temps(1) as (count,):
+        e.copy(value, count)
+        with e.loop(count):
+            e.add(count, -1)
+            e.copy(value, square)
+        e.divide_const(square, scale, result)
+        e.clear(square)
+
+
+MANDELBROT = dict(scale=32, width=80, height=32, step_x=1, step_y=2, iterations=48, palette=" .:-=+*%#", inside="@")
+
+
+def mandelbrot_program(scale, width, height, step_x, step_y, iterations, palette, inside):
+    """Mandelbrot set in fixed point, coordinates are stored with a bias that keeps them nonnegative"""
+    e = Emitter()
+    bias = 16 * scale
+    rows, columns, cx, cy = e.var(), e.var(), e.var(), e.var()
+    x, y, escaped = e.var(), e.var(), e.var()
+    left, running = e.var(pad=2), e.var()
+
+    def step(x2, y2):
+        with e.temps(1) as (sum_biased,), e.temps(1) as (distance,), e.temps(1) as (sum_square,):
+            # 2 * zx * zy = (zx + zy)^2 - zx^2 - zy^2
+            e.copy(x, sum_biased)
+            e.copy(y, sum_biased)
+            e.add_const(sum_biased, -bias)
+            absolute_difference(e, sum_biased, bias, distance)
+            square_divided(e, distance, scale, sum_square)
+            e.clear(sum_biased)
+            e.clear(distance)
+
+            e.clear(y)
+            e.move(sum_square, y)
+            e.subtract(y, x2)
+            e.subtract(y, y2)
+            e.copy(cy, y)
+
+            e.clear(x)
+            e.copy(x2, x)
+            e.subtract(x, y2)
+            e.copy(cx, x)
+
+        e.add(left, -1)
+        e.branch(left, None, lambda: e.clear(running))
+
+    def pixel():
+        e.set(x, bias)
+        e.set(y, bias)
+        e.add_const(left, iterations)
+        e.add(running, 1)
+        with e.loop(running):
+            with e.temps(1) as (x2,), e.temps(1) as (y2,):
+                with e.temps(1) as (distance,):
+                    absolute_difference(e, x, bias, distance)
+                    square_divided(e, distance, scale, x2)
+                    e.clear(distance)
+                    absolute_difference(e, y, bias, distance)
+                    square_divided(e, distance, scale, y2)
+                    e.clear(distance)
+
+                with e.temps(3) as (escape, _, _):
+                    with e.temps(1) as (limit,), e.temps(1) as (magnitude,):
+                        e.add_const(limit, 4 * scale)
+                        e.copy(x2, magnitude)
+                        e.copy(y2, magnitude)
+                        e.less_than(limit, magnitude, escape)
+                        e.clear(limit)
+                        e.clear(magnitude)
+
+                    def escape_now():
+                        e.clear(escape)
+                        e.clear(running)
+                        e.add(escaped, 1)
+
+                    e.branch(escape, escape_now, lambda: step(x2, y2))
+                e.clear(x2)
+                e.clear(y2)
+
+        # Escaped points are shaded by the iterations they took
+        def shade():
+            with e.temps(3) as (count, _, _), e.temps(1) as (pending,):
+                e.add_const(count, iterations)
+                e.subtract(count, left)
+                e.add(pending, 1)
+                for char in palette[:-1]:
+                    def reached(char=char):
+                        with e.if_(pending):
+                            e.print_text(char)
+                            e.clear(pending)
+
+                    e.branch(count, lambda: e.add(count, -1), reached)
+                with e.if_(pending):
+                    e.print_text(palette[-1])
+                e.clear(pending)
+                e.clear(count)
+
+        e.if_else(escaped, shade, lambda: e.print_text(inside))
+        e.clear(escaped)
+        e.clear(left)
+
+    e.add_const(cy, bias - scale)
+    e.add_const(rows, height)
+    with e.loop(rows):
+        e.add(rows, -1)
+        e.set(cx, bias - 2 * scale)
+        e.add_const(columns, width)
+        with e.loop(columns):
+            e.add(columns, -1)
+            pixel()
+            e.add(cx, step_x)
+        e.print_text("\n")
+        e.add(cy, step_y)
+    return e.text()
+
+
+def mandelbrot_model(scale, width, height, step_x, step_y, iterations, palette, inside):
+    bias = 16 * scale
+    lines = []
+    for row in range(height):
+        cy = -scale + row * step_y
+        line = ""
+        for column in range(width):
+            cx = -2 * scale + column * step_x
+            zx = zy = 0
+            count = 0
+            escaped = False
+            while True:
+                x2 = zx * zx // scale
+                y2 = zy * zy // scale
+                if x2 + y2 > 4 * scale:
+                    escaped = True
+                    break
+                sum_square = (zx + zy) * (zx + zy) // scale
+                zx, zy = x2 - y2 + cx, sum_square - x2 - y2 + cy
+                assert max(abs(zx), abs(zy), abs(zx + zy)) < bias
+                count += 1
+                if count == iterations:
+                    break
+            line += palette[min(count, len(palette) - 1)] if escaped else inside
+        lines.append(line + "\n")
+    return "".join(lines)
+
+
+FACTOR_NUMBERS = [2, 36, 1001, 65536, 65537, 99991, 360360, 1000000, 524287]
+
+
+def factor_program(digits=10):
+    """Trial division of the numbers on the input lines, printed like the factor utility"""
+    e = Emitter()
+    running, reading, seen = e.var(), e.var(), e.var(pad=2)
+    number, char, divisor, dividing = e.var(), e.var(), e.var(), e.var()
+
+    def print_if_above_one(cell, prefix):
+        with e.temps(1) as (one,), e.temps(1) as (above,):
+            e.add(one, 1)
+            e.less_than(one, cell, above)
+            e.clear(one)
+            with e.if_(above):
+                e.print_text(prefix)
+                e.print_decimal(cell, digits)
+            e.clear(above)
+
+    def factor():
+        e.clear(seen)
+        e.print_decimal(number, digits)
+        e.print_text(":")
+        e.set(divisor, 2)
+        with e.temps(1) as (one,):
+            e.add(one, 1)
+            e.less_than(one, number, dividing)
+            e.clear(one)
+        with e.loop(dividing):
+            with e.temps(6) as block, e.temps(3) as (remainder, _, _):
+                quotient = block[3]
+                e.copy(number, block[0])
+                e.copy(divisor, block[1])
+                e.divmod(block)
+                e.clear(block[1])
+                e.move(block[2], remainder)
+
+                def no_factor():
+                    e.clear(remainder)
+                    # A quotient below the divisor leaves a prime
+                    with e.temps(1) as (prime,):
+                        e.less_than(quotient, divisor, prime)
+                        e.if_else(prime, lambda: e.clear(dividing), lambda: e.add(divisor, 1))
+                        e.clear(prime)
+                    e.clear(quotient)
+
+                def found():
+                    e.print_text(" ")
+                    e.print_decimal(divisor, digits)
+                    e.clear(number)
+                    e.move(quotient, number)
+
+                e.branch(remainder, no_factor, found)
+        print_if_above_one(number, " ")
+        e.print_text("\n")
+        e.clear(number)
+        e.clear(divisor)
+
+    e.add(running, 1)
+    with e.loop(running):
+        # Read the digits of a line, a line without any ends the input
+        e.add(reading, 1)
+        with e.loop(reading):
+            e.at(char)
+            e.emit(",")
+            with e.temps(3) as (digit, _, _):
+                e.less_than_const(char, ord("9") + 1, digit)
+                with e.temps(1) as (below,):
+                    e.less_than_const(char, ord("0"), below)
+                    e.move(below, (digit, -1))
+
+                def append():
+                    e.clear(digit)
+                    with e.temps(1) as (shifted,):
+                        e.move(number, (shifted, 10))
+                        e.move(shifted, number)
+                    e.move(char, number)
+                    e.add_const(number, -ord("0"))
+                    e.set(seen, 1)
+
+                e.branch(digit, append, lambda: e.clear(reading))
+            e.clear(char)
+        e.branch(seen, factor, lambda: e.clear(running))
+    return e.text()
+
+
+def factor_model(numbers):
+    lines = []
+    for number in numbers:
+        line = f"{number}:"
+        divisor = 2
+        dividing = number > 1
+        while dividing:
+            quotient, remainder = divmod(number, divisor)
+            if remainder == 0:
+                line += f" {divisor}"
+                number = quotient
+            elif quotient < divisor:
+                dividing = False
+            else:
+                divisor += 1
+        if number > 1:
+            line += f" {number}"
+        lines.append(line + "\n")
+    return "".join(lines)
+
+
+HANOI_DISKS = 20
+
+
+def hanoi_program(disks):
+    """Towers of Hanoi, a binary counter picks the disk of each move"""
+    e = Emitter()
+    running, carry = e.var(), e.var()
+    bits = [e.var(pad=2) for _ in range(disks)]
+    pegs = [[e.var(), e.var(), e.var()] for _ in range(disks)]
+
+    def print_peg(flags):
+        for name, flag in zip("ABC", flags):
+            with e.if_(flag):
+                e.print_text(name)
+
+    def move_disk(disk):
+        # Every disk cycles over the pegs, in the direction given by the disks up to it
+        flags = pegs[disk]
+        e.print_text(f"{disk + 1} ")
+        print_peg(flags)
+        with e.temps(1) as (saved,):
+            if (disks - disk) % 2 == 0:
+                e.move(flags[2], saved)
+                e.move(flags[1], flags[2])
+                e.move(flags[0], flags[1])
+                e.move(saved, flags[0])
+            else:
+                e.move(flags[0], saved)
+                e.move(flags[1], flags[0])
+                e.move(flags[2], flags[1])
+                e.move(saved, flags[2])
+        e.print_text(" ")
+        print_peg(flags)
+        e.print_text("\n")
+
+    for flags in pegs:
+        e.add(flags[0], 1)
+    e.add(running, 1)
+    with e.loop(running):
+        # Incrementing the counter moves the disk of the bit that turns on
+        e.add(carry, 1)
+        for disk, bit in enumerate(bits):
+            with e.if_(carry):
+
+                def flip_on(disk=disk, bit=bit):
+                    e.add(bit, 1)
+                    e.clear(carry)
+                    move_disk(disk)
+
+                e.branch(bit, lambda bit=bit: e.clear(bit), flip_on)
+        with e.if_(carry):
+            e.clear(running)
+        e.clear(carry)
+    return e.text()
+
+
+def hanoi_model(disks):
+    stacks = [list(range(disks, 0, -1)), [], []]
+    positions = [0] * disks
+    lines = []
+    for move in range(1, 2**disks):
+        disk = (move & -move).bit_length() - 1
+        source = positions[disk]
+        target = (source + (1 if (disks - disk) % 2 == 0 else 2)) % 3
+        assert stacks[source][-1] == disk + 1 and (not stacks[target] or stacks[target][-1] > disk + 1)
+        stacks[target].append(stacks[source].pop())
+        positions[disk] = target
+        lines.append(f"{disk + 1} {'ABC'[source]} {'ABC'[target]}\n")
+    assert len(stacks[2]) == disks
+    return "".join(lines)
+
+
+BIGNUM_ROUNDS = (100, 80)
+BIGNUM_MEMORY = 65536  # Ten cells per digit right of the tape's middle, more than the default tape has
+
+
+def bignum_program(outer, inner):
+    """Decimal digits of 2^(outer * inner), doubled digit by digit in groups of cells"""
+    e = Emitter()
+    rounds, doublings = e.var(), e.var()
+    group = 10  # Per digit: flag, digit, carry in, then temporaries
+    flag, digit, carry = 0, 1, 2
+    first = e.top + 2 * group  # The group before the first digit stays zero and ends walks to the left
+
+    def double():
+        # Walk over the digits, from the least significant one
+        e.at(first + flag)
+        e.emit("[")
+        following = first + group
+        with e.region(first + 3):
+            with e.temps(3) as (rest, _, _), e.temps(3) as (wrapped, _, _):
+                with e.temps(1) as (doubled,):
+                    e.move(first + digit, (doubled, 2))
+                    e.move(doubled, first + digit)
+                e.move(first + carry, first + digit)
+
+                # Subtract 10 from a copy, a step that finds it zero clears wrapped
+                e.copy(first + digit, rest)
+                e.add(wrapped, 1)
+                for _ in range(10):
+                    e.branch(rest, lambda: e.add(rest, -1), lambda: e.clear(wrapped))
+
+                def carry_out():
+                    e.clear(wrapped)
+                    e.clear(first + digit)
+                    e.move(rest, first + digit)
+                    e.add(following + carry, 1)
+
+                e.branch(wrapped, carry_out)
+                e.clear(rest)
+
+        # A carry past the most significant digit adds a digit
+        with e.region(following + 3):
+
+            def extend():
+                e.clear(following + flag)
+                e.add(following + flag, 1)
+
+            e.branch(following + carry, extend)
+        e.at(following + flag)
+        e.emit("]")
+
+        # Back from the group after the last digit to the one before the first
+        e.emit("<" * group + "[" + "<" * group + "]")
+        e.ptr = first - group + flag
+
+    e.add(first + flag, 1)
+    e.add(first + digit, 1)
+    e.add_const(rounds, outer)
+    with e.loop(rounds):
+        e.add(rounds, -1)
+        e.add_const(doublings, inner)
+        with e.loop(doublings):
+            e.add(doublings, -1)
+            double()
+
+    # Print from the most significant digit down
+    e.at(first - group + flag)
+    e.emit(">" * group + "[" + ">" * group + "]" + "<" * group + "[")
+    e.ptr = first + flag
+    with e.region(first + 3):
+        e.print_digit(first + digit)
+    e.at(first + flag)
+    e.emit("<" * group + "]")
+    e.ptr = first - group + flag
+    e.print_text("\n")
+    return e.text()
+
+
+def bignum_model(outer, inner):
+    return str(2 ** (outer * inner)) + "\n"
+
+
+PROGRAMS = [
+    dict(
+        name="mandelbrot",
+        description="ASCII Mandelbrot set in fixed point arithmetic",
+        cell_bits=32,
+        source=lambda: mandelbrot_program(**MANDELBROT),
+        output=lambda: mandelbrot_model(**MANDELBROT),
+    ),
+    dict(
+        name="factor",
+        description="Trial division of the numbers on its input lines",
+        cell_bits=32,
+        input="".join(f"{number}\n" for number in FACTOR_NUMBERS),
+        source=factor_program,
+        output=lambda: factor_model(FACTOR_NUMBERS),
+    ),
+    dict(
+        name="hanoi",
+        description=f"Moves of the Towers of Hanoi with {HANOI_DISKS} disks",
+        cell_bits=8,
+        source=lambda: hanoi_program(HANOI_DISKS),
+        output=lambda: hanoi_model(HANOI_DISKS),
+    ),
+    dict(
+        name="bignum",
+        description=f"Decimal digits of 2 to the {BIGNUM_ROUNDS[0] * BIGNUM_ROUNDS[1]}",
+        cell_bits=8,
+        memory=BIGNUM_MEMORY,
+        source=lambda: bignum_program(*BIGNUM_ROUNDS),
+        output=lambda: bignum_model(*BIGNUM_ROUNDS),
+    ),
+]
+
+
+def format_source(description, code, width=80):
+    header = f"{description}\nGenerated by generate_programs py in the bench directory\n\n"
+    assert not BF_COMMANDS & set(header)
+    return header + "\n".join(code[i : i + width] for i in range(0, len(code), width)) + "\n"
+
+
+def main():
+    os.makedirs(PROGRAM_DIR, exist_ok=True)
+    manifest = []
+    for program in PROGRAMS:
+        name = program["name"]
+        with open(os.path.join(PROGRAM_DIR, name + ".bf"), "w", newline="\n") as f:
+            f.write(format_source(program["description"], program["source"]()))
+
+        entry = {"name": name, "source": name + ".bf", "cell_bits": program["cell_bits"]}
+        if "memory" in program:
+            entry["memory"] = program["memory"]
+        if "input" in program:
+            entry["input"] = name + ".in"
+            with open(os.path.join(PROGRAM_DIR, entry["input"]), "w", newline="\n") as f:
+                f.write(program["input"])
+
+        output = program["output"]().encode()
+        entry["output_bytes"] = len(output)
+        entry["output_sha256"] = hashlib.sha256(output).hexdigest()
+        manifest.append(entry)
+        print(f"{name}: {len(output)} output bytes")
+
+    with open(os.path.join(PROGRAM_DIR, "manifest.json"), "w", newline="\n") as f:
+        json.dump({"generated_by": "generate_programs.py, do not edit", "programs": manifest}, f, indent=2)
+        f.write("\n")
+
+
+if __name__ == "__main__":
+    main()
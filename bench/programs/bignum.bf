@@ -0,0 +1,12 @@
+Decimal digits of 2 to the 8000
+Generated by generate_programs py in the bench directory
+
+>>>>>>>>>>>>>>>>>>>>>>+>+<<<<<<<<<<<<<<<<<<<<<++++++++++[-<<++++++++++>>]<<[->>+
++++++++++[-<++++++++>]<[->>>>>>>>>>>>>>>>>>>>>[>[->>>>>>>>++<<<<<<<<]>>>>>>>>[-<
+<<<<<<<+>>>>>>>>]<<<<<<<[-<+>]<[->>>>>>>>+<<<<<<+<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]
+<<<+<<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-
+]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-
+]<<>]<+<[->-]>[->>[-]<<>]<+<[->-]>[->>[-]<<>]>>+<[[-]<<<<<[-]>>[-<<+>>]>>>>>>>>>
++<<<<<<>-]>[->]<<<<<[-]>>>>>>>>>>+<[<<[-]+>>>-]>[->]<<<<]<<<<<<<<<<[<<<<<<<<<<]<
+<<<<<<<<<<]<]>>>>>>>>>>>>>>>>>>>>>>[>>>>>>>>>>]<<<<<<<<<<[>>>++++++++[-<<++++++>
+>]<<.>>++++++++[-<<------>>]<<<<<<<<<<<<<]<<<<<<<<<<++++++++++.[-]
@@ -0,0 +1,157 @@
+Trial division of the numbers on its input lines
+Generated by generate_programs py in the bench directory
+
++[>+[>>>>>,>>>>>>>++++++++[-<+++++++>]<++<<<<<<[->>>>>>>>>>>+<<<<+<<<<<<<]>>>>>>
+>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<<<<<[->>>>>+<+<<<<]>>>>>[-<<<<<+>>>>>]<[-<<+<[->
+-]>[-<<<<<+>>>>>>>[-]<<>]>]<<<[-]<[-]>>++++++++[-<++++++>]<<<<<<<<[->>>>>>>>>>>>
++<<<<+<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>>>>>>>>>>>>]<<<<<[->>>>>+<+<<<<]>>>>>
+[-<<<<<+>>>>>]<[-<<+<[->-]>[-<<<+>>>>>[-]<<>]>]<<<[-]<[-]<[-<<<->>>]<<+<[[-]<<<<
+[->>>>>>>++++++++++<<<<<<<]>>>>>>>[-<<<<<<<+>>>>>>>]<<<<<<[-<+>]>>>>>>++++++++[-
+<<<<<<<------>>>>>>>]<<<<<<<<<<[-]+>>>>>>>>-]>[-<<<<<<<<<[-]>>>>>>>>>>]<<<<<[-]<
+<<<<]>>+<[[-]>>>[->>>>>>>>>>>>>>>>+<<+<<<<<<<<<<<<<<]>>>>>>>>>>>>>>>>[-<<<<<<<<<
+<<<<<<<+>>>>>>>>>>>>>>>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>
+]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<<<<+>>>>>>>>>>
+>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<
+<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<<
+<+>>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>
+>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<
+<<<<<<<<<<<+>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<
+<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]
+>[-]>[-<<<<<<<<<<<<+>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<
+<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>
+]<<<<<]>[-]>[-<<<<<<<<<<<+>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>
+>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>
+]>+>>]<<<<<]>[-]>[-<<<<<<<<<<+>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>
+>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-
+<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<+>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>
+>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[
+-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<+>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>
+>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-
+<+>]>+>>]<<<<<]>[-]>[-<<<<<<<+>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[-<+>]<[
+->>>>+<+<<<]>>>>[-<<<<+>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<+++
++++>>>>]<<<<.>>>>++++++++[-<<<<------>>>>]<<<<>>>[-]]<<<[-]<[->>>>>+<+<<<<]>>>>>
+[-<<<<<+>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<++++++>>>>>]<<<<
+<.>>>>>++++++++[-<<<<<------>>>>>]<<<<<>>>>[-]]<<<<[-]<[->>>>>>+<+<<<<<]>>>>>>[-
+<<<<<<+>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<++++++>>>>>>]<<
+<<<<.>>>>>>++++++++[-<<<<<<------>>>>>>]<<<<<<>>>>>[-]]<<<<<[-]<[->>>>>>>+<+<<<<
+<<]>>>>>>>[-<<<<<<<+>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<
+++++++>>>>>>>]<<<<<<<.>>>>>>>++++++++[-<<<<<<<------>>>>>>>]<<<<<<<>>>>>>[-]]<<<
+<<<[-]<[->>>>>>>>+<+<<<<<<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>
+[-<<+>>]<[>++++++++[-<<<<<<<<++++++>>>>>>>>]<<<<<<<<.>>>>>>>>++++++++[-<<<<<<<<-
+----->>>>>>>>]<<<<<<<<>>>>>>>[-]]<<<<<<<[-]<[->>>>>>>>>+<+<<<<<<<<]>>>>>>>>>[-<<
+<<<<<<<+>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<++++++>>
+>>>>>>>]<<<<<<<<<.>>>>>>>>>++++++++[-<<<<<<<<<------>>>>>>>>>]<<<<<<<<<>>>>>>>>[
+-]]<<<<<<<<[-]<[->>>>>>>>>>+<+<<<<<<<<<]>>>>>>>>>>[-<<<<<<<<<<+>>>>>>>>>>]<[<[-]
++>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<++++++>>>>>>>>>>]<<<<<<<<<<.>>>
+>>>>>>>++++++++[-<<<<<<<<<<------>>>>>>>>>>]<<<<<<<<<<>>>>>>>>>[-]]<<<<<<<<<[-]<
+[->>>>>>>>>>>+<+<<<<<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<[<[-]+>[-]]<[->
+>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<<++++++>>>>>>>>>>>]<<<<<<<<<<<.>>>>>>>>>>
+>++++++++[-<<<<<<<<<<<------>>>>>>>>>>>]<<<<<<<<<<<>>>>>>>>>>[-]]<<<<<<<<<<[-]<[
+->>>>>>>>>>>>+<+<<<<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>>>>>>>>>>>>]<[<[-]+>[-]]
+<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<<<++++++>>>>>>>>>>>>]<<<<<<<<<<<<.>>>
+>>>>>>>>>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<<<<<<<>>>>>>>>>>>[-]]<<<
+<<<<<<<<[-]>>>>>>>>>>>++++++++[-<<<<<<<<<<<<++++++>>>>>>>>>>>>]<<<<<<<<<<<<.>>>>
+>>>>>>>>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<<<<<<<[-]>>>>>>>>>>>[-]<<
+<<<<<<<<++++++++[-<+++++++>]<++.[-]<<[-]++>>+[->>>>>+<<<<+<]>>>>>[-<<<<<+>>>>>]<
+<<<<<<<<[->>>>>>>>>+<+<<<<<<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<[-<<+<[->-]>[-<<<
++>>>>>[-]<<>]>]<<<[-]<[-]<[<<<[->>>>>>>>>>>>>+<<<<<<<<<+<<<<]>>>>>>>>>>>>>[-<<<<
+<<<<<<<<<+>>>>>>>>>>>>>]<<<<<<<<<<<[->>>>>>>>>>>+<<<<<<<<+<<<]>>>>>>>>>>>[-<<<<<
+<<<<<<+>>>>>>>>>>>]<<<<<<<<<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[->>>>+<<<<]>>>>>
++<[[-]<<<[->>>>>>>>>>>+<<<<+<<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<<<<<<<
+<<<<<<<<<[->>>>>>>>>>>>>>>>+<+<<<<<<<<<<<<<<<]>>>>>>>>>>>>>>>>[-<<<<<<<<<<<<<<<<
++>>>>>>>>>>>>>>>>]<[-<<+<[->-]>[-<<+>>>>[-]<<>]>]<<<[-]<[->>>>+<<<+<]>>>>[-<<<<+
+>>>>]<<+<[[-]<<<<<<<<<<<[-]>>>>>>>>>>>>-]>[-<<<<<<<<<<<<<+>>>>>>>>>>>>>>]<<<[-]<
+<<<<<[-]>>>>-]>[->>>++++++[-<+++++>]<++.[-]<<<<<<<<<<<[->>>>>>>>>>>>>>>>>>>>>>>+
+<<+<<<<<<<<<<<<<<<<<<<<<]>>>>>>>>>>>>>>>>>>>>>>>[-<<<<<<<<<<<<<<<<<<<<<<<+>>>>>>
+>>>>>>>>>>>>>>>>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<+
++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>]>
+[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>
+>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<<<+>>>>>
+>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<
+<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<
+<<<<+>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>
+>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-
+<<<<<<<<<<<<+>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<
+<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]
+>[-]>[-<<<<<<<<<<<+>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<
+<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<
+<<<<]>[-]>[-<<<<<<<<<<+>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+
+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>
+>]<<<<<]>[-]>[-<<<<<<<<<+>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>
++<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+
+>>]<<<<<]>[-]>[-<<<<<<<<+>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+
+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>
+>]<<<<<]>[-]>[-<<<<<<<+>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[-<+>]<[->>>>+<
++<<<]>>>>[-<<<<+>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<++++++>>>>
+]<<<<.>>>>++++++++[-<<<<------>>>>]<<<<>>>[-]]<<<[-]<[->>>>>+<+<<<<]>>>>>[-<<<<<
++>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<++++++>>>>>]<<<<<.>>>>>
+++++++++[-<<<<<------>>>>>]<<<<<>>>>[-]]<<<<[-]<[->>>>>>+<+<<<<<]>>>>>>[-<<<<<<+
+>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<++++++>>>>>>]<<<<<<.>>
+>>>>++++++++[-<<<<<<------>>>>>>]<<<<<<>>>>>[-]]<<<<<[-]<[->>>>>>>+<+<<<<<<]>>>>
+>>>[-<<<<<<<+>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<++++++>
+>>>>>>]<<<<<<<.>>>>>>>++++++++[-<<<<<<<------>>>>>>>]<<<<<<<>>>>>>[-]]<<<<<<[-]<
+[->>>>>>>>+<+<<<<<<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>
+]<[>++++++++[-<<<<<<<<++++++>>>>>>>>]<<<<<<<<.>>>>>>>>++++++++[-<<<<<<<<------>>
+>>>>>>]<<<<<<<<>>>>>>>[-]]<<<<<<<[-]<[->>>>>>>>>+<+<<<<<<<<]>>>>>>>>>[-<<<<<<<<<
++>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<++++++>>>>>>>>>
+]<<<<<<<<<.>>>>>>>>>++++++++[-<<<<<<<<<------>>>>>>>>>]<<<<<<<<<>>>>>>>>[-]]<<<<
+<<<<[-]<[->>>>>>>>>>+<+<<<<<<<<<]>>>>>>>>>>[-<<<<<<<<<<+>>>>>>>>>>]<[<[-]+>[-]]<
+[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<++++++>>>>>>>>>>]<<<<<<<<<<.>>>>>>>>>>
+++++++++[-<<<<<<<<<<------>>>>>>>>>>]<<<<<<<<<<>>>>>>>>>[-]]<<<<<<<<<[-]<[->>>>>
+>>>>>>+<+<<<<<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>
+>[-<<+>>]<[>++++++++[-<<<<<<<<<<<++++++>>>>>>>>>>>]<<<<<<<<<<<.>>>>>>>>>>>++++++
+++[-<<<<<<<<<<<------>>>>>>>>>>>]<<<<<<<<<<<>>>>>>>>>>[-]]<<<<<<<<<<[-]<[->>>>>>
+>>>>>>+<+<<<<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>>>>>>>>>>>>]<[<[-]+>[-]]<[->>+<
++<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<<<++++++>>>>>>>>>>>>]<<<<<<<<<<<<.>>>>>>>>>>
+>>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<<<<<<<>>>>>>>>>>>[-]]<<<<<<<<<<
+<[-]>>>>>>>>>>>++++++++[-<<<<<<<<<<<<++++++>>>>>>>>>>>>]<<<<<<<<<<<<.>>>>>>>>>>>
+>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<<<<<<<[-]>>>>>>>>>>>[-]<<<<<<<<<
+<<<<<<<<<<<<<<<[-]>>>>>>>[-<<<<<<<+>>>>>>>]>>>>>]<<<<<<<<<]>+[->>>>>>+<<<<+<<]>>
+>>>>[-<<<<<<+>>>>>>]<<<<<<<<<<[->>>>>>>>>>+<+<<<<<<<<<]>>>>>>>>>>[-<<<<<<<<<<+>>
+>>>>>>>>]<[-<<+<[->-]>[-<<+>>>>[-]<<>]>]<<<[-]<<[-]>[->>+<+<]>>[-<<+>>]<[>>+++++
++[-<+++++>]<++.[-]<<<<<<<[->>>>>>>>>>>>>>>>>>>+<<+<<<<<<<<<<<<<<<<<]>>>>>>>>>>>>
+>>>>>>>[-<<<<<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>>>>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>
+>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<
+<<<<<<<<<<<<<+>>>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<
+<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<
+<<<]>[-]>[-<<<<<<<<<<<<<<+>>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>>]<<[->>>
+>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>+>>]>[+[-
+<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<<+>>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>>[-<<+>
+>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++<[->-[>
++>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<<+>>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<<[-]>
+>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++++++++++
+<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<<+>>>>>>>>>>>]>[-<<<<+>>>>]<<<<<
+<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<+++++
++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<<+>>>>>>>>>>]>[-<<<<+>>>>]<<
+<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++
+++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<<+>>>>>>>>>]>[-<<<<+>>>>]<
+<<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<+
++++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<<+>>>>>>>>]>[-<<<<+>>>>]<<
+<<<<[-]>>[-<<+>>]<<[->>>>>>>>>+<<<<<<+<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<<<<<++
+++++++++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-<<<<<<<+>>>>>>>]>[-<<<<+>>>>]<<<<<
+<[-]>>[-<<+>>]<<[-<+>]<[->>>>+<+<<<]>>>>[-<<<<+>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<
++>>]<[>++++++++[-<<<<++++++>>>>]<<<<.>>>>++++++++[-<<<<------>>>>]<<<<>>>[-]]<<<
+[-]<[->>>>>+<+<<<<]>>>>>[-<<<<<+>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>+++++++
++[-<<<<<++++++>>>>>]<<<<<.>>>>>++++++++[-<<<<<------>>>>>]<<<<<>>>>[-]]<<<<[-]<[
+->>>>>>+<+<<<<<]>>>>>>[-<<<<<<+>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>+++++++
++[-<<<<<<++++++>>>>>>]<<<<<<.>>>>>>++++++++[-<<<<<<------>>>>>>]<<<<<<>>>>>[-]]<
+<<<<[-]<[->>>>>>>+<+<<<<<<]>>>>>>>[-<<<<<<<+>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<
++>>]<[>++++++++[-<<<<<<<++++++>>>>>>>]<<<<<<<.>>>>>>>++++++++[-<<<<<<<------>>>>
+>>>]<<<<<<<>>>>>>[-]]<<<<<<[-]<[->>>>>>>>+<+<<<<<<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]
+<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<++++++>>>>>>>>]<<<<<<<<.>>>
+>>>>>++++++++[-<<<<<<<<------>>>>>>>>]<<<<<<<<>>>>>>>[-]]<<<<<<<[-]<[->>>>>>>>>+
+<+<<<<<<<<]>>>>>>>>>[-<<<<<<<<<+>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>+++
++++++[-<<<<<<<<<++++++>>>>>>>>>]<<<<<<<<<.>>>>>>>>>++++++++[-<<<<<<<<<------>>>>
+>>>>>]<<<<<<<<<>>>>>>>>[-]]<<<<<<<<[-]<[->>>>>>>>>>+<+<<<<<<<<<]>>>>>>>>>>[-<<<<
+<<<<<<+>>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<++++++>
+>>>>>>>>>]<<<<<<<<<<.>>>>>>>>>>++++++++[-<<<<<<<<<<------>>>>>>>>>>]<<<<<<<<<<>>
+>>>>>>>[-]]<<<<<<<<<[-]<[->>>>>>>>>>>+<+<<<<<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>
+>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<<++++++>>>>>>>>>>
+>]<<<<<<<<<<<.>>>>>>>>>>>++++++++[-<<<<<<<<<<<------>>>>>>>>>>>]<<<<<<<<<<<>>>>>
+>>>>>[-]]<<<<<<<<<<[-]<[->>>>>>>>>>>>+<+<<<<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>
+>>>>>>>>>>>]<[<[-]+>[-]]<[->>+<+<]>>[-<<+>>]<[>++++++++[-<<<<<<<<<<<<++++++>>>>>
+>>>>>>>]<<<<<<<<<<<<.>>>>>>>>>>>>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<
+<<<<<<>>>>>>>>>>>[-]]<<<<<<<<<<<[-]>>>>>>>>>>>++++++++[-<<<<<<<<<<<<++++++>>>>>>
+>>>>>>]<<<<<<<<<<<<.>>>>>>>>>>>>++++++++[-<<<<<<<<<<<<------>>>>>>>>>>>>]<<<<<<<
+<<<<<[-]>>>>>>>>>>>[-]<<<<<<<<<<<<[-]]<[-]<++++++++++.[-]<<<<[-]>>[-]<<<<<>-]>[-
+<<<[-]>>>>]<<<<]
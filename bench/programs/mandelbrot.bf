@@ -0,0 +1,65 @@
+ASCII Mandelbrot set in fixed point arithmetic
+Generated by generate_programs py in the bench directory
+
+>>>>>>>>>>>++++++++++++++++++++++[-<<<<<<<<+++++++++++++++++++++>>>>>>>>]<<<<<<<
+<++++++++++++++++++>>>>>>>>++++++[-<<<<<<<<<<<+++++>>>>>>>>>>>]<<<<<<<<<<<++[->>
+[-]>>>>>>>>>+++++++++++++++++++++[-<<<<<<<<<+++++++++++++++++++++>>>>>>>>>]<<<<<
+<<<<+++++++>>>>>>>>>++++++++++[-<<<<<<<<<<++++++++>>>>>>>>>>]<<<<<<<<<<[->>>[-]>
+>>>>>>+++++++++++++++++++++++[-<<<<<<<++++++++++++++++++++++>>>>>>>]<<<<<<<+++++
++>[-]>>>>>>+++++++++++++++++++++++[-<<<<<<++++++++++++++++++++++>>>>>>]<<<<<<+++
++++>>>>>>++++++++[-<<<<++++++>>>>]<<<<>>>+[>>>>>>>>+++++++++++++++++++++++[-<+++
++++++++++++++++++++>]<++++++<<<<<<<<<<<<<[->>>>>>>>>>>>>>>>>>+<<<<+<<<<<<<<<<<<<
+<]>>>>>>>>>>>>>>>>>>[-<<<<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>>>>]<<<<<[->>>>>+<+<<<<]
+>>>>>[-<<<<<+>>>>>]<[-<<+<[->-]>[-<<<<<+>>>>>>>[-]<<>]>]<<<[-]<[-]<<+<[[-]>>>+++
+++++++++++++++++++++[-<<<<++++++++++++++++++++++>>>>]<<<<++++++<<<<<<<<<[->>>>>>
+>>>>>>>+<<<<-<<<<<<<<<]>>>>>>>>>>>>>[-<<<<<<<<<<<<<+>>>>>>>>>>>>>]<<<>-]>[-<<<<<
+<<<<<<[->>>>>>>>>>>>>+<<<<+<<<<<<<<<]>>>>>>>>>>>>>[-<<<<<<<<<<<<<+>>>>>>>>>>>>>]
++++++++++++++++++++++++[-<<<<---------------------->>>>]<<<<------>>>]<<<[->>>+<
++<<]>>>[-<<<+>>>]<[-<<[->>>+<<+<]>>>[-<<<+>>>]<]<[->>>>>>>>+<<<<<<+<<]>>>>>>>>[-
+<<<<<<<<+>>>>>>>>]++++++[-<<<<<+++++>>>>>]<<<<<++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]
+>[-]>[-]>[-<<<<<<<<+>>>>>>>>]<<<<<[-]<[-]>>>>>+++++++++++++++++++++++[-<++++++++
+++++++++++++++>]<++++++<<<<<<<<<<<<[->>>>>>>>>>>>>>>>>+<<<<+<<<<<<<<<<<<<]>>>>>>
+>>>>>>>>>>>[-<<<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>>>]<<<<<[->>>>>+<+<<<<]>>>>>[-<<<<
+<+>>>>>]<[-<<+<[->-]>[-<<<<<+>>>>>>>[-]<<>]>]<<<[-]<[-]<<+<[[-]>>>++++++++++++++
++++++++++[-<<<<++++++++++++++++++++++>>>>]<<<<++++++<<<<<<<<[->>>>>>>>>>>>+<<<<-
+<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>>>>>>>>>>>>]<<<>-]>[-<<<<<<<<<<[->>>>>>>>>>
+>>+<<<<+<<<<<<<<]>>>>>>>>>>>>[-<<<<<<<<<<<<+>>>>>>>>>>>>]+++++++++++++++++++++++
+[-<<<<---------------------->>>>]<<<<------>>>]<<<[->>>+<+<<]>>>[-<<<+>>>]<[-<<[
+->>>+<<+<]>>>[-<<<+>>>]<]<[->>>>>>>>+<<<<<<+<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]+++++
++[-<<<<<+++++>>>>>]<<<<<++<[->-[>+>>]>[+[-<+>]>+>>]<<<<<]>[-]>[-]>[-<<<<<<<+>>>>
+>>>]<<<<<[-]<[-]>>>>>+++++++++++[-<<+++++++++++>>]<<+++++++<<<<<[->>>>>>>+<+<<<<
+<<]>>>>>>>[-<<<<<<<+>>>>>>>]<<<<<<[->>>>>>+<+<<<<<]>>>>>>[-<<<<<<+>>>>>>]<<[->>>
+>>>+<<<<+<<]>>>>>>[-<<<<<<+>>>>>>]<<<<<[->>>>>+<+<<<<]>>>>>[-<<<<<+>>>>>]<[-<<+<
+[->-]>[-<<<<<<+>>>>>>>>[-]<<>]>]<<<[-]<<[-]>[-]<<<+<[[-]<<<[-]<<<<+>>>>>>>>-]>[-
+<<<<<<<<<<[->>>>>>>>>>>>>>>+<<<+<<<<<<<<<<<<]>>>>>>>>>>>>>>>[-<<<<<<<<<<<<<<<+>>
+>>>>>>>>>>>>>]<<<<<<<<<<<<<<[->>>>>>>>>>>>>>+<<<+<<<<<<<<<<<]>>>>>>>>>>>>>>[-<<<
+<<<<<<<<<<<+>>>>>>>>>>>>>>]+++++++++++++++++++++++[-<<<---------------------->>>
+]<<<------>>>>>>>+++++++++++++++++++++++[-<++++++++++++++++++++++>]<++++++<<<<<<
+[->>>>>>>>>>>+<<<<+<<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<<<<<[->>>>>+<+<
+<<<]>>>>>[-<<<<<+>>>>>]<[-<<+<[->-]>[-<<<<<+>>>>>>>[-]<<>]>]<<<[-]<[-]<<+<[[-]>>
+>+++++++++++++++++++++++[-<<<<<++++++++++++++++++++++>>>>>]<<<<<++++++<[->>>>>>+
+<<<<<-<]>>>>>>[-<<<<<<+>>>>>>]<<<>-]>[-<<<<[->>>>>>+<<<<<+<]>>>>>>[-<<<<<<+>>>>>
+>]+++++++++++++++++++++++[-<<<<<---------------------->>>>>]<<<<<------>>>>]<<<<
+[->>>>+<+<<<]>>>>[-<<<<+>>>>]<[-<<<[->>>>+<<+<<]>>>>[-<<<<+>>>>]<]<[->>>>>>>>+<<
+<<<<+<<]>>>>>>>>[-<<<<<<<<+>>>>>>>>]++++++[-<<<<<+++++>>>>>]<<<<<++<[->-[>+>>]>[
++[-<+>]>+>>]<<<<<]>[-]>[-]>[-<<<<<<+>>>>>>]<<<<<[-]<<<[-]>[-]<<<<<<<<<<<<[-]>>>>
+>>>>>>>>>[-<<<<<<<<<<<<<+>>>>>>>>>>>>>]<<<<<<<[->>>>>>>>+<<<<<<<<<<<<<<->>>>>>]>
+>>>>>>>[-<<<<<<<<+>>>>>>>>]<<<<<<<[->>>>>>>+<<<<<<<<<<<<<<->>>>>>>]>>>>>>>[-<<<<
+<<<+>>>>>>>]<<<<<<<<<<<<<<<<[->>>>>>>>>>>>>>>>+<<<<<<<<<<<<<<+<<]>>>>>>>>>>>>>>>
+>[-<<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>>]<<<<<<<<<<<<<<<[-]>>>>>>>[->>>>>>>>+<<<<<<<
+<<<<<<<<+>>>>>>>]>>>>>>>>[-<<<<<<<<+>>>>>>>>]<<<<<<<[->>>>>>>+<<<<<<<<<<<<<<<->>
+>>>>>>]>>>>>>>[-<<<<<<<+>>>>>>>]<<<<<<<<<<<<<<<<<[->>>>>>>>>>>>>>>>>+<<<<<<<<<<<
+<<<<+<<]>>>>>>>>>>>>>>>>>[-<<<<<<<<<<<<<<<<<+>>>>>>>>>>>>>>>>>]<<<<<<<<<<<<->+<[
+>-]>[->>[-]<<>]>>>>>>]<<<<[-]>[-]<<]<<<<[->>>>>>>>+<<<+<<<<<]>>>>>>>>[-<<<<<<<<+
+>>>>>>>>]<<+<[[-]>>>>>>>++++++++[-<<<<++++++>>>>]<<<<<<<<<<<[->>>>>>>>>>>+<<<<-<
+<<<<<<]>>>>>>>>>>>[-<<<<<<<<<<<+>>>>>>>>>>>]<+<<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<
+[>>++++++[-<+++++>]<++.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>+++
+++++[-<++++++>]<++++.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>+++++
++++[-<+++++++>]<++.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>+++++++
+[-<++++++>]<+++.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>++++++++[-
+<+++++++>]<+++++.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>+++++++[-
+<++++++>]<+.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>+++++++[-<++++
+++>]<.[-]<<[-]>[-]]<<<>]<+<[->-]>[->>[->>+<+<]>>[-<<+>>]<[>>++++++[-<++++++>]<+.
+[-]<<[-]>[-]]<<<>]>[->>+<+<]>>[-<<+>>]<[>>+++++++[-<+++++>]<.[-]<[-]]<[-]<<<[-]<
+<<>-]>[->>>++++++++[-<++++++++>]<.[-]<<>]<<<<<<<[-]>[-]<<<<<+<]>>>>>>>>>>+++++++
++++.[-]<<<<<<<<++<<<]
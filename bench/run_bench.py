@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""
+Benchmark bfc on the programs of the corpus in every execution mode and optimization level
+Usage: python run_bench.py --bfc <path> [--output results.json] [--baseline old.json]
+
+Per program, mode and level the harness records the compile time, the size of the executable
+(AOT only), the run time and whether the output matches the manifest. Startup time is measured
+on an empty program. Times are the median of the repeated runs. With a baseline the results are
+compared with an earlier run, and the script exits with status 1 if anything got slower than
+the threshold allows or produced wrong output.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+PROGRAM_DIR = os.path.join(SCRIPT_DIR, "programs")
+
+MODES = {
+    "aot": ["-o"],  # The executable name is appended
+    "jit": ["-j"],
+    "interpreter": ["-t", "--tier-threshold", "0"],
+    "tiered": ["-t"],
+    "fast-aot": ["--backend=fast", "-o"],
+    "fast-jit": ["--backend=fast", "-j"],
+}
+OPT_LEVELS = ["O0", "O1", "O2", "O3", "Os"]
+METRICS = ["compile_s", "startup_s", "run_s"]
+
+# Phases of --time-report that execute the program rather than compile it
+EXECUTION_PHASES = {"JIT compilation and execution", "JIT execution", "Tiered execution", "Loop compilation"}
+EXECUTION_END_LINES = (b"JIT execution completed", b"Tiered execution completed")
+
+
+def parse_arguments():
+    parser = argparse.ArgumentParser(description="Benchmark bfc on the program corpus")
+    parser.add_argument("--bfc", required=True, help="path of the bfc executable")
+    parser.add_argument("--output", help="JSON results file (default: print only)")
+    parser.add_argument("--baseline", help="earlier results to compare with")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent (default: 10)")
+    parser.add_argument("--repeat", type=int, default=3, help="runs per measurement (default: 3)")
+    parser.add_argument("--timeout", type=float, default=300.0, help="seconds per run (default: 300)")
+    parser.add_argument("--programs", help="comma separated program names (default: all)")
+    parser.add_argument("--modes", default=",".join(MODES), help="comma separated modes (default: all)")
+    parser.add_argument("--opt-levels", default=",".join(OPT_LEVELS), help="comma separated levels (default: all)")
+    args = parser.parse_args()
+
+    args.modes = args.modes.split(",")
+    args.opt_levels = args.opt_levels.split(",")
+    for mode in args.modes:
+        if mode not in MODES:
+            parser.error(f"unknown mode {mode}, expected one of {', '.join(MODES)}")
+    for level in args.opt_levels:
+        if level not in OPT_LEVELS:
+            parser.error(f"unknown optimization level {level}, expected one of {', '.join(OPT_LEVELS)}")
+    return args
+
+
+def load_manifest(names):
+    with open(os.path.join(PROGRAM_DIR, "manifest.json")) as f:
+        programs = json.load(f)["programs"]
+    if names:
+        wanted = names.split(",")
+        unknown = set(wanted) - {program["name"] for program in programs}
+        if unknown:
+            sys.exit(f"Unknown programs: {', '.join(sorted(unknown))}")
+        programs = [program for program in programs if program["name"] in wanted]
+    return programs
+
+
+def run(command, stdin_data, timeout):
+    """Run a command, returning its wall time, stdout and stderr"""
+    start = time.perf_counter()
+    result = subprocess.run(command, input=stdin_data, capture_output=True, timeout=timeout)
+    elapsed = time.perf_counter() - start
+    if result.returncode != 0:
+        message = result.stderr.decode(errors="replace").strip().splitlines()
+        raise RuntimeError(f"{' '.join(command)} exited with {result.returncode}: {message[-1] if message else ''}")
+    return elapsed, result.stdout, result.stderr
+
+
+def program_output(stdout):
+    """Output of an in-process run, between bfc's execution mode line and its completion line"""
+    start = stdout.index(b"Execution mode: ")
+    start = stdout.index(b"\n", start) + 1
+    end = max(stdout.rfind(line) for line in EXECUTION_END_LINES)
+    return stdout[start:end] if end >= start else stdout[start:]
+
+
+def compile_seconds(stderr):
+    """Compile time from the JSON time report, the phases that run the program excluded"""
+    report = json.loads(stderr[stderr.index(b"{") :])
+    return sum(phase["wall_ms"] for phase in report["phases"] if phase["name"] not in EXECUTION_PHASES) / 1000.0
+
+
+class Measurement:
+    """Repeated runs of one program in one mode at one optimization level"""
+
+    def __init__(self, args, program, mode, level, workdir):
+        self.args = args
+        self.mode = mode
+        self.workdir = workdir
+        self.source = os.path.join(PROGRAM_DIR, program["source"])
+        self.expected_sha256 = program["output_sha256"]
+        self.stdin_data = b""
+        if "input" in program:
+            with open(os.path.join(PROGRAM_DIR, program["input"]), "rb") as f:
+                self.stdin_data = f.read()
+
+        self.options = ["-" + level, "--cell-bits", str(program["cell_bits"])]
+        if "memory" in program:
+            self.options += ["-m", str(program["memory"])]
+
+    def bfc(self, source, extra):
+        return [self.args.bfc, "-i", source] + self.options + extra
+
+    def once(self, source, stdin_data):
+        """One compile and run, returning compile seconds, run seconds, output and binary size"""
+        if MODES[self.mode][-1] == "-o":
+            executable = os.path.join(self.workdir, "program" + (".exe" if os.name == "nt" else ""))
+            compile_time, _, _ = run(self.bfc(source, MODES[self.mode] + [executable]), b"", self.args.timeout)
+            run_time, output, _ = run([executable], stdin_data, self.args.timeout)
+            return compile_time, run_time, output, os.path.getsize(executable)
+
+        total, stdout, stderr = run(self.bfc(source, MODES[self.mode] + ["--time-report=json"]), stdin_data,
+                                    self.args.timeout)
+        compile_time = compile_seconds(stderr)
+        return compile_time, max(total - compile_time, 0.0), program_output(stdout), None
+
+    def measure(self, empty_source):
+        compile_times, run_times, startup_times = [], [], []
+        output = b""
+        binary_bytes = None
+        for _ in range(self.args.repeat):
+            compile_time, run_time, output, binary_bytes = self.once(self.source, self.stdin_data)
+            compile_times.append(compile_time)
+            run_times.append(run_time)
+            startup_times.append(self.once(empty_source, b"")[1])
+
+        result = {
+            "compile_s": statistics.median(compile_times),
+            "startup_s": statistics.median(startup_times),
+            "run_s": statistics.median(run_times),
+            "output_ok": hashlib.sha256(output).hexdigest() == self.expected_sha256,
+        }
+        if binary_bytes is not None:
+            result["binary_bytes"] = binary_bytes
+        return result
+
+
+def source_revision():
+    """Commit of the source tree, bfc has no version option"""
+    try:
+        result = subprocess.run(["git", "-C", SCRIPT_DIR, "rev-parse", "HEAD"], capture_output=True, timeout=30)
+        return result.stdout.decode().strip()
+    except (OSError, subprocess.SubprocessError):
+        return ""
+
+
+def run_benchmarks(args, programs):
+    results = []
+    with tempfile.TemporaryDirectory(prefix="bfc-bench-") as workdir:
+        empty_source = os.path.join(workdir, "empty.bf")
+        with open(empty_source, "w") as f:
+            f.write("\n")
+
+        for program in programs:
+            for mode in args.modes:
+                for level in args.opt_levels:
+                    measurement = Measurement(args, program, mode, level, workdir)
+                    entry = {"program": program["name"], "mode": mode, "opt_level": level}
+                    try:
+                        entry.update(measurement.measure(empty_source))
+                    except (RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+                        entry["error"] = str(e)
+                    results.append(entry)
+                    print_result(entry)
+    return results
+
+
+def print_result(entry):
+    name = f"{entry['program']:<12} {entry['mode']:<12} {entry['opt_level']:<3}"
+    if "error" in entry:
+        print(f"{name}  error: {entry['error']}", flush=True)
+        return
+    size = f"{entry['binary_bytes']:>10}" if "binary_bytes" in entry else f"{'-':>10}"
+    check = "ok" if entry["output_ok"] else "WRONG OUTPUT"
+    print(
+        f"{name}  compile {entry['compile_s']:8.3f}s  startup {entry['startup_s']:7.3f}s  "
+        f"run {entry['run_s']:8.3f}s  size {size}  {check}",
+        flush=True,
+    )
+
+
+def compare(results, baseline_file, threshold):
+    """Report the measurements that got slower or bigger than the baseline allows, return their count"""
+    with open(baseline_file) as f:
+        baseline = {(e["program"], e["mode"], e["opt_level"]): e for e in json.load(f)["results"]}
+
+    regressions = 0
+    limit = 1.0 + threshold / 100.0
+    print(f"\nComparison with {baseline_file} (threshold {threshold:g}%):")
+    for entry in results:
+        key = (entry["program"], entry["mode"], entry["opt_level"])
+        old = baseline.get(key)
+        if old is None or "error" in old:
+            continue
+        name = " ".join(key)
+        if "error" in entry or not entry["output_ok"]:
+            print(f"  {name}: {entry.get('error', 'wrong output')}")
+            regressions += 1
+            continue
+        for metric in METRICS + ["binary_bytes"]:
+            if metric not in entry or metric not in old:
+                continue
+            # Times below a millisecond are noise
+            noise = 0 if metric == "binary_bytes" else 0.001
+            if entry[metric] > old[metric] * limit and entry[metric] - old[metric] > noise:
+                change = 100.0 * (entry[metric] - old[metric]) / old[metric] if old[metric] else float("inf")
+                print(f"  {name}: {metric} {old[metric]:g} -> {entry[metric]:g} (+{change:.1f}%)")
+                regressions += 1
+
+    if regressions == 0:
+        print("  no regressions")
+    return regressions
+
+
+def main():
+    args = parse_arguments()
+    programs = load_manifest(args.programs)
+    results = run_benchmarks(args, programs)
+
+    report = {
+        "bfc": args.bfc,
+        "revision": source_revision(),
+        "host": platform.platform(),
+        "repeat": args.repeat,
+        "results": results,
+    }
+    if args.output:
+        with open(args.output, "w", newline="\n") as f:
+            json.dump(report, f, indent=2)
+            f.write("\n")
+        print(f"\nResults written to {args.output}")
+
+    failed = sum("error" in entry or not entry["output_ok"] for entry in results)
+    if args.baseline and compare(results, args.baseline, args.threshold) > 0:
+        return 1
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
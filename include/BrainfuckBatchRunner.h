@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BrainfuckCompiledProgram.h"
+
+/**
+ * @class BrainfuckBatchRunner
+ * @brief Runs one compiled program on many input files in parallel
+ *
+ * Inputs are split between worker threads up front in contiguous ranges. A worker takes inputs
+ * from the front of its own queue, and once it runs out it steals from the back of the other
+ * queues, so uneven run times still keep every thread busy. Each worker maps one tape and keeps
+ * one input and one output buffer for all of its runs.
+ */
+class BrainfuckBatchRunner {
+public:
+    /**
+     * @brief Totals of one batch
+     */
+    struct Summary {
+        std::size_t runs = 0; // Inputs processed
+        std::size_t failures = 0; // Inputs that could not be read or written, or whose run failed
+        std::uint64_t outputBytes = 0; // Output of all runs
+    };
+
+    /**
+     * @brief Constructor
+     * @param program Compiled program, must outlive the runner
+     * @param threads Number of worker threads, 0 uses one per hardware thread
+     */
+    BrainfuckBatchRunner(const BrainfuckCompiledProgram& program, unsigned threads);
+
+    /**
+     * @brief Run the program once per input file
+     *
+     * Failures are reported on stderr and do not stop the batch.
+     * @param inputFiles Input filenames
+     * @param outputDirectory Directory receiving the output of each input under the input's filename,
+     *        empty discards the output
+     * @return Batch totals
+     */
+    Summary run(const std::vector<std::string>& inputFiles, std::string_view outputDirectory);
+
+private:
+    // Queue of input indices of one worker, the owner pops the front and thieves the back
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::size_t> inputs;
+    };
+
+    void workerMain(std::size_t worker, Summary& summary);
+    bool nextInput(std::size_t worker, std::size_t& input);
+    bool runInput(const std::string& inputFile, std::uint8_t* tape, std::vector<std::uint8_t>& input,
+                  std::string& output, Summary& summary);
+    void reportError(std::string_view message);
+
+    const BrainfuckCompiledProgram& m_program; // Program run on every input
+    unsigned m_threadCount; // Number of worker threads
+    std::vector<std::unique_ptr<WorkQueue>> m_queues; // One queue per worker
+
+    // State of the current batch
+    const std::vector<std::string>* m_inputFiles = nullptr;
+    std::string m_outputDirectory;
+    std::mutex m_reportMutex; // Serializes error reports
+};
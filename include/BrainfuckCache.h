@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+/**
+ * @class BrainfuckCache
+ * @brief Content-addressed on-disk cache of compiled programs
+ *
+ * Entries are named by a program key, a hash of the optimized Brainfuck IR and of every option
+ * that changes the generated code (see BrainfuckCompiler). Executables are stored whole, so a hit
+ * skips LLVM entirely. JIT-compiled modules are stored as object files through ORC's ObjectCache
+ * interface, where a hit skips IR optimization and code generation of that module.
+ *
+ * Entries are written to a temporary file and renamed into place, so concurrent compilers sharing
+ * a cache directory never see partial entries. Failing to write an entry is not an error.
+ */
+class BrainfuckCache : public llvm::ObjectCache {
+public:
+    /**
+     * @brief Constructor
+     * @param directory Cache directory, created when the first entry is stored
+     */
+    explicit BrainfuckCache(std::string_view directory);
+
+    /**
+     * @brief Select the program whose entries are looked up and stored
+     * @param key Program key, a hex string
+     */
+    void setProgramKey(std::string key) {
+        m_programKey = std::move(key);
+    }
+
+    /**
+     * @brief Copy the cached executable of the current program
+     * @param outputFile Executable filename
+     * @return Returns true on a cache hit
+     */
+    bool loadExecutable(std::string_view outputFile) const;
+
+    /**
+     * @brief Store the executable of the current program
+     * @param executableFile Executable filename
+     */
+    void storeExecutable(std::string_view executableFile) const;
+
+    /**
+     * @brief Whether an object file of a JIT module of the current program is cached
+     */
+    bool hasObject(const llvm::Module& module) const;
+
+    /**
+     * @brief Store the object file of a JIT module, called by the ORC compile layer
+     */
+    void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+
+    /**
+     * @brief Load the object file of a JIT module, called by the ORC compile layer
+     * @return Object file, or nullptr on a cache miss
+     */
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* module) override;
+
+private:
+    std::string executablePath() const;
+    std::string objectPath(const llvm::Module& module) const;
+    void storeFile(const std::string& path, llvm::StringRef contents, bool executable) const;
+
+    std::string m_directory; // Cache directory
+    std::string m_programKey; // Key of the current program
+};
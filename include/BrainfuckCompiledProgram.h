@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLFunctionalExtras.h>
+#include "BrainfuckRuntime.h"
+
+namespace llvm::orc {
+class LLJIT;
+}
+
+/**
+ * @class BrainfuckCompiledProgram
+ * @brief Program compiled to native code once and run any number of times
+ *
+ * Created by BrainfuckCompiler::compileProgram. The program's code owns no global state: every
+ * run reads its input from a caller buffer, hands its output to a caller sink and works on a
+ * caller tape, so one compiled program can serve many runs, also concurrently on different
+ * threads. The handle owns the JIT holding the code and does not depend on the compiler.
+ */
+class BrainfuckCompiledProgram {
+public:
+    /**
+     * @brief Entry point of the generated code, returns the program status
+     */
+    using EntryFunction = int (*)(bf_io* io, std::uint8_t* tape);
+
+    /**
+     * @brief Receives consecutive pieces of the program output
+     */
+    using OutputSink = llvm::function_ref<void(llvm::ArrayRef<std::uint8_t> data)>;
+
+    /**
+     * @brief Outcome of one run
+     */
+    struct RunResult {
+        int status = 0; // 0 on success, 1 after an access out of bounds or when the tape cannot be allocated
+        bool boundsError = false; // Whether the run stopped at an access out of bounds
+        std::int64_t errorCell = 0; // Cell index of that access
+        std::size_t errorSourcePos = 0; // Source position of that access
+    };
+
+    /**
+     * @brief Constructor, used by BrainfuckCompiler
+     * @param jit JIT holding the generated code
+     * @param entry Entry point inside the JIT
+     * @param tapeSize Tape size in bytes
+     * @param tapeAlignment Required tape alignment in bytes
+     */
+    BrainfuckCompiledProgram(std::unique_ptr<llvm::orc::LLJIT> jit, EntryFunction entry, std::size_t tapeSize,
+                             std::size_t tapeAlignment);
+
+    /**
+     * @brief Destructor, releases the generated code
+     */
+    ~BrainfuckCompiledProgram();
+
+    BrainfuckCompiledProgram(const BrainfuckCompiledProgram&) = delete;
+    BrainfuckCompiledProgram& operator=(const BrainfuckCompiledProgram&) = delete;
+
+    /**
+     * @brief Run the program
+     * @param input Input bytes, end of input reads as 255
+     * @param output Receives the output, at the latest when the run ends
+     * @param tape Tape of tapeSize() bytes aligned to tapeAlignment(), all zero on every call: code is compiled
+     *        for a program starting on a zero tape. Runs cannot be continued. nullptr runs on a fresh zero tape.
+     * @return Run outcome
+     */
+    RunResult run(llvm::ArrayRef<std::uint8_t> input, OutputSink output, std::uint8_t* tape = nullptr) const;
+
+    /**
+     * @brief Get the size in bytes of the tapes passed to run()
+     */
+    std::size_t tapeSize() const {
+        return m_tapeSize;
+    }
+
+    /**
+     * @brief Get the alignment in bytes of the tapes passed to run()
+     */
+    std::size_t tapeAlignment() const {
+        return m_tapeAlignment;
+    }
+
+private:
+    std::unique_ptr<llvm::orc::LLJIT> m_jit; // JIT holding the generated code
+    EntryFunction m_entry; // Entry point
+    std::size_t m_tapeSize; // Tape size in bytes
+    std::size_t m_tapeAlignment; // Tape alignment in bytes
+};
@@ -1,18 +1,33 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <stack>
-#include <map>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Target/TargetMachine.h>
+#include "BrainfuckCache.h"
+#include "BrainfuckCompiledProgram.h"
+#include "BrainfuckIR.h"
+#include "BrainfuckInterpreter.h"
+#include "BrainfuckProfile.h"
+#include "BrainfuckTimeReport.h"
 
 /**
  * @class BrainfuckCompiler
@@ -23,21 +38,84 @@
  * - LLVM IR generation
  * - Optimization support
  * - JIT execution
+ * - Library interface: programs compiled once and run on caller buffers
+ * - Bundles: many programs in one executable or shared object with a shared runtime
  * - Debug information generation
+ * - On-disk caching of executables and JIT-compiled objects
+ * - Phase, pass and memory reports
+ * - Loop execution profiles of compiled programs, and optimization guided by them
+ *
+ * One compiler compiles any number of programs, each into a fresh module. The LLVM context, the
+ * target machine and the optimization pipeline are set up on first use and shared by the later
+ * compilations, so long-lived processes pay for them once. A compiler is used by one thread at a time.
  */
 class BrainfuckCompiler {
 public:
+    /**
+     * @brief Optimization level, used for both the IR pipeline and code generation
+     */
+    enum class OptLevel {
+        O0, // No optimization
+        O1, // -O1 pipeline
+        O2, // -O2 pipeline
+        O3, // -O3 pipeline, aggressive code generation
+        Os, // -Os pipeline, optimize for size
+    };
+
+    /**
+     * @brief Storage of the tape in generated code
+     */
+    enum class TapeStorage {
+        Stack, // Stack array, cleared with memset on entry
+        Static, // Zero-initialized global in .bss
+        Mmap, // Anonymous zero-page mapping, untouched pages cost nothing
+        Grow, // Inaccessible mapping, pages are committed on first access by a fault handler
+    };
+
+    /**
+     * @brief Protection against tape accesses out of bounds
+     */
+    enum class BoundsMode {
+        None, // Unchecked accesses
+        Guard, // Inaccessible guard regions around a mapped tape, faults are reported by a signal handler
+        Check, // Explicit compare and branch on every access
+    };
+
+    /**
+     * @brief Code generator of executables and JIT mode
+     */
+    enum class Backend {
+        LLVM, // LLVM IR, optimization pipeline and code generation
+        Fast, // Single-pass lowering of the Brainfuck IR to machine code, see BrainfuckFastBackend
+    };
+
+    /**
+     * @brief Output of a bundle of programs, see compileBundle
+     */
+    enum class BundleKind {
+        Executable, // One executable running the program named by its command name or first argument
+        SharedLibrary, // Shared object exporting an entry point per program
+    };
+
+    /**
+     * @brief Program of a bundle
+     */
+    struct BundleProgram {
+        std::string name; // Command name, and the suffix of the entry point in shared objects
+        std::string_view source; // Source code
+    };
+
     /**
      * @brief Constructor
      * @param memorySize Memory size (default 30000 cells)
+     * @param optLevel Optimization level
      */
-    BrainfuckCompiler(std::size_t memorySize, bool enableOptimization)
+    BrainfuckCompiler(std::size_t memorySize, OptLevel optLevel)
         : m_memorySize(memorySize),
-          m_enableOptimization(enableOptimization),
+          m_optLevel(optLevel),
           m_enableDebugInfo(false),
           m_currentIP(0) {
-        // Initialize LLVM
-        initializeLLVM();
+        // Targets are initialized on first use and modules on each compilation, cache hits never need them
     }
 
     /**
@@ -54,6 +132,51 @@ public:
      */
     bool compile(std::string_view source, std::string_view outputFile, bool enableJIT = false);
 
+    /**
+     * @brief Compile several programs into one module and link them into one output
+     *
+     * The programs share one copy of the runtime and are linked once. Executables dispatch busybox style:
+     * the program named by the basename of `argv[0]` runs, otherwise the program named by `argv[1]`.
+     * Shared objects export `int bf_main_<name>(void)` per program, with characters other than letters,
+     * digits and underscores of the name replaced by underscores. Each program keeps a tape of its own.
+     * Entry points of shared objects may be called repeatedly, one call at a time: static tapes are
+     * cleared on entry, and mapped tapes and guard mode are rejected since nothing would unmap the tape
+     * or remove the fault handler from the host. Only the LLVM backend builds bundles, without debug
+     * info, profiling or freestanding builds.
+     * @param programs Programs, with names distinct after the replacement
+     * @param outputFile Output filename
+     * @param kind Executable or shared object
+     * @return Returns true if compilation successful
+     */
+    bool compileBundle(const std::vector<BundleProgram>& programs, std::string_view outputFile, BundleKind kind);
+
+    /**
+     * @brief Execute Brainfuck source code with the tiered interpreter
+     * @param source Source code string
+     * @param tierThreshold Loop iterations before a loop is compiled to native code, 0 only interprets
+     * @return Returns true if execution successful
+     */
+    bool interpret(std::string_view source, std::size_t tierThreshold);
+
+    /**
+     * @brief Compile Brainfuck source code for the library interface
+     *
+     * The program is compiled to native code in memory. Its I/O and tape are arguments of each
+     * run instead of process state, see BrainfuckCompiledProgram. Guard mode and freestanding
+     * builds are not available, accesses out of bounds in check mode end the run with status 1.
+     * @param source Source code string
+     * @return Compiled program, or nullptr if compilation failed
+     */
+    std::unique_ptr<BrainfuckCompiledProgram> compileProgram(std::string_view source);
+
+    /**
+     * @brief Compile one loop of a program to native code, used by the tiered interpreter
+     * @param program Brainfuck IR
+     * @param loopStart Index of the LoopStart operation
+     * @return Native loop function, or nullptr if compilation failed
+     */
+    BrainfuckInterpreter::LoopFunction compileLoop(const BrainfuckProgram& program, std::size_t loopStart);
+
     /**
      * @brief Enable/disable debug information
      * @param enable Whether to enable debug information
@@ -62,41 +185,237 @@ public:
         m_enableDebugInfo = enable;
     }
 
+    /**
+     * @brief Set how many IR operations of the input-free program prefix are evaluated at compile time
+     * @param steps Step budget, 0 disables prefix evaluation
+     */
+    void setPrefixStepBudget(std::size_t steps) {
+        m_prefixStepBudget = steps;
+    }
+
+    /**
+     * @brief Set the cell width
+     * @param bits Cell width in bits: 8, 16, 32 or 64
+     */
+    void setCellBits(unsigned bits) {
+        m_cellBits = bits;
+    }
+
+    /**
+     * @brief Select where generated code keeps the tape
+     * @param storage Tape storage
+     */
+    void setTapeStorage(TapeStorage storage) {
+        m_tapeStorage = storage;
+    }
+
+    /**
+     * @brief Select how tape accesses out of bounds are caught
+     * @param mode Bounds mode
+     */
+    void setBoundsMode(BoundsMode mode) {
+        m_boundsMode = mode;
+    }
+
+    /**
+     * @brief Select the code generator of executables and JIT mode
+     *
+     * The fast backend skips LLVM entirely for quick edit-run cycles: the optimization level and a loop
+     * profile have no effect, and bounds checks, debug info, profiling and freestanding builds are not
+     * available. Executables need an ELF target and static tape storage. Tiered execution and the
+     * library interface always use LLVM.
+     * @param backend Code generator
+     */
+    void setBackend(Backend backend) {
+        m_backend = backend;
+    }
+
+    /**
+     * @brief Select the target CPU and features
+     * @param cpu CPU name, "native" selects the host CPU and, unless features are given, its features
+     * @param features Comma separated feature list such as "+avx2,-avx512f", "native" selects the host features
+     */
+    void setTargetCPU(std::string_view cpu, std::string_view features);
+
+    /**
+     * @brief Select the target triple of generated executables
+     *
+     * Only the host target is initialized by default, other targets are registered when they are
+     * first requested. JIT, tiered and library compilation always run on the host.
+     * @param triple Target triple such as "aarch64-linux-gnu", empty selects the host
+     */
+    void setTargetTriple(std::string_view triple);
+
+    /**
+     * @brief Build executables without the C library
+     *
+     * The executable gets its own `_start`, performs I/O, tape mapping and exit through raw system
+     * calls and is linked statically. Supported on Linux for x86-64 and AArch64.
+     * @param enable Whether to build freestanding executables
+     */
+    void setFreestanding(bool enable) {
+        m_freestanding = enable;
+    }
+
+    /**
+     * @brief Set how many threads optimize and generate code of executables
+     *
+     * With more than one thread, top-level loops are outlined into functions, and the functions are
+     * divided into partitions of similar size that are compiled in parallel and linked together.
+     * @param threads Number of threads, 1 compiles the program as one module
+     */
+    void setCompileThreads(unsigned threads) {
+        m_compileThreads = std::max(threads, 1u);
+    }
+
+    /**
+     * @brief Enable the on-disk compile cache
+     * @param directory Cache directory, empty disables the cache
+     */
+    void setCacheDirectory(std::string_view directory);
+
+    /**
+     * @brief Attach a report receiving phase times, pass times and IR sizes
+     * @param report Report to fill, must outlive the compilations, nullptr disables reporting
+     */
+    void setTimeReport(BrainfuckTimeReport* report) {
+        m_timeReport = report;
+    }
+
+    /**
+     * @brief Instrument executables and JIT-compiled programs with loop counters
+     *
+     * Instrumented programs count the entries and iterations of every loop and write the counts to
+     * the profile file when they end normally, see BrainfuckProfile. Relative paths are resolved when
+     * the program runs. Prefix evaluation is skipped, so the profile covers every loop. Tiered
+     * execution and the library interface cannot be profiled.
+     * @param file Profile filename, empty disables profiling
+     */
+    void setProfileFile(std::string_view file) {
+        m_profileFile = std::string(file);
+    }
+
+    /**
+     * @brief Read a loop profile that guides optimization
+     *
+     * Loop branches get the profiled branch weights, from which the optimizer estimates the trip
+     * counts it unrolls, peels and vectorizes by, and functions the profiled entry counts. Loops
+     * whose body never ran are kept from unrolling and vectorization and, in executables, moved out
+     * of main into cold functions. A profile of a different source is ignored with a warning when
+     * the program is compiled.
+     * @param file Profile filename written by a program built with setProfileFile
+     * @return Returns true if the profile was read
+     */
+    bool loadProfile(std::string_view file);
+
     /**
      * @brief Get compilation statistics
-     * @return Map containing instruction usage counts
+     * @return Instruction usage counts of the last compiled source
      */
-    std::map<char, std::size_t> getStatistics() const {
+    const BrainfuckStatistics& getStatistics() const {
         return m_statistics;
     }
 
 private:
     // LLVM initialization
     void initializeLLVM();
+    const llvm::Target* lookupTarget(std::string& error);
+    bool checkHostTarget(std::string_view mode);
+    bool checkNotProfiling(std::string_view mode);
+    void createModule();
+
+    // Front end: parsing and Brainfuck IR passes
+    std::optional<BrainfuckProgram> buildProgram(std::string_view source);
+
+    // Fast backend: executables and JIT mode without LLVM code generation
+    bool compileFast(const BrainfuckProgram& program, std::string_view outputFile, bool enableJIT);
+
+    // Compile cache: key of a program in one execution mode, and the JIT compiler that uses the cache
+    std::string computeCacheKey(const BrainfuckProgram& program, std::string_view mode);
+    llvm::orc::LLJITBuilderState::CompileFunctionCreator createCachingCompiler();
+    bool isCached(const llvm::Module& module) const;
 
     // IR generation main function
-    void generateIR(std::string_view source);
-
-    // Brainfuck instruction handling functions
-    void handleIncrementPtr(); // > Pointer increment
-    void handleDecrementPtr(); // < Pointer decrement
-    void handleIncrementByte(); // + Byte increment
-    void handleDecrementByte(); // - Byte decrement
-    void handleOutput(); // . Output
-    void handleInput(); // , Input
+    void generateIR(const BrainfuckProgram& program);
+    void generateOps(const BrainfuckProgram& program, std::size_t begin, std::size_t end);
+
+    // Brainfuck IR operation handling functions
+    void handleMovePtr(std::int32_t distance); // > < Pointer movement
+    void handleAddByte(std::int32_t offset, std::int32_t delta); // + - Cell addition
+    void handleOutput(std::int32_t offset); // . Output
+    void handleInput(std::int32_t offset); // , Input
     void handleLoopStart(std::size_t ip); // [ Loop start
     void handleLoopEnd(std::size_t ip); // ] Loop end
+    void handleSetZero(std::int32_t offset); // [-] Clear loop
+    void handleMulAdd(std::int32_t srcOffset, std::int32_t offset, std::int32_t factor); // [->+<] Copy/multiply loop
+    void handleWrite(std::string_view text); // ... Constant output
+    void handleScan(std::int32_t stride); // [>] [<] Zero cell search, negative strides scan left
+
+    // Scan lowering
+    void emitScanLoop(std::int32_t stride);
+    void emitVectorScan(std::int32_t stride);
+
+    // Loop outlining for lazy JIT compilation
+    void beginOutlinedLoop(std::size_t ip);
+    void endOutlinedLoop();
+
+    // Address of the cell `offset` cells away from the data pointer
+    llvm::Value* getCellPtr(std::int32_t offset);
+
+    // Cell type of the configured width, and constants of it wrapped to that width
+    llvm::IntegerType* getCellType();
+    llvm::ConstantInt* getCellConstant(std::int64_t value);
+    llvm::Constant* createTapeImage(const std::vector<std::uint64_t>& cells);
 
     // Helper functions
     void createMainFunction();
-    void allocateMemory();
+    void defineBundleMain(const std::vector<BundleProgram>& programs, const std::vector<llvm::Function*>& entries);
+    bool allocateMemory(const BrainfuckProgram& program);
+    void initializeDataPointer(const BrainfuckProgram& program);
     void setupRuntimeFunctions();
-    void optimizeModule();
-    void emitObjectFile(std::string_view outputFile);
+    llvm::CallInst* callRuntime(llvm::Function* function, llvm::ArrayRef<llvm::Value*> args = {},
+                                const llvm::Twine& name = "");
+    void defineRuntimeFunctions();
+    void defineTapeFunctions();
+    void setupBoundsFunctions();
+    void defineBoundsFunctions();
+    void emitBoundsCheck(llvm::Value* cellPtr);
+    bool setupProfile(const BrainfuckProgram& program);
+    void defineProfileFunctions();
+    void emitProfileCount(std::size_t word);
+    llvm::MDNode* createLoopMetadata(const BrainfuckProfile::Loop& loop);
+    void setProfileSummary();
+    llvm::FunctionCallee getSystemFunction(llvm::StringRef name, llvm::FunctionType* type);
+
+    // Freestanding executables: system call replacements of the C library, entry point and memory functions
+    bool checkFreestandingTarget();
+    void defineSystemFunction(llvm::Function* function, llvm::StringRef name);
+    llvm::Value* emitSyscall(llvm::IRBuilder<>& builder, unsigned number, llvm::ArrayRef<llvm::Value*> args);
+    void defineStartFunction();
+    void defineMemoryFunctions();
+    void recordSourcePos(std::size_t ip);
+    llvm::Type* getSizeType();
+    bool verifyModule();
+    bool createTargetMachine();
+    std::unique_ptr<llvm::TargetMachine> buildTargetMachine();
+    void optimizeModule(llvm::Module& module, llvm::TargetMachine* targetMachine = nullptr);
+    bool emitObjectFile(std::string_view outputFile);
+    bool generateObject(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::SmallVectorImpl<char>& object);
+
+    // Parallel code generation: partitions of the outlined program, each compiled on its own thread
+    std::vector<llvm::SmallVector<char, 0>> splitModule(unsigned partitions);
+    bool compilePartitions(std::vector<llvm::SmallVector<char, 0>>& objects);
+
+    bool linkExecutable(llvm::ArrayRef<llvm::StringRef> objects, const std::string& executableFile);
+    bool getLinkArgs(const std::vector<std::string>& objectFiles, std::vector<std::string>& args);
+    std::optional<bool> linkInProcess(llvm::ArrayRef<llvm::StringRef> objects, const std::string& executableFile);
+    bool linkWithDriver(llvm::ArrayRef<llvm::StringRef> objects, const std::string& executableFile);
     void executeJIT();
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> createJITTargetMachineBuilder();
+    bool addRuntimeSymbols(llvm::orc::LLJIT& jit);
+    std::unique_ptr<llvm::orc::LLJIT> createJIT();
 
     // Error handling
-    bool checkBrackets(std::string_view source);
     void reportError(std::string_view message);
 
     // Debug information generation
@@ -104,29 +423,89 @@ private:
     void finalizeDebugInfo();
 
     // Member variables
-    std::size_t m_memorySize; // Memory size
-    bool m_enableOptimization; // Whether optimization is enabled
+    std::size_t m_memorySize; // Memory size in cells
+    OptLevel m_optLevel; // Optimization level
+    Backend m_backend = Backend::LLVM; // Code generator of executables and JIT mode
+    std::string m_targetTriple; // Target triple, empty for the host
+    std::string m_targetCPU = "generic"; // Target CPU name
+    std::string m_targetFeatures; // Target feature string
     bool m_enableDebugInfo; // Whether debug info is enabled
-    std::map<char, std::size_t> m_statistics; // Instruction statistics
+    unsigned m_cellBits = 8; // Cell width in bits
+    std::size_t m_prefixStepBudget = 0; // Operations of the program prefix evaluated at compile time
+    TapeStorage m_tapeStorage = TapeStorage::Static; // Tape storage of generated code
+    BoundsMode m_boundsMode = BoundsMode::None; // Tape bounds protection of generated code
+    std::size_t m_guardSize = 0; // Guard region size in bytes of the current program
+    BrainfuckStatistics m_statistics; // Instruction statistics
+    std::unique_ptr<BrainfuckCache> m_cache; // On-disk compile cache, nullptr if disabled
+    BrainfuckTimeReport* m_timeReport = nullptr; // Phase timing report, nullptr if disabled
+    std::string m_profileFile; // Profile written by instrumented programs, empty if profiling is disabled
+    std::uint64_t m_sourceHash = 0; // Hash of the source of the current program, profiling and profile use only
+    std::optional<BrainfuckProfile> m_profile; // Profile guiding optimization, std::nullopt if none
+
+    // Standard optimization pipeline, built once and run on every module optimized with one target machine
+    struct OptimizationPipeline {
+        OptimizationPipeline(llvm::TargetMachine* targetMachine, OptLevel optLevel, BrainfuckTimeReport* timeReport);
+        void run(llvm::Module& module);
+
+        BrainfuckTimeReport* report; // Report the pass timer was registered for
+        llvm::LoopAnalysisManager lam;
+        llvm::FunctionAnalysisManager fam;
+        llvm::CGSCCAnalysisManager cgam;
+        llvm::ModuleAnalysisManager mam;
+        llvm::PassInstrumentationCallbacks callbacks;
+        BrainfuckTimeReport::PassTimer passTimer;
+        llvm::PassBuilder passBuilder;
+        llvm::ModulePassManager mpm;
+    };
 
-    // LLVM related members
-    std::unique_ptr<llvm::LLVMContext> m_context;
+    // LLVM related members, everything but the module and builders is shared by the compilations of this compiler
+    llvm::orc::ThreadSafeContext m_threadSafeContext; // Owner of the context, shared with the modules handed to JITs
+    llvm::LLVMContext* m_context = nullptr; // Context of the current module
+    unsigned m_contextModules = 0; // Modules created in the current context
     std::unique_ptr<llvm::Module> m_module;
     std::unique_ptr<llvm::IRBuilder<>> m_builder;
     std::unique_ptr<llvm::DIBuilder> m_diBuilder;
+    std::unique_ptr<llvm::TargetMachine> m_targetMachine;
+    std::unique_ptr<OptimizationPipeline> m_pipeline; // Pipeline of m_targetMachine, nullptr until first used
+    std::unique_ptr<llvm::orc::LLJIT> m_loopJIT; // JIT for loops promoted by the tiered interpreter
+    llvm::orc::ResourceTrackerSP m_loopTracker; // Loops of the program being interpreted
 
     // IR values
-    llvm::Value* m_memoryArray; // Memory array
-    llvm::Value* m_dataPtr; // Data pointer
+    llvm::Value* m_memoryArray; // Memory array, the start of the tape
+    llvm::Value* m_dataPtr; // Data pointer, an SSA value at the current insert point
     llvm::Function* m_mainFunction; // Main function
 
-    // Runtime functions
-    llvm::Function* m_putcharFunc; // putchar function
-    llvm::Function* m_getcharFunc; // getchar function
+    // Runtime functions, buffered I/O
+    llvm::Function* m_outputFunc; // bf_output function
+    llvm::Function* m_writeFunc; // bf_write function
+    llvm::Function* m_inputFunc; // bf_input function
+    llvm::Function* m_flushFunc; // bf_flush function
+    llvm::Function* m_tapeAllocFunc = nullptr; // bf_tape_alloc function, mapped tapes only
+    llvm::Function* m_tapeFreeFunc = nullptr; // bf_tape_free function, mapped tapes in JIT mode only
+    std::vector<llvm::Value*> m_tapeFreeArgs; // Arguments of the bf_tape_free call before main returns
+    llvm::Function* m_boundsErrorFunc = nullptr; // bf_bounds_error function, bounds modes only
+    llvm::GlobalVariable* m_sourcePosVar = nullptr; // bf_source_pos variable, guard mode only
+    llvm::GlobalVariable* m_boundsTapeVar = nullptr; // bf_bounds_tape variable, check mode with the host runtime
+    llvm::GlobalVariable* m_profileVar = nullptr; // bf_profile counters, profiling only
+    llvm::Function* m_profileWriteFunc = nullptr; // bf_profile_write function, profiling only
+    std::size_t m_profileLoops = 0; // Loops instrumented so far, the next loop's record number
+    bool m_hostRuntime = false; // Whether the runtime is provided by the host process (JIT modes)
+    llvm::Value* m_ioContext = nullptr; // bf_io argument of the entry point, library interface only
+    bool m_freestanding = false; // Whether executables are built without the C library
+    bool m_linkShared = false; // Whether the output is linked as a shared object instead of an executable
+    unsigned m_compileThreads = 1; // Threads compiling partitions of executables
 
     // Loop handling
-    std::stack<llvm::BasicBlock*> m_loopStartBlocks;
-    std::stack<llvm::BasicBlock*> m_loopEndBlocks;
+    struct LoopFrame {
+        llvm::BasicBlock* header; // Loop condition
+        llvm::BasicBlock* end; // Loop exit
+        llvm::PHINode* ptrPhi; // Data pointer at the loop header
+        llvm::MDNode* loopID; // Loop metadata, nullptr for loops without any
+    };
+    std::vector<LoopFrame> m_loops; // Open loops, innermost last
+    bool m_outlineLoops = false; // Whether top-level loops are outlined into functions
+    bool m_outlineColdLoops = false; // Whether top-level loops that never ran in the profile are outlined
+    llvm::CallInst* m_outlinedLoopCall = nullptr; // Call of the top-level loop being generated
 
     // Source location tracking
     std::size_t m_currentIP; // Current instruction pointer
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class Triple;
+}
+
+class BrainfuckProgram;
+class BrainfuckTimeReport;
+
+/**
+ * @class BrainfuckFastBackend
+ * @brief Baseline code generator that lowers Brainfuck IR straight to x86-64 or AArch64 machine code
+ *
+ * Each IR operation is translated to a fixed instruction sequence in a single pass over the
+ * program, without LLVM IR, optimization or instruction selection. The data pointer lives in a
+ * callee-saved register and cells are addressed by their offset from it. The code either runs in
+ * memory, calling the host's buffered I/O runtime, or is written as a relocatable ELF object that
+ * defines main together with its own copy of that runtime on top of the C library's read and write.
+ * Code runs on the System V x86-64 and AAPCS64 calling conventions.
+ */
+class BrainfuckFastBackend {
+public:
+    /**
+     * @brief Instruction set of the generated code
+     */
+    enum class Arch {
+        X86_64,
+        AArch64,
+    };
+
+    /**
+     * @brief Instruction set of a target triple
+     * @param triple Target triple
+     * @return Architecture, or std::nullopt if the backend cannot generate code for the target
+     */
+    static std::optional<Arch> getArch(const llvm::Triple& triple);
+
+    /**
+     * @brief Constructor
+     * @param arch Instruction set of the generated code
+     * @param memorySize Memory size in cells, the data pointer starts at memorySize / 2
+     * @param timeReport Report receiving the code generation and execution times, nullptr disables reporting
+     */
+    BrainfuckFastBackend(Arch arch, std::size_t memorySize, BrainfuckTimeReport* timeReport = nullptr)
+        : m_arch(arch), m_memorySize(memorySize), m_timeReport(timeReport) {}
+
+    /**
+     * @brief Generate a relocatable ELF object of an executable
+     *
+     * The object defines main and keeps the tape and the I/O buffers in .bss. It needs write, read
+     * and memcpy from the C library.
+     * @param program Brainfuck IR
+     * @param object Receives the object file
+     * @param error Receives the error message if the program cannot be compiled
+     * @return Returns true if the object was generated
+     */
+    bool emitObject(const BrainfuckProgram& program, std::vector<char>& object, std::string& error) const;
+
+    /**
+     * @brief Generate the program in memory and run it on the host
+     *
+     * The architecture must be the host's. Output is flushed when the program ends.
+     * @param program Brainfuck IR
+     * @param tapeFlags bf_tape_alloc flags of the tape
+     * @param error Receives the error message if the program cannot be compiled or run
+     * @return Return value of the program, or std::nullopt on error
+     */
+    std::optional<int> run(const BrainfuckProgram& program, std::uint32_t tapeFlags, std::string& error) const;
+
+private:
+    Arch m_arch; // Instruction set of the generated code
+    std::size_t m_memorySize; // Memory size in cells
+    BrainfuckTimeReport* m_timeReport; // Phase timing report, nullptr if disabled
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Kind of a Brainfuck IR operation
+ */
+enum class BrainfuckOpKind : std::uint8_t {
+    Add, // cell[offset] += value
+    Move, // ptr += value
+    Output, // putchar(cell[offset])
+    Input, // cell[offset] = getchar()
+    LoopStart, // while (cell) {
+    LoopEnd, // }
+    SetZero, // cell[offset] = 0
+    MulAdd, // cell[offset] += cell[srcOffset] * value
+    Write, // write(strings[value])
+    ScanRight, // while (cell) ptr += value
+    ScanLeft, // while (cell) ptr -= value
+};
+
+/**
+ * @brief A single Brainfuck IR operation
+ *
+ * Runs of '+'/'-' and '>'/'<' are folded into one Add/Move operation carrying the net amount.
+ * Cell operations address `offset` cells away from the data pointer, so pointer movement
+ * inside a straight-line block can be deferred to the block exit.
+ * Loop operations store the index of their matching bracket in `match`.
+ */
+struct BrainfuckOp {
+    BrainfuckOpKind kind;
+    std::int32_t value; // Add: delta, Move: distance, MulAdd: factor, Write: string index, Scan: stride
+    std::int32_t offset; // Cell offset relative to the data pointer
+    std::int32_t srcOffset; // MulAdd: loop counter cell offset relative to the data pointer
+    std::size_t match; // LoopStart/LoopEnd: index of the matching loop operation
+    std::size_t sourcePos; // Position of the first source character of this operation
+};
+
+/**
+ * @brief Usage counts of the eight Brainfuck instructions in the source
+ */
+struct BrainfuckStatistics {
+    static constexpr std::string_view instructions = "><+-.,[]"; // Instructions in counts order
+
+    std::array<std::size_t, 8> counts{}; // Usage count of each instruction
+
+    /**
+     * @brief Get the usage count of an instruction, 0 for other characters
+     */
+    std::size_t count(char instruction) const {
+        std::size_t index = instructions.find(instruction);
+        return index == std::string_view::npos ? 0 : counts[index];
+    }
+};
+
+/**
+ * @class BrainfuckProgram
+ * @brief Brainfuck intermediate representation, a flat vector of operations
+ *
+ * The program is built by a single front-end pass over the source code which matches brackets,
+ * strips comments and folds instruction runs before any LLVM IR is generated. No pass emits more
+ * operations than it consumes, so passes compact the vector in place and keep their working
+ * state in flat buffers that are reused for the whole pass.
+ */
+class BrainfuckProgram {
+public:
+    /**
+     * @brief Build the IR from Brainfuck source code
+     * @param source Source code string
+     * @param cellBits Cell width in bits: 8, 16, 32 or 64
+     * @param error Receives the syntax error message if the brackets do not match
+     * @return Returns the IR, or std::nullopt on a syntax error
+     */
+    static std::optional<BrainfuckProgram> parse(std::string_view source, unsigned cellBits, std::string& error);
+
+    /**
+     * @brief Get the cell width in bits, cell arithmetic wraps modulo 2^cellBits
+     */
+    unsigned cellBits() const {
+        return m_cellBits;
+    }
+
+    /**
+     * @brief Get the IR operations
+     */
+    const std::vector<BrainfuckOp>& ops() const {
+        return m_ops;
+    }
+
+    /**
+     * @brief Get the constant strings referenced by Write operations
+     */
+    const std::vector<std::string>& strings() const {
+        return m_strings;
+    }
+
+    /**
+     * @brief Get the initial tape contents left by precomputePrefix, empty if the tape starts zeroed
+     */
+    const std::vector<std::uint64_t>& initialTape() const {
+        return m_initialTape;
+    }
+
+    /**
+     * @brief Get the position of initialTape()[0], relative to the default data pointer position
+     */
+    std::int64_t initialTapeOffset() const {
+        return m_initialTapeOffset;
+    }
+
+    /**
+     * @brief Get the initial data pointer position, relative to the default data pointer position
+     */
+    std::int64_t initialPointer() const {
+        return m_initialPointer;
+    }
+
+    /**
+     * @brief Whether any operation touches the tape, false if the program only writes constant output
+     */
+    bool usesTape() const;
+
+    /**
+     * @brief Upper bound of the distance between two consecutive tape accesses
+     *
+     * An access that leaves the tape lands within this many cells of the tape ends, which
+     * is how far guard regions have to extend.
+     */
+    std::size_t maxAccessStride() const;
+
+    /**
+     * @brief Get source instruction statistics
+     * @return Instruction usage counts before folding
+     */
+    const BrainfuckStatistics& statistics() const {
+        return m_statistics;
+    }
+
+    /**
+     * @brief Replace clear, copy/multiply and scan loops with straight-line operations
+     *
+     * Innermost loops that contain only Add/Move operations, have a net pointer movement of
+     * zero and change the loop counter cell by exactly +1 or -1 per iteration become SetZero and
+     * MulAdd operations. Loops that only move the pointer, such as `[>]` or `[<<]`, become
+     * ScanRight/ScanLeft searches for the next zero cell.
+     */
+    void recognizeLoopIdioms();
+
+    /**
+     * @brief Defer pointer movement to the end of each straight-line block
+     *
+     * Moves between loop boundaries are folded into the offsets of the following cell
+     * operations, and one Move with the net distance is emitted before each loop boundary,
+     * so `>+>+<<` becomes `cell[1] += 1; cell[2] += 1` without any pointer update.
+     */
+    void foldPointerOffsets();
+
+    /**
+     * @brief Merge outputs of cells with known values into constant Write operations
+     *
+     * Cell values are tracked through each straight-line block: all cells are zero at program
+     * start, the loop counter cell is zero after a loop, and Add/SetZero/MulAdd on known cells
+     * stay known. Outputs of known cells are collected into one string, which is written before
+     * the next observable operation (input, output of an unknown cell or a loop boundary).
+     */
+    void foldConstantOutput();
+
+    /**
+     * @brief Evaluate the input-free program prefix at compile time
+     *
+     * Runs the program until the first input, the step budget or a tape access outside the
+     * evaluation window, then rolls back to the last top-level operation. The output produced so
+     * far becomes one constant Write, and the tape state and data pointer are kept as the initial
+     * state of the remaining program. Programs without input that finish within the budget end up
+     * as a single Write.
+     * @param memorySize Memory size, the data pointer starts at memorySize / 2
+     * @param stepBudget Maximum number of operations to evaluate
+     * @return Returns true if a prefix was evaluated
+     */
+    bool precomputePrefix(std::size_t memorySize, std::size_t stepBudget);
+
+private:
+    explicit BrainfuckProgram(unsigned cellBits) : m_cellBits(cellBits) {}
+
+    void appendOp(BrainfuckOpKind kind, std::int32_t value, std::size_t sourcePos);
+    bool lowerLoopIdiom(std::size_t start, std::size_t& out,
+                        std::vector<std::pair<std::int32_t, std::int32_t>>& deltas);
+    void linkLoops();
+
+    // Cell arithmetic
+    std::uint64_t wrapCell(std::uint64_t value) const;
+    std::int64_t signedCell(std::uint64_t value) const;
+
+    unsigned m_cellBits; // Cell width in bits
+    std::vector<BrainfuckOp> m_ops; // IR operations
+    std::vector<std::string> m_strings; // Constant strings of Write operations
+    BrainfuckStatistics m_statistics; // Instruction statistics
+
+    // Initial state after precomputePrefix
+    std::vector<std::uint64_t> m_initialTape; // Tape contents, empty if all zero
+    std::int64_t m_initialTapeOffset = 0; // Position of m_initialTape[0]
+    std::int64_t m_initialPointer = 0; // Data pointer position
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BrainfuckIR.h"
+
+class BrainfuckCompiler;
+
+/**
+ * @class BrainfuckInterpreter
+ * @brief Tiered executor for Brainfuck IR
+ *
+ * Programs start running immediately in an interpreter. Each loop counts its iterations,
+ * and loops that pass the tier-up threshold are compiled to native code by a background
+ * thread. Once a loop is compiled, the interpreter transfers control at the loop header,
+ * either on loop entry or on the back edge of an iteration already in progress.
+ */
+class BrainfuckInterpreter {
+public:
+    /**
+     * @brief Native code for one loop, takes the data pointer and returns it after the loop
+     *
+     * The pointer addresses cells of the program's cell width.
+     */
+    using LoopFunction = std::uint8_t* (*)(std::uint8_t*);
+
+    /**
+     * @brief Tape allocation and bounds protection
+     */
+    struct TapeOptions {
+        std::uint32_t flags = 0; // bf_tape_alloc flags
+        std::size_t guardSize = 0; // Guard region size in bytes on both sides of the tape, 0 for none
+        bool checkBounds = false; // Check every access against the tape
+    };
+
+    /**
+     * @brief Constructor
+     * @param program Brainfuck IR to execute, must outlive the interpreter
+     * @param memorySize Memory size in cells
+     * @param compiler Compiler used for hot loops, nullptr disables tier-up
+     * @param tierThreshold Loop iterations before a loop is sent to the compiler
+     * @param tape Tape allocation and bounds protection
+     */
+    BrainfuckInterpreter(const BrainfuckProgram& program, std::size_t memorySize, BrainfuckCompiler* compiler,
+                         std::size_t tierThreshold, const TapeOptions& tape);
+
+    /**
+     * @brief Destructor, waits for the background compiler and releases the tape
+     */
+    ~BrainfuckInterpreter();
+
+    /**
+     * @brief Execute the program
+     * @return Program exit code, 1 if the tape could not be allocated
+     */
+    int run();
+
+    /**
+     * @brief Get the number of loops that were compiled to native code
+     */
+    std::size_t compiledLoopCount() const {
+        return m_compiledLoopCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Execution with cells of the program's width
+    template <typename Cell>
+    int runCells();
+
+    // Bounds checking
+    template <typename Cell>
+    Cell& cell(Cell* ptr, std::int32_t offset, std::size_t sourcePos) const;
+
+    // Zero cell search of ScanRight
+    template <typename Cell>
+    Cell* scanRight(Cell* ptr, std::int32_t stride, std::size_t sourcePos) const;
+
+    // Tier-up handling
+    void requestCompilation(std::size_t loopStart);
+    void compilerThreadMain();
+    void stopCompilerThread();
+
+    const BrainfuckProgram& m_program; // Program being executed
+    std::size_t m_memorySize; // Memory size in cells
+    TapeOptions m_tape; // Tape allocation and bounds protection
+    std::uint8_t* m_memory; // Memory array, mapped by the runtime
+    BrainfuckCompiler* m_compiler; // Compiler for hot loops
+    std::size_t m_tierThreshold; // Loop iterations before tier-up
+
+    // Per-loop state, indexed by the LoopStart operation index
+    std::vector<std::size_t> m_loopCounts; // Iterations executed in the interpreter
+    std::unique_ptr<std::atomic<LoopFunction>[]> m_compiledLoops; // Native code, once available
+    std::atomic<std::size_t> m_compiledLoopCount{0};
+
+    // Background compilation
+    std::thread m_compilerThread;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::deque<std::size_t> m_compileQueue; // Loops waiting for compilation
+    bool m_stopCompiler = false;
+};
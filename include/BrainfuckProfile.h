@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class BrainfuckProgram;
+
+/**
+ * @class BrainfuckProfile
+ * @brief Per-loop execution counts of a profiled program run
+ *
+ * Programs compiled with BrainfuckCompiler::setProfileFile count how often each loop is entered
+ * and how often its body runs, and write the counters when they end. The file is an array of
+ * native-endian 64-bit words: magic, format version, hash of the source, number of loops, and
+ * per loop its source position, the operations of its body, its entries and its iterations.
+ * The generated code keeps the counters in that layout, so writing the profile is one write.
+ */
+class BrainfuckProfile {
+public:
+    /**
+     * @brief Counters of one loop
+     */
+    struct Loop {
+        std::size_t sourcePos = 0; // Position of the loop's '[' in the source
+        std::uint64_t bodyOps = 0; // Brainfuck IR operations directly in the body, nested loops excluded
+        std::uint64_t entries = 0; // Times the loop was reached
+        std::uint64_t iterations = 0; // Times the body ran
+
+        /**
+         * @brief Operations the body executed, nested loops excluded
+         */
+        std::uint64_t executedOps() const {
+            return iterations * bodyOps;
+        }
+    };
+
+    static constexpr std::uint64_t magic = 0x31464f5250464221; // "!BFPROF1" read as little-endian
+    static constexpr std::uint64_t version = 1;
+    static constexpr std::size_t headerWords = 4; // magic, version, source hash, loop count
+    static constexpr std::size_t loopWords = 4; // source position, body operations, entries, iterations
+
+    /**
+     * @brief Hash of the source text, identifies the program a profile belongs to
+     * @param source Source code string
+     * @return Source hash
+     */
+    static std::uint64_t hashSource(std::string_view source);
+
+    /**
+     * @brief Initial counter words of a program: the header and every loop with zero counts
+     * @param program Brainfuck IR, loops are numbered in operation order
+     * @param sourceHash Hash of the program's source
+     * @return Profile words
+     */
+    static std::vector<std::uint64_t> createCounters(const BrainfuckProgram& program, std::uint64_t sourceHash);
+
+    /**
+     * @brief Read a profile file
+     * @param path Profile filename
+     * @param error Receives the error message if the file cannot be read or is no profile
+     * @return Profile, or std::nullopt on error
+     */
+    static std::optional<BrainfuckProfile> read(std::string_view path, std::string& error);
+
+    /**
+     * @brief Get the hash of the profiled program's source
+     */
+    std::uint64_t sourceHash() const {
+        return m_sourceHash;
+    }
+
+    /**
+     * @brief Get the loops, in source order
+     */
+    const std::vector<Loop>& loops() const {
+        return m_loops;
+    }
+
+    /**
+     * @brief Find the loop starting at a source position
+     * @param sourcePos Position of the loop's '['
+     * @return Loop counters, or nullptr if the profile has no such loop
+     */
+    const Loop* findLoop(std::size_t sourcePos) const;
+
+private:
+    std::uint64_t m_sourceHash = 0;
+    std::vector<Loop> m_loops; // Sorted by source position
+};
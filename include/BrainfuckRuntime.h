@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Size of the output and input buffers of the Brainfuck I/O runtime
+ */
+constexpr std::size_t BF_RUNTIME_BUFFER_SIZE = 65536;
+
+/**
+ * @brief Flag of bf_tape_alloc: reserve address space only and commit pages when they are first accessed
+ */
+constexpr std::uint32_t BF_TAPE_GROWABLE = 1;
+
+/**
+ * @brief Bit position of log2(cell size in bytes) in the bf_tape_alloc flags, used to report cell indices
+ */
+constexpr std::uint32_t BF_TAPE_CELL_SHIFT = 8;
+
+/**
+ * @brief Granularity in which a growable tape is committed, a multiple of the page size on all targets
+ */
+constexpr std::size_t BF_TAPE_CHUNK_SIZE = 65536;
+
+/**
+ * Buffered I/O runtime used by the interpreter and by JIT-compiled code.
+ *
+ * Native executables get the same runtime generated as LLVM IR by BrainfuckCompiler.
+ * Output is buffered and flushed when the buffer is full, before input is read and on exit.
+ * Input is read in blocks, end of input reads as 255.
+ */
+extern "C" {
+void bf_output(std::uint8_t value);
+void bf_write(const std::uint8_t* data, std::size_t size);
+std::uint8_t bf_input();
+void bf_flush();
+
+/**
+ * Tape storage.
+ *
+ * Tapes are mapped zero pages, so untouched cells cost neither memory nor startup time.
+ * A growable tape is mapped inaccessible and a fault handler commits the chunk around each
+ * first access. Guard regions of at least guardSize bytes stay inaccessible on both sides of
+ * the tape, and the fault handler reports accesses to them through bf_bounds_error. Sizes are
+ * in bytes.
+ * bf_tape_alloc reports failures on stderr and returns nullptr.
+ */
+std::uint8_t* bf_tape_alloc(std::size_t size, std::size_t guardSize, std::uint32_t flags);
+void bf_tape_free(std::uint8_t* tape, std::size_t size, std::size_t guardSize, std::uint32_t flags);
+
+/**
+ * Bounds checking.
+ *
+ * Code with checked accesses compares cell addresses against bf_bounds_tape, code on guarded
+ * tapes records the source position of the last loop boundary in bf_source_pos for the fault
+ * handler. bf_bounds_error flushes the output, reports the cell index and exits with status 1.
+ */
+extern std::size_t bf_source_pos;
+extern std::uint8_t* bf_bounds_tape;
+[[noreturn]] void bf_bounds_error(std::int64_t cell, std::size_t sourcePos);
+
+/**
+ * Profiling.
+ *
+ * Instrumented programs pass their loop counters here when they end, in the layout of the
+ * profile file (see BrainfuckProfile). The file at path is replaced, failures are reported on
+ * stderr. Sizes are in bytes.
+ */
+void bf_profile_write(const char* path, const std::uint64_t* counters, std::size_t size);
+
+/**
+ * I/O of programs compiled for the library interface (see BrainfuckCompiledProgram).
+ *
+ * All state of a run lives in its bf_io, so runs on different threads do not interfere.
+ * Input is read directly from the caller's buffer, end of input reads as 255. Output is
+ * collected in the output buffer and handed to the sink when the buffer is full and when the
+ * program ends, writes of at least a buffer go to the sink without a copy. Checked accesses
+ * out of bounds are recorded by bf_io_bounds_error, and the program returns status 1.
+ */
+struct bf_io {
+    const std::uint8_t* input; // Input bytes
+    std::size_t inputSize; // Number of input bytes
+    std::size_t inputPos; // Index of the next input byte
+    std::uint8_t* output; // Output buffer
+    std::size_t outputCapacity; // Output buffer size in bytes
+    std::size_t outputLength; // Bytes waiting in the output buffer
+    void (*sink)(void* context, const std::uint8_t* data, std::size_t size); // Receives the output
+    void* sinkContext; // First argument of the sink
+    bool boundsError; // Whether the program stopped at an access out of bounds
+    std::int64_t errorCell; // Cell index of that access
+    std::size_t errorSourcePos; // Source position of that access
+};
+
+void bf_io_output(bf_io* io, std::uint8_t value);
+void bf_io_write(bf_io* io, const std::uint8_t* data, std::size_t size);
+std::uint8_t bf_io_input(bf_io* io);
+void bf_io_flush(bf_io* io);
+void bf_io_bounds_error(bf_io* io, std::int64_t cell, std::size_t sourcePos);
+}
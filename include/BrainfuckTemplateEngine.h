@@ -0,0 +1,476 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "BrainfuckIR.h"
+
+/**
+ * @struct BrainfuckBufferIO
+ * @brief I/O of the template engine on fixed buffers, usable in constant expressions
+ * @tparam OutputCapacity Output buffer size in bytes
+ */
+template <std::size_t OutputCapacity>
+struct BrainfuckBufferIO {
+    std::string_view input; // Input bytes, end of input reads as 255
+    std::size_t inputPos = 0; // Position of the next input byte
+    std::array<char, OutputCapacity> output{}; // Output bytes
+    std::size_t outputSize = 0; // Number of output bytes
+    bool truncated = false; // Whether output was dropped because the buffer was full
+
+    constexpr std::uint8_t read() {
+        return inputPos < input.size() ? static_cast<std::uint8_t>(input[inputPos++]) : 255;
+    }
+
+    constexpr void write(std::uint8_t value) {
+        if (outputSize < OutputCapacity) {
+            output[outputSize++] = static_cast<char>(value);
+        } else {
+            truncated = true;
+        }
+    }
+
+    /**
+     * @brief Get the output written so far
+     */
+    constexpr std::string_view text() const {
+        return std::string_view(output.data(), outputSize);
+    }
+};
+
+/**
+ * @struct BrainfuckStdIO
+ * @brief I/O of the template engine on the C standard streams
+ */
+struct BrainfuckStdIO {
+    std::uint8_t read() {
+        int value = std::getchar();
+        return value == EOF ? 255 : static_cast<std::uint8_t>(value);
+    }
+
+    void write(std::uint8_t value) {
+        std::putchar(value);
+    }
+};
+
+/**
+ * @class BrainfuckTemplateEngine
+ * @brief Header-only executor of Brainfuck IR, without LLVM or runtime code generation
+ *
+ * The executor is instantiated for the cell type and the I/O type, so cell arithmetic has the
+ * program's width and I/O calls are inlined. The I/O type provides `std::uint8_t read()`, which
+ * returns 255 at end of input, and `void write(std::uint8_t)`, see BrainfuckBufferIO and
+ * BrainfuckStdIO. Only BrainfuckIR.cpp (the bfir library) has to be linked.
+ */
+class BrainfuckTemplateEngine {
+public:
+    /**
+     * @brief Run a program on a fresh tape
+     * @param program Brainfuck IR, the data pointer starts at memorySize / 2 after its precomputed prefix
+     * @param memorySize Memory size in cells, accesses are not checked against it
+     * @param io Program input and output
+     */
+    template <typename IO>
+    static void run(const BrainfuckProgram& program, std::size_t memorySize, IO& io) {
+        switch (program.cellBits()) {
+        case 16:
+            runCells<std::uint16_t>(program, memorySize, io);
+            break;
+        case 32:
+            runCells<std::uint32_t>(program, memorySize, io);
+            break;
+        case 64:
+            runCells<std::uint64_t>(program, memorySize, io);
+            break;
+        default:
+            runCells<std::uint8_t>(program, memorySize, io);
+            break;
+        }
+    }
+
+    /**
+     * @brief Execute the operations of a program from a data pointer
+     *
+     * The initial tape and pointer of the program's precomputed prefix are not applied.
+     * @param program Brainfuck IR with cells of the width of Cell
+     * @param ptr Data pointer
+     * @param io Program input and output
+     * @return Data pointer after the program
+     */
+    template <typename Cell, typename IO>
+    static Cell* execute(const BrainfuckProgram& program, Cell* ptr, IO& io) {
+        const std::vector<BrainfuckOp>& ops = program.ops();
+
+        for (std::size_t ip{}; ip < ops.size(); ++ip) {
+            const BrainfuckOp& op = ops[ip];
+
+            switch (op.kind) {
+            case BrainfuckOpKind::Add:
+                ptr[op.offset] += static_cast<Cell>(op.value);
+                break;
+            case BrainfuckOpKind::Move:
+                ptr += op.value;
+                break;
+            case BrainfuckOpKind::Output:
+                io.write(static_cast<std::uint8_t>(ptr[op.offset]));
+                break;
+            case BrainfuckOpKind::Input:
+                ptr[op.offset] = io.read();
+                break;
+            case BrainfuckOpKind::LoopStart:
+                if (*ptr == 0) {
+                    ip = op.match;
+                }
+                break;
+            case BrainfuckOpKind::LoopEnd:
+                if (*ptr != 0) {
+                    ip = op.match;
+                }
+                break;
+            case BrainfuckOpKind::SetZero:
+                ptr[op.offset] = 0;
+                break;
+            case BrainfuckOpKind::MulAdd:
+                // Products of wide cells are computed in 64 bits, int promotion could overflow
+                ptr[op.offset] += static_cast<Cell>(std::uint64_t{ptr[op.srcOffset]} *
+                                                    static_cast<std::uint64_t>(op.value));
+                break;
+            case BrainfuckOpKind::Write:
+                for (char value : program.strings()[op.value]) {
+                    io.write(static_cast<std::uint8_t>(value));
+                }
+                break;
+            case BrainfuckOpKind::ScanRight:
+                while (*ptr != 0) {
+                    ptr += op.value;
+                }
+                break;
+            case BrainfuckOpKind::ScanLeft:
+                while (*ptr != 0) {
+                    ptr -= op.value;
+                }
+                break;
+            }
+        }
+        return ptr;
+    }
+
+private:
+    template <typename Cell, typename IO>
+    static void runCells(const BrainfuckProgram& program, std::size_t memorySize, IO& io) {
+        std::vector<Cell> tape(memorySize);
+
+        // Tape state left by the precomputed program prefix
+        Cell* origin = tape.data() + memorySize / 2;
+        const std::vector<std::uint64_t>& initialTape = program.initialTape();
+        std::transform(initialTape.begin(), initialTape.end(), origin + program.initialTapeOffset(),
+                       [](std::uint64_t value) {
+                           return static_cast<Cell>(value);
+                       });
+
+        execute(program, origin + program.initialPointer(), io);
+    }
+};
+
+/**
+ * @struct BrainfuckStaticCode
+ * @brief Brainfuck IR built in a constant expression
+ *
+ * The compile-time counterpart of BrainfuckProgram::parse with the loop idioms: runs are folded,
+ * pointer movement is deferred to loop boundaries and carried as cell offsets, balanced loops of
+ * additions become MulAdd/SetZero and loops that only move become scans. Constant output folding
+ * and prefix precomputation are left out, a constant program is evaluated as a whole instead.
+ * @tparam Capacity Maximum number of operations, one more than the source length always suffices
+ */
+template <std::size_t Capacity>
+struct BrainfuckStaticCode {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    std::array<BrainfuckOp, Capacity> ops{}; // Operations, loops are linked through match
+    std::size_t size = 0; // Number of operations
+    std::size_t errorPos = npos; // Source position of an unmatched bracket, npos if the brackets match
+
+    /**
+     * @brief Build the IR from Brainfuck source code
+     * @param source Source code, at most Capacity - 1 characters
+     * @return IR, with errorPos set on a syntax error
+     */
+    static constexpr BrainfuckStaticCode parse(std::string_view source) {
+        BrainfuckStaticCode code;
+        std::array<std::size_t, Capacity> loops{}; // LoopStart indices of the open loops
+        std::size_t depth = 0;
+        std::int32_t pointer = 0; // Pointer movement not yet emitted
+
+        for (std::size_t pos{}; pos < source.size(); ++pos) {
+            switch (source[pos]) {
+            case '+':
+            case '-':
+                code.add(pointer, source[pos] == '+' ? 1 : -1, pos);
+                break;
+            case '>':
+                ++pointer;
+                break;
+            case '<':
+                --pointer;
+                break;
+            case '.':
+                code.append(BrainfuckOpKind::Output, 0, pointer, pos);
+                break;
+            case ',':
+                code.append(BrainfuckOpKind::Input, 0, pointer, pos);
+                break;
+            case '[':
+                code.flush(pointer, pos);
+                loops[depth++] = code.size;
+                code.append(BrainfuckOpKind::LoopStart, 0, 0, pos);
+                break;
+            case ']':
+                if (depth == 0) {
+                    code.errorPos = pos;
+                    return code;
+                }
+                code.flush(pointer, pos);
+                code.closeLoop(loops[--depth], pos);
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (depth > 0) {
+            code.errorPos = code.ops[loops[depth - 1]].sourcePos;
+        }
+        return code;
+    }
+
+private:
+    constexpr void append(BrainfuckOpKind kind, std::int32_t value, std::int32_t offset, std::size_t sourcePos) {
+        ops[size++] = BrainfuckOp{kind, value, offset, 0, 0, sourcePos};
+    }
+
+    // Additions to the cell of the previous addition are merged into it
+    constexpr void add(std::int32_t offset, std::int32_t delta, std::size_t sourcePos) {
+        if (size > 0 && ops[size - 1].kind == BrainfuckOpKind::Add && ops[size - 1].offset == offset) {
+            ops[size - 1].value += delta;
+            if (ops[size - 1].value == 0) {
+                --size;
+            }
+            return;
+        }
+        append(BrainfuckOpKind::Add, delta, offset, sourcePos);
+    }
+
+    constexpr void flush(std::int32_t& pointer, std::size_t sourcePos) {
+        if (pointer != 0) {
+            append(BrainfuckOpKind::Move, pointer, 0, sourcePos);
+            pointer = 0;
+        }
+    }
+
+    constexpr void closeLoop(std::size_t start, std::size_t sourcePos) {
+        // A body that only moves searches for a zero cell
+        if (size == start + 2 && ops[start + 1].kind == BrainfuckOpKind::Move) {
+            std::int32_t stride = ops[start + 1].value;
+            ops[start] = BrainfuckOp{stride > 0 ? BrainfuckOpKind::ScanRight : BrainfuckOpKind::ScanLeft,
+                                     stride > 0 ? stride : -stride, 0, 0, 0, ops[start].sourcePos};
+            size = start + 1;
+            return;
+        }
+        if (lowerMulAdd(start)) {
+            return;
+        }
+        ops[start].match = size;
+        append(BrainfuckOpKind::LoopEnd, 0, 0, sourcePos);
+        ops[size - 1].match = start;
+    }
+
+    // Loops of additions whose counter at offset 0 steps by one become MulAdd per target and SetZero
+    constexpr bool lowerMulAdd(std::size_t start) {
+        std::int32_t counter = 0;
+        for (std::size_t i = start + 1; i < size; ++i) {
+            if (ops[i].kind != BrainfuckOpKind::Add) {
+                return false;
+            }
+            if (ops[i].offset == 0) {
+                counter += ops[i].value;
+            }
+        }
+        if (counter != 1 && counter != -1) {
+            return false;
+        }
+
+        // Merge the additions of each target into its first one
+        for (std::size_t i = start + 1; i < size; ++i) {
+            for (std::size_t j = i + 1; ops[i].offset != 0 && j < size; ++j) {
+                if (ops[j].offset == ops[i].offset) {
+                    ops[i].value += ops[j].value;
+                    ops[j].value = 0;
+                }
+            }
+        }
+
+        // A counter counting up runs 2^n - cell times, which is -cell modulo the cell width
+        std::size_t out = start;
+        std::size_t sourcePos = ops[start].sourcePos;
+        for (std::size_t i = start + 1; i < size; ++i) {
+            if (ops[i].offset != 0 && ops[i].value != 0) {
+                ops[out++] = BrainfuckOp{BrainfuckOpKind::MulAdd, counter < 0 ? ops[i].value : -ops[i].value,
+                                         ops[i].offset, 0, 0, sourcePos};
+            }
+        }
+        ops[out++] = BrainfuckOp{BrainfuckOpKind::SetZero, 0, 0, 0, 0, sourcePos};
+        size = out;
+        return true;
+    }
+};
+
+/**
+ * @class BrainfuckStaticProgram
+ * @brief Brainfuck program compiled by the C++ compiler through template specialization
+ *
+ * The source is parsed into BrainfuckStaticCode in a constant expression, an unmatched bracket
+ * fails the build. Every operation is instantiated as its own function template with constant
+ * offsets and amounts, and every loop body as a fold over its operations, so the C++ compiler
+ * generates straight-line native code for the program with no dispatch and no runtime
+ * compilation. The same code is a constant expression: evaluate() runs a program with constant
+ * input at compile time, within the compiler's constexpr step limits, and an access outside the
+ * tape is then a compile error.
+ *
+ * The source is a character array with static storage duration:
+ * @code
+ * static constexpr char letter[] = "++++++++[>++++++++<-]>+.";
+ * using Letter = BrainfuckStaticProgram<letter>;
+ * static_assert(Letter::evaluate<1>().text() == "A");
+ * @endcode
+ * @tparam Source Null-terminated Brainfuck source code
+ * @tparam Cell Unsigned cell type, cell arithmetic wraps modulo its width
+ * @tparam MemorySize Memory size in cells of run(IO&) and evaluate()
+ */
+template <const char* Source, typename Cell = std::uint8_t, std::size_t MemorySize = 30000>
+class BrainfuckStaticProgram {
+    static_assert(std::is_unsigned_v<Cell>, "Brainfuck cells must be an unsigned integer type");
+
+    static constexpr std::size_t sourceLength = std::char_traits<char>::length(Source);
+    using Code = BrainfuckStaticCode<sourceLength + 1>;
+    static constexpr Code code = Code::parse(std::string_view(Source, sourceLength));
+    static_assert(code.errorPos == Code::npos, "Brainfuck source has an unmatched bracket");
+
+public:
+    /**
+     * @brief Get the number of IR operations of the program
+     */
+    static constexpr std::size_t opCount() {
+        return code.size;
+    }
+
+    /**
+     * @brief Run the program on a fresh zeroed tape of MemorySize cells
+     *
+     * The data pointer starts at MemorySize / 2. The tape lives on the stack, larger tapes are
+     * passed to run(Cell*, IO&).
+     * @param io Program input and output, see BrainfuckTemplateEngine
+     */
+    template <typename IO>
+    static constexpr void run(IO& io) {
+        std::array<Cell, MemorySize> tape{};
+        run(tape.data() + MemorySize / 2, io);
+    }
+
+    /**
+     * @brief Run the program from a data pointer on a caller tape
+     * @param ptr Data pointer, accesses are not checked against the tape
+     * @param io Program input and output, see BrainfuckTemplateEngine
+     * @return Data pointer after the program
+     */
+    template <typename IO>
+    static constexpr Cell* run(Cell* ptr, IO& io) {
+        return runBlock<0, code.size>(ptr, io, std::make_index_sequence<blockLength(0, code.size)>());
+    }
+
+    /**
+     * @brief Run the program on constant input, usable in constant expressions
+     * @tparam OutputCapacity Output buffer size in bytes
+     * @param input Program input, end of input reads as 255
+     * @return Output buffer after the run
+     */
+    template <std::size_t OutputCapacity>
+    static constexpr BrainfuckBufferIO<OutputCapacity> evaluate(std::string_view input = {}) {
+        BrainfuckBufferIO<OutputCapacity> io{input};
+        run(io);
+        return io;
+    }
+
+private:
+    // Operation after an operation of a block, a loop counts as one operation
+    static constexpr std::size_t next(std::size_t index) {
+        return code.ops[index].kind == BrainfuckOpKind::LoopStart ? code.ops[index].match + 1 : index + 1;
+    }
+
+    static constexpr std::size_t blockLength(std::size_t begin, std::size_t end) {
+        std::size_t length = 0;
+        for (std::size_t index = begin; index < end; index = next(index)) {
+            ++length;
+        }
+        return length;
+    }
+
+    template <std::size_t Begin, std::size_t End>
+    static constexpr std::array<std::size_t, blockLength(Begin, End)> blockOps() {
+        std::array<std::size_t, blockLength(Begin, End)> indices{};
+        std::size_t index = Begin;
+        for (std::size_t& slot : indices) {
+            slot = index;
+            index = next(index);
+        }
+        return indices;
+    }
+
+    template <std::size_t Begin, std::size_t End, typename IO, std::size_t... I>
+    static constexpr Cell* runBlock(Cell* ptr, IO& io, std::index_sequence<I...>) {
+        [[maybe_unused]] constexpr std::array<std::size_t, sizeof...(I)> indices = blockOps<Begin, End>();
+        ((ptr = runOp<indices[I]>(ptr, io)), ...);
+        return ptr;
+    }
+
+    template <std::size_t Index, typename IO>
+    static constexpr Cell* runOp(Cell* ptr, IO& io) {
+        constexpr BrainfuckOp op = code.ops[Index];
+
+        if constexpr (op.kind == BrainfuckOpKind::Add) {
+            ptr[op.offset] += static_cast<Cell>(op.value);
+        } else if constexpr (op.kind == BrainfuckOpKind::Move) {
+            ptr += op.value;
+        } else if constexpr (op.kind == BrainfuckOpKind::Output) {
+            io.write(static_cast<std::uint8_t>(ptr[op.offset]));
+        } else if constexpr (op.kind == BrainfuckOpKind::Input) {
+            ptr[op.offset] = io.read();
+        } else if constexpr (op.kind == BrainfuckOpKind::LoopStart) {
+            while (*ptr != 0) {
+                ptr = runBlock<Index + 1, op.match>(ptr, io,
+                                                    std::make_index_sequence<blockLength(Index + 1, op.match)>());
+            }
+        } else if constexpr (op.kind == BrainfuckOpKind::SetZero) {
+            ptr[op.offset] = 0;
+        } else if constexpr (op.kind == BrainfuckOpKind::MulAdd) {
+            // Products of wide cells are computed in 64 bits, int promotion could overflow
+            ptr[op.offset] +=
+                static_cast<Cell>(std::uint64_t{ptr[op.srcOffset]} * static_cast<std::uint64_t>(op.value));
+        } else if constexpr (op.kind == BrainfuckOpKind::ScanRight) {
+            while (*ptr != 0) {
+                ptr += op.value;
+            }
+        } else if constexpr (op.kind == BrainfuckOpKind::ScanLeft) {
+            while (*ptr != 0) {
+                ptr -= op.value;
+            }
+        }
+        return ptr;
+    }
+};
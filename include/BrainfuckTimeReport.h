@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Timer.h>
+
+namespace llvm {
+class Module;
+class PassInstrumentationCallbacks;
+class raw_ostream;
+} // namespace llvm
+
+/**
+ * @class BrainfuckTimeReport
+ * @brief Time, memory and IR size measurements of compiler runs
+ *
+ * The compiler records its phases, the LLVM optimization passes and the IR size before and after
+ * optimization into the report attached with BrainfuckCompiler::setTimeReport. Recording is
+ * thread-safe, so parallel code generation and background loop compilation report into the same
+ * instance. Phases and passes that run several times accumulate under one entry.
+ */
+class BrainfuckTimeReport {
+public:
+    /**
+     * @brief Output format of print()
+     */
+    enum class Format {
+        Text, // Human-readable tables
+        JSON, // One JSON object
+    };
+
+    /**
+     * @brief Totals of one compiler phase
+     *
+     * User and system time are CPU time of the whole process, so phases that overlap with other
+     * threads include the CPU time of those threads.
+     */
+    struct Phase {
+        std::string name;
+        std::size_t runs = 0; // Number of times the phase ran
+        double wallTime = 0; // Seconds
+        double userTime = 0; // Seconds
+        double systemTime = 0; // Seconds
+        std::int64_t heapDelta = 0; // Change of allocated heap memory in bytes
+        std::uint64_t peakMemory = 0; // Peak resident memory of the process in bytes after the phase
+    };
+
+    /**
+     * @brief Totals of one LLVM pass or analysis
+     */
+    struct Pass {
+        std::string name;
+        std::size_t runs = 0; // Number of times the pass ran
+        double wallTime = 0; // Seconds, excluding the nested passes and analyses it triggered
+    };
+
+    /**
+     * @brief Size of the LLVM IR, summed over modules
+     */
+    struct IRCounts {
+        std::size_t modules = 0;
+        std::size_t functions = 0; // Function definitions
+        std::size_t blocks = 0; // Basic blocks
+        std::size_t instructions = 0;
+    };
+
+    /**
+     * @brief Measures one phase from construction to destruction
+     *
+     * Does nothing without a report, so phases can be timed unconditionally.
+     */
+    class Scope {
+    public:
+        /**
+         * @brief Start measuring
+         * @param report Report receiving the phase, nullptr disables the measurement
+         * @param name Phase name, must outlive the scope
+         */
+        Scope(BrainfuckTimeReport* report, std::string_view name);
+
+        /**
+         * @brief Stop measuring and add the phase to the report
+         */
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        BrainfuckTimeReport* m_report;
+        std::string_view m_name;
+        llvm::TimeRecord m_start;
+        std::size_t m_startHeap = 0; // Allocated heap memory in bytes
+    };
+
+    /**
+     * @brief Times the passes of pass pipelines run through one set of callbacks
+     *
+     * A pipeline runs on a single thread, so each timer keeps its own stack of running passes and
+     * pauses a pass while the passes and analyses it triggers run. Pass managers and adaptors are
+     * left out, their time belongs to the passes they run.
+     */
+    class PassTimer {
+    public:
+        /**
+         * @brief Register the timing callbacks
+         * @param report Report receiving the pass times, nullptr registers nothing
+         * @param callbacks Instrumentation callbacks of the pass builder, must not outlive the timer
+         */
+        PassTimer(BrainfuckTimeReport* report, llvm::PassInstrumentationCallbacks& callbacks);
+
+        PassTimer(const PassTimer&) = delete;
+        PassTimer& operator=(const PassTimer&) = delete;
+
+    private:
+        struct RunningPass {
+            llvm::StringRef name;
+            double start; // Seconds, when the pass was started or last resumed
+            double elapsed; // Seconds accumulated before the last pause
+        };
+
+        void start(llvm::StringRef name);
+        void stop(llvm::StringRef name);
+
+        BrainfuckTimeReport* m_report;
+        std::vector<RunningPass> m_running; // Innermost pass last
+    };
+
+    /**
+     * @brief Add the size of a module
+     * @param optimized Whether the module was measured after optimization
+     * @param module Module to measure
+     */
+    void addIRCounts(bool optimized, const llvm::Module& module);
+
+    /**
+     * @brief Print the report
+     * @param os Output stream
+     * @param format Output format
+     */
+    void print(llvm::raw_ostream& os, Format format) const;
+
+private:
+    void addPhase(std::string_view name, const llvm::TimeRecord& time, std::int64_t heapDelta,
+                  std::uint64_t peakMemory);
+    void addPass(llvm::StringRef name, double wallTime);
+    void printText(llvm::raw_ostream& os) const;
+    void printJSON(llvm::raw_ostream& os) const;
+
+    mutable std::mutex m_mutex; // Guards all members below
+    std::vector<Phase> m_phases; // In order of first appearance
+    std::vector<Pass> m_passes; // In order of first appearance
+    IRCounts m_unoptimized; // Modules before optimization
+    IRCounts m_optimized; // Modules after optimization
+};
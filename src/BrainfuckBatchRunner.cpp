@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "BrainfuckBatchRunner.h"
+
+namespace {
+
+// Largest tape cleared in place between runs, larger tapes are mapped again as untouched zero pages
+constexpr std::size_t clearedTapeSize = 16 * 1024;
+
+} // namespace
+
+BrainfuckBatchRunner::BrainfuckBatchRunner(const BrainfuckCompiledProgram& program, unsigned threads)
+    : m_program(program), m_threadCount(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+    for (unsigned i{}; i < m_threadCount; ++i) {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+}
+
+BrainfuckBatchRunner::Summary BrainfuckBatchRunner::run(const std::vector<std::string>& inputFiles,
+                                                        std::string_view outputDirectory) {
+    m_inputFiles = &inputFiles;
+    m_outputDirectory = std::string(outputDirectory);
+
+    if (!m_outputDirectory.empty()) {
+        if (std::error_code ec = llvm::sys::fs::create_directories(m_outputDirectory)) {
+            reportError("Cannot create output directory " + m_outputDirectory + ": " + ec.message());
+            Summary summary;
+            summary.failures = inputFiles.size();
+            return summary;
+        }
+    }
+
+    // Contiguous ranges keep neighbouring inputs on one worker until stealing starts
+    for (std::size_t worker{}; worker < m_threadCount; ++worker) {
+        std::size_t begin = inputFiles.size() * worker / m_threadCount;
+        std::size_t end = inputFiles.size() * (worker + 1) / m_threadCount;
+        for (std::size_t input = begin; input < end; ++input) {
+            m_queues[worker]->inputs.push_back(input);
+        }
+    }
+
+    // No more workers than inputs, the calling thread is the first worker
+    std::size_t workerCount = std::min<std::size_t>(m_threadCount, std::max<std::size_t>(inputFiles.size(), 1));
+    std::vector<Summary> summaries(m_threadCount);
+    std::vector<std::thread> threads;
+    for (std::size_t worker = 1; worker < workerCount; ++worker) {
+        threads.emplace_back(&BrainfuckBatchRunner::workerMain, this, worker, std::ref(summaries[worker]));
+    }
+    workerMain(0, summaries[0]);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // Queues of workers that were never started were emptied by stealing
+    Summary total;
+    for (const Summary& summary : summaries) {
+        total.runs += summary.runs;
+        total.failures += summary.failures;
+        total.outputBytes += summary.outputBytes;
+    }
+    m_inputFiles = nullptr;
+    return total;
+}
+
+void BrainfuckBatchRunner::workerMain(std::size_t worker, Summary& summary) {
+    // One tape per worker. Small tapes are cleared between runs instead of mapped again, larger ones are mapped
+    // again so that runs only pay for the pages they touch, not O(tapeSize) each and a fully resident tape.
+    std::size_t tapeSize = m_program.tapeSize();
+    std::uint8_t* tape = bf_tape_alloc(tapeSize, 0, 0);
+
+    std::vector<std::uint8_t> input;
+    std::string output;
+    bool tapeDirty = false;
+
+    std::size_t index;
+    while (nextInput(worker, index)) {
+        const std::string& inputFile = (*m_inputFiles)[index];
+        ++summary.runs;
+        if (!tape) {
+            ++summary.failures;
+            continue;
+        }
+
+        if (tapeDirty && tapeSize <= clearedTapeSize) {
+            std::memset(tape, 0, tapeSize);
+        } else if (tapeDirty) {
+            bf_tape_free(tape, tapeSize, 0, 0);
+            if (!(tape = bf_tape_alloc(tapeSize, 0, 0))) {
+                ++summary.failures;
+                continue;
+            }
+        }
+        tapeDirty = true;
+
+        if (!runInput(inputFile, tape, input, output, summary)) {
+            ++summary.failures;
+        }
+    }
+
+    bf_tape_free(tape, tapeSize, 0, 0);
+}
+
+bool BrainfuckBatchRunner::nextInput(std::size_t worker, std::size_t& input) {
+    // Own queue first
+    {
+        WorkQueue& queue = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.inputs.empty()) {
+            input = queue.inputs.front();
+            queue.inputs.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the other workers, starting with the next one so thieves spread out
+    for (std::size_t i = 1; i < m_threadCount; ++i) {
+        WorkQueue& queue = *m_queues[(worker + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.inputs.empty()) {
+            input = queue.inputs.back();
+            queue.inputs.pop_back();
+            return true;
+        }
+    }
+
+    // Inputs are never added during a batch, so empty queues mean the batch is done
+    return false;
+}
+
+bool BrainfuckBatchRunner::runInput(const std::string& inputFile, std::uint8_t* tape, std::vector<std::uint8_t>& input,
+                                    std::string& output, Summary& summary) {
+    // Read the whole input into the worker's buffer
+    std::ifstream file(inputFile, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        reportError("Cannot open input file: " + inputFile);
+        return false;
+    }
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    input.resize(static_cast<std::size_t>(std::max<std::streamsize>(size, 0)));
+    if (!file.read(reinterpret_cast<char*>(input.data()), size)) {
+        reportError("Cannot read input file: " + inputFile);
+        return false;
+    }
+
+    // Output is collected only when it is kept
+    output.clear();
+    bool keepOutput = !m_outputDirectory.empty();
+    std::uint64_t outputBytes = 0;
+    BrainfuckCompiledProgram::RunResult result =
+        m_program.run(input, [&](llvm::ArrayRef<std::uint8_t> data) {
+            outputBytes += data.size();
+            if (keepOutput) {
+                output.append(reinterpret_cast<const char*>(data.data()), data.size());
+            }
+        }, tape);
+    summary.outputBytes += outputBytes;
+
+    if (keepOutput) {
+        llvm::SmallString<256> outputFile(m_outputDirectory);
+        llvm::sys::path::append(outputFile, llvm::sys::path::filename(inputFile));
+
+        std::error_code ec;
+        llvm::raw_fd_ostream stream(outputFile, ec, llvm::sys::fs::OF_None);
+        if (!ec) {
+            stream << output;
+            stream.close();
+            ec = stream.error();
+            stream.clear_error();
+        }
+        if (ec) {
+            reportError("Cannot write output file " + std::string(outputFile) + ": " + ec.message());
+            return false;
+        }
+    }
+
+    if (result.boundsError) {
+        reportError(inputFile + ": tape access out of bounds at cell " + std::to_string(result.errorCell) +
+                    " (source position " + std::to_string(result.errorSourcePos) + ")");
+        return false;
+    }
+    if (result.status != 0) {
+        reportError(inputFile + ": program returned " + std::to_string(result.status));
+        return false;
+    }
+
+    return true;
+}
+
+void BrainfuckBatchRunner::reportError(std::string_view message) {
+    std::lock_guard<std::mutex> lock(m_reportMutex);
+    std::cerr << "Error: " << std::string(message) << std::endl;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "BrainfuckCache.h"
+
+BrainfuckCache::BrainfuckCache(std::string_view directory) : m_directory(directory) {}
+
+bool BrainfuckCache::loadExecutable(std::string_view outputFile) const {
+    std::string path = executablePath();
+    if (!llvm::sys::fs::exists(path)) {
+        return false;
+    }
+
+    // Copy rather than link, the output may be modified or deleted by the user
+    std::string executableFile(outputFile);
+    if (llvm::sys::fs::copy_file(path, executableFile)) {
+        return false;
+    }
+
+    auto permissions = llvm::sys::fs::getPermissions(path);
+    if (!permissions || llvm::sys::fs::setPermissions(executableFile, *permissions)) {
+        return false;
+    }
+
+    return true;
+}
+
+void BrainfuckCache::storeExecutable(std::string_view executableFile) const {
+    auto contents = llvm::MemoryBuffer::getFile(executableFile);
+    if (!contents) {
+        std::cerr << "Warning: Cannot read " << executableFile << " for the cache: " << contents.getError().message()
+                  << std::endl;
+        return;
+    }
+
+    storeFile(executablePath(), (*contents)->getBuffer(), true);
+}
+
+bool BrainfuckCache::hasObject(const llvm::Module& module) const {
+    return llvm::sys::fs::exists(objectPath(module));
+}
+
+void BrainfuckCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) {
+    storeFile(objectPath(*module), object.getBuffer(), false);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> BrainfuckCache::getObject(const llvm::Module* module) {
+    auto object = llvm::MemoryBuffer::getFile(objectPath(*module));
+    if (!object) {
+        return nullptr;
+    }
+    return std::move(*object);
+}
+
+std::string BrainfuckCache::executablePath() const {
+    llvm::SmallString<256> path(m_directory);
+    llvm::sys::path::append(path, m_programKey);
+    return std::string(path);
+}
+
+std::string BrainfuckCache::objectPath(const llvm::Module& module) const {
+    // Modules of one program are told apart by their identifier, lazy JIT partitions get unique ones
+    llvm::SHA256 hasher;
+    hasher.update(m_programKey);
+    hasher.update(module.getModuleIdentifier());
+
+    llvm::SmallString<256> path(m_directory);
+    llvm::sys::path::append(path, llvm::toHex(hasher.final(), true) + ".o");
+    return std::string(path);
+}
+
+void BrainfuckCache::storeFile(const std::string& path, llvm::StringRef contents, bool executable) const {
+    if (std::error_code ec = llvm::sys::fs::create_directories(m_directory)) {
+        std::cerr << "Warning: Cannot create cache directory " << m_directory << ": " << ec.message() << std::endl;
+        return;
+    }
+
+    // Write a temporary file next to the entry and rename it into place
+    unsigned mode = executable ? llvm::sys::fs::all_read | llvm::sys::fs::all_write | llvm::sys::fs::all_exe
+                               : llvm::sys::fs::all_read | llvm::sys::fs::all_write;
+    int fd;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec =
+            llvm::sys::fs::createUniqueFile(path + ".tmp%%%%%%", fd, tempPath, llvm::sys::fs::OF_None, mode)) {
+        std::cerr << "Warning: Cannot write cache entry " << path << ": " << ec.message() << std::endl;
+        return;
+    }
+
+    {
+        llvm::raw_fd_ostream stream(fd, true);
+        stream << contents;
+        stream.close();
+        if (stream.has_error()) {
+            std::cerr << "Warning: Cannot write cache entry " << path << ": " << stream.error().message() << std::endl;
+            stream.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            return;
+        }
+    }
+
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        std::cerr << "Warning: Cannot write cache entry " << path << ": " << ec.message() << std::endl;
+        llvm::sys::fs::remove(tempPath);
+    }
+}
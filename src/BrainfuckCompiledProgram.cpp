@@ -0,0 +1,46 @@
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+
+#include "BrainfuckCompiledProgram.h"
+
+BrainfuckCompiledProgram::BrainfuckCompiledProgram(std::unique_ptr<llvm::orc::LLJIT> jit, EntryFunction entry,
+                                                   std::size_t tapeSize, std::size_t tapeAlignment)
+    : m_jit(std::move(jit)), m_entry(entry), m_tapeSize(tapeSize), m_tapeAlignment(tapeAlignment) {}
+
+BrainfuckCompiledProgram::~BrainfuckCompiledProgram() = default;
+
+BrainfuckCompiledProgram::RunResult BrainfuckCompiledProgram::run(llvm::ArrayRef<std::uint8_t> input,
+                                                                  OutputSink output, std::uint8_t* tape) const {
+    RunResult result;
+
+    // A fresh tape is a mapping of zero pages, page alignment covers any tape alignment
+    std::uint8_t* ownTape = nullptr;
+    if (!tape) {
+        ownTape = bf_tape_alloc(m_tapeSize, 0, 0);
+        if (!ownTape) {
+            result.status = 1;
+            return result;
+        }
+        tape = ownTape;
+    }
+
+    std::uint8_t outputBuffer[BF_RUNTIME_BUFFER_SIZE];
+    bf_io io = {};
+    io.input = input.data();
+    io.inputSize = input.size();
+    io.output = outputBuffer;
+    io.outputCapacity = sizeof(outputBuffer);
+    io.sink = [](void* context, const std::uint8_t* data, std::size_t size) {
+        (*static_cast<OutputSink*>(context))(llvm::ArrayRef<std::uint8_t>(data, size));
+    };
+    io.sinkContext = &output;
+
+    result.status = m_entry(&io, tape);
+    result.boundsError = io.boundsError;
+    result.errorCell = io.errorCell;
+    result.errorSourcePos = io.errorSourcePos;
+
+    if (ownTape) {
+        bf_tape_free(ownTape, m_tapeSize, 0, 0);
+    }
+    return result;
+}
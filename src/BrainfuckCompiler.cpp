@@ -4,478 +4,3153 @@
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
 
 // LLVM headers
 #include <llvm/ADT/APInt.h>
 #include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InlineAsm.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
+#include <llvm/IR/ProfileSummary.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FileUtilities.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/SHA256.h>
 #include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
 #include <llvm/TargetParser/Triple.h>
 #include <llvm/MC/TargetRegistry.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar.h>
-#include <llvm/Transforms/Scalar/GVN.h>
-
-// MCJIT headers
-#include <llvm/ExecutionEngine/MCJIT.h>
-#include <llvm/ExecutionEngine/ExecutionEngine.h>
-#include <llvm/ExecutionEngine/GenericValue.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/ProfileData/ProfileCommon.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+// ORC JIT headers
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRPartitionLayer.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/Error.h>
 
 // Debug info headers
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/DebugInfo.h>
 
+#ifdef BF_HAVE_LLD
+    #include <lld/Common/Driver.h>
+LLD_HAS_DRIVER(elf)
+#endif
+
 #include "BrainfuckCompiler.h"
+#include "BrainfuckFastBackend.h"
+#include "BrainfuckInterpreter.h"
+#include "BrainfuckProfile.h"
+#include "BrainfuckRuntime.h"
+
+namespace {
+
+// Version of the generated code, part of every cache key, bump it when code generation changes
+constexpr unsigned cacheFormatVersion = 1;
+
+// Linux system calls used by freestanding executables
+enum class SystemCall { Read, Write, Mmap, Mprotect, RtSigaction, RtSigreturn, ExitGroup, Openat, Close };
+
+unsigned getSyscallNumber(llvm::Triple::ArchType arch, SystemCall call) {
+    static const unsigned x86_64Numbers[] = {0, 1, 9, 10, 13, 15, 231, 257, 3};
+    static const unsigned aarch64Numbers[] = {63, 64, 222, 226, 134, 139, 94, 56, 57};
+    const unsigned* numbers = arch == llvm::Triple::x86_64 ? x86_64Numbers : aarch64Numbers;
+    return numbers[static_cast<std::size_t>(call)];
+}
+
+// Modules created in one LLVM context before a compiler replaces it
+constexpr unsigned contextModuleLimit = 64;
+
+// Bytes compared per step of a vectorized scan, tapes are aligned to it so that blocks never cross a page
+constexpr unsigned scanBlockSize = 32;
+
+// Branch weights of two profile counts, weights are 32-bit so large counts are scaled down together
+llvm::MDNode* createCountWeights(llvm::LLVMContext& context, std::uint64_t first, std::uint64_t second) {
+    unsigned shift = 0;
+    while ((std::max(first, second) >> shift) > std::numeric_limits<std::uint32_t>::max()) {
+        ++shift;
+    }
+
+    // Counts that were not zero stay possible
+    auto scale = [&](std::uint64_t count) {
+        return static_cast<std::uint32_t>(std::max<std::uint64_t>(count >> shift, count != 0));
+    };
+    return llvm::MDBuilder(context).createBranchWeights(scale(first), scale(second));
+}
+
+// Entry point of a bundled program in shared objects, the name reduced to characters of C identifiers
+std::string getBundleEntryName(std::string_view name) {
+    std::string entryName = "bf_main_";
+    for (char c : name) {
+        entryName += llvm::isAlnum(c) ? c : '_';
+    }
+    return entryName;
+}
+
+} // namespace
 
 BrainfuckCompiler::~BrainfuckCompiler() {
     // Clean up resources
     if (m_diBuilder) {
         finalizeDebugInfo();
     }
-}
+}
+
+void BrainfuckCompiler::initializeLLVM() {
+    // Initialize the host target once per process, other targets are registered for --target only
+    static std::once_flag initialized;
+    std::call_once(initialized, [] {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmParser();
+        llvm::InitializeNativeTargetAsmPrinter();
+    });
+}
+
+const llvm::Target* BrainfuckCompiler::lookupTarget(std::string& error) {
+    initializeLLVM();
+
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    if (const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, error)) {
+        return target;
+    }
+
+#ifdef BF_ALL_TARGETS
+    // Cross compilation, every target linked into the compiler is registered the first time
+    static std::once_flag allInitialized;
+    std::call_once(allInitialized, [] {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+        llvm::InitializeAllAsmParsers();
+        llvm::InitializeAllAsmPrinters();
+    });
+    error.clear();
+    return llvm::TargetRegistry::lookupTarget(triple, error);
+#else
+    error += " (the compiler was built with the native target only)";
+    return nullptr;
+#endif
+}
+
+void BrainfuckCompiler::createModule() {
+    // Release the previous module before its context
+    m_diBuilder.reset();
+    m_builder.reset();
+    m_module.reset();
+
+    // The context is shared by successive modules, types and constants it uniques are created once. It is
+    // replaced now and then so a long-lived compiler does not accumulate the constants of every program,
+    // JITs still running modules of the old context keep it alive.
+    if (!m_context || m_contextModules == contextModuleLimit) {
+        auto context = std::make_unique<llvm::LLVMContext>();
+#ifdef NDEBUG
+        // Value names only help reading the IR, release builds do not build or unique them
+        context->setDiscardValueNames(true);
+#endif
+        m_context = context.get();
+        m_threadSafeContext = llvm::orc::ThreadSafeContext(std::move(context));
+        m_contextModules = 0;
+    }
+    ++m_contextModules;
+
+    m_module = std::make_unique<llvm::Module>("brainfuck_module", *m_context);
+    m_builder = std::make_unique<llvm::IRBuilder<>>(*m_context);
+    m_mainFunction = nullptr;
+    m_memoryArray = nullptr;
+    m_tapeAllocFunc = nullptr;
+    m_tapeFreeFunc = nullptr;
+    m_tapeFreeArgs.clear();
+    m_boundsErrorFunc = nullptr;
+    m_sourcePosVar = nullptr;
+    m_boundsTapeVar = nullptr;
+    m_profileVar = nullptr;
+    m_profileWriteFunc = nullptr;
+    m_profileLoops = 0;
+    m_ioContext = nullptr;
+    m_loops.clear();
+    m_outlinedLoopCall = nullptr;
+
+    // Set target triple
+    auto targetTriple = m_targetTriple.empty() ? llvm::sys::getDefaultTargetTriple() : m_targetTriple;
+    m_module->setTargetTriple(llvm::Triple(targetTriple));
+}
+
+void BrainfuckCompiler::setTargetTriple(std::string_view triple) {
+    m_targetTriple = triple.empty() ? std::string() : llvm::Triple::normalize(triple);
+
+    // The next compilation builds a target machine for the new target
+    m_pipeline.reset();
+    m_targetMachine.reset();
+}
+
+void BrainfuckCompiler::setTargetCPU(std::string_view cpu, std::string_view features) {
+    m_pipeline.reset();
+    m_targetMachine.reset();
+    m_loopTracker = nullptr;
+    m_loopJIT.reset();
+
+    m_targetCPU = cpu.empty() ? "generic" : std::string(cpu);
+    m_targetFeatures = std::string(features);
+
+    if (m_targetCPU == "native") {
+        m_targetCPU = llvm::sys::getHostCPUName().str();
+
+        // Host CPU implies host features, which also reflects features disabled by the OS
+        if (m_targetFeatures.empty()) {
+            m_targetFeatures = "native";
+        }
+    }
+
+    if (m_targetFeatures == "native") {
+        llvm::SubtargetFeatures hostFeatures;
+        for (const auto& feature : llvm::sys::getHostCPUFeatures()) {
+            hostFeatures.AddFeature(feature.first(), feature.second);
+        }
+        m_targetFeatures = hostFeatures.getString();
+    }
+}
+
+void BrainfuckCompiler::setCacheDirectory(std::string_view directory) {
+    m_cache = directory.empty() ? nullptr : std::make_unique<BrainfuckCache>(directory);
+}
+
+bool BrainfuckCompiler::loadProfile(std::string_view file) {
+    std::string error;
+    m_profile = BrainfuckProfile::read(file, error);
+    if (!m_profile) {
+        reportError(error);
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<BrainfuckProgram> BrainfuckCompiler::buildProgram(std::string_view source) {
+    // Build Brainfuck IR in one pass, matching brackets and folding instruction runs
+    std::string error;
+    std::optional<BrainfuckProgram> parsed;
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Parsing");
+        parsed = BrainfuckProgram::parse(source, m_cellBits, error);
+    }
+    if (!parsed) {
+        reportError(error);
+        return std::nullopt;
+    }
+    BrainfuckProgram& program = *parsed;
+    m_statistics = program.statistics();
+    if (!m_profileFile.empty() || m_profile) {
+        m_sourceHash = BrainfuckProfile::hashSource(source);
+    }
+
+    // Profile positions refer to the profiled source only
+    if (m_profile && m_profile->sourceHash() != m_sourceHash) {
+        std::cerr << "Warning: The profile does not match the source, compiling without it" << std::endl;
+        m_profile.reset();
+    }
+
+    // Turn clear and copy/multiply loops into straight-line operations
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Loop idioms");
+        program.recognizeLoopIdioms();
+    }
+
+    // Address cells by offset and apply pointer movement once per block
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Pointer offset folding");
+        program.foldPointerOffsets();
+    }
+
+    // Merge outputs of known cell values into constant strings
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Constant output folding");
+        program.foldConstantOutput();
+    }
+
+    // Run the input-free prefix now, its output becomes a constant string. Profiles cover the whole
+    // program, so profiled builds run every loop at run time.
+    if (m_prefixStepBudget > 0 && m_profileFile.empty()) {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Prefix evaluation");
+        program.precomputePrefix(m_memorySize, m_prefixStepBudget);
+    }
+
+    return parsed;
+}
+
+std::string BrainfuckCompiler::computeCacheKey(const BrainfuckProgram& program, std::string_view mode) {
+    llvm::SHA256 hasher;
+    auto addNumber = [&](std::uint64_t value) {
+        std::uint8_t bytes[8];
+        for (std::uint8_t& byte : bytes) {
+            byte = static_cast<std::uint8_t>(value);
+            value >>= 8;
+        }
+        hasher.update(bytes);
+    };
+    auto addString = [&](std::string_view text) {
+        addNumber(text.size());
+        hasher.update(llvm::StringRef(text.data(), text.size()));
+    };
+
+    // Compiler and code generation options
+    addNumber(cacheFormatVersion);
+    addString(LLVM_VERSION_STRING);
+    addString(mode);
+    addString(m_module->getTargetTriple().str());
+    addString(m_targetCPU);
+    addString(m_targetFeatures);
+    if (mode != "exe" && mode != "fast-exe") {
+        // JIT code is generated for the host unless the target CPU is overridden
+        addString(llvm::sys::getHostCPUName());
+        llvm::SubtargetFeatures hostFeatures;
+        for (const auto& feature : llvm::sys::getHostCPUFeatures()) {
+            hostFeatures.AddFeature(feature.first(), feature.second);
+        }
+        addString(hostFeatures.getString());
+    }
+    addNumber(static_cast<std::uint64_t>(m_optLevel));
+    addNumber(static_cast<std::uint64_t>(m_tapeStorage));
+    addNumber(static_cast<std::uint64_t>(m_boundsMode));
+    addNumber(m_enableDebugInfo);
+    addNumber(m_freestanding);
+    addNumber(m_memorySize);
+    addString(m_profileFile);
+    addNumber(m_profileFile.empty() ? 0 : m_sourceHash);
+    addNumber(m_profile.has_value());
+    if (m_profile) {
+        addNumber(m_profile->loops().size());
+        for (const BrainfuckProfile::Loop& loop : m_profile->loops()) {
+            addNumber(loop.sourcePos);
+            addNumber(loop.bodyOps);
+            addNumber(loop.entries);
+            addNumber(loop.iterations);
+        }
+    }
+
+    // Normalized program, comments and the spelling of folded runs do not matter. Source positions only
+    // reach the generated code through bounds reports, debug info, profiles and the names of outlined JIT loops.
+    bool keepSourcePos =
+        m_boundsMode != BoundsMode::None || m_enableDebugInfo || !m_profileFile.empty() || mode == "jit";
+    addNumber(program.cellBits());
+    addNumber(program.ops().size());
+    for (const BrainfuckOp& op : program.ops()) {
+        addNumber(static_cast<std::uint64_t>(op.kind));
+        addNumber(static_cast<std::uint32_t>(op.value));
+        addNumber(static_cast<std::uint32_t>(op.offset));
+        addNumber(static_cast<std::uint32_t>(op.srcOffset));
+        addNumber(op.match);
+        addNumber(keepSourcePos ? op.sourcePos : 0);
+    }
+    addNumber(program.strings().size());
+    for (const std::string& text : program.strings()) {
+        addString(text);
+    }
+    addNumber(program.initialTape().size());
+    for (std::uint64_t value : program.initialTape()) {
+        addNumber(value);
+    }
+    addNumber(static_cast<std::uint64_t>(program.initialTapeOffset()));
+    addNumber(static_cast<std::uint64_t>(program.initialPointer()));
+
+    return llvm::toHex(hasher.final(), true);
+}
+
+llvm::orc::LLJITBuilderState::CompileFunctionCreator BrainfuckCompiler::createCachingCompiler() {
+    // Same compiler as the LLJIT default, with the object cache attached
+    return [this](llvm::orc::JITTargetMachineBuilder targetMachineBuilder)
+               -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        auto targetMachine = targetMachineBuilder.createTargetMachine();
+        if (!targetMachine) {
+            return targetMachine.takeError();
+        }
+        return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*targetMachine), m_cache.get());
+    };
+}
+
+bool BrainfuckCompiler::isCached(const llvm::Module& module) const {
+    return m_cache && m_cache->hasObject(module);
+}
+
+bool BrainfuckCompiler::compile(std::string_view source, std::string_view outputFile, bool enableJIT) {
+    try {
+        // Build Brainfuck IR
+        std::optional<BrainfuckProgram> program = buildProgram(source);
+        if (!program) {
+            return false;
+        }
+
+        // Every compilation starts from a fresh module, in the context shared with earlier ones
+        createModule();
+
+        // Freestanding executables replace the C library with system calls of the target
+        if (m_freestanding && enableJIT) {
+            reportError("Freestanding builds produce executables and cannot run in JIT mode");
+            return false;
+        }
+        if (m_freestanding && !checkFreestandingTarget()) {
+            return false;
+        }
+        if (enableJIT && !checkHostTarget("JIT mode")) {
+            return false;
+        }
+        if (m_backend == Backend::Fast) {
+            return compileFast(*program, outputFile, enableJIT);
+        }
+
+        // A cached executable needs no code generation at all
+        if (m_cache) {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "Cache lookup");
+            m_cache->setProgramKey(computeCacheKey(*program, enableJIT ? "jit" : "exe"));
+            if (!enableJIT && m_cache->loadExecutable(outputFile)) {
+                std::cout << "Compilation completed (cached): " << outputFile << std::endl;
+                return true;
+            }
+        }
+
+        // Outline top-level loops in JIT mode so they are compiled lazily, and for parallel code generation
+        m_outlineLoops = enableJIT || (m_compileThreads > 1 && !m_enableDebugInfo);
+
+        // Loops that never ran in the profile leave main, so its hot path stays compact
+        m_outlineColdLoops = m_profile && !m_outlineLoops && !m_enableDebugInfo;
+
+        {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "IR generation");
+
+            // Create main function and allocate memory
+            createMainFunction();
+            m_hostRuntime = enableJIT;
+            m_guardSize =
+                m_boundsMode == BoundsMode::Guard ? (program->maxAccessStride() + 1) * (m_cellBits / 8) : 0;
+            setupRuntimeFunctions();
+            if (program->usesTape() && !allocateMemory(*program)) {
+                return false;
+            }
+            if (!m_profileFile.empty() && !setupProfile(*program)) {
+                return false;
+            }
+            if (m_freestanding) {
+                defineStartFunction();
+                defineMemoryFunctions();
+            }
+
+            // Generate debug info (if enabled)
+            if (m_enableDebugInfo) {
+                createDebugInfo();
+            }
+
+            // Generate IR
+            generateIR(*program);
+
+            // Debug info must be finalized before verification and code generation
+            finalizeDebugInfo();
+        }
+
+        // Verify IR
+        if (!verifyModule()) {
+            return false;
+        }
+
+        // Create target machine, the optimizer uses it for cost modeling
+        if (!createTargetMachine()) {
+            return false;
+        }
+
+        // Output IR (for debugging)
+        // m_module->print(errs(), nullptr);
+
+        if (enableJIT) {
+            // JIT mode: direct execution, each function is optimized when it is first reached
+            BrainfuckTimeReport::Scope phase(m_timeReport, "JIT compilation and execution");
+            executeJIT();
+        } else {
+            // Optimize and generate object files, then link them
+            if (!emitObjectFile(outputFile)) {
+                return false;
+            }
+        }
+
+        return true;
+
+    } catch (const std::exception& e) {
+        reportError(std::string("Compilation error: ") + e.what());
+        return false;
+    }
+}
+
+bool BrainfuckCompiler::compileFast(const BrainfuckProgram& program, std::string_view outputFile, bool enableJIT) {
+    // Code is generated straight from the Brainfuck IR, without the LLVM features that need IR
+    if (m_boundsMode != BoundsMode::None) {
+        reportError("The fast backend does not check tape bounds");
+        return false;
+    }
+    if (m_enableDebugInfo || !m_profileFile.empty() || m_freestanding) {
+        reportError("The fast backend does not support debug info, profiling or freestanding builds");
+        return false;
+    }
+
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    std::optional<BrainfuckFastBackend::Arch> arch = BrainfuckFastBackend::getArch(triple);
+    if (!arch || (!enableJIT && !triple.isOSBinFormatELF())) {
+        reportError("The fast backend supports ELF executables and JIT mode on x86-64 and AArch64, target " +
+                    triple.str() + " is not available");
+        return false;
+    }
+    BrainfuckFastBackend backend(*arch, m_memorySize, m_timeReport);
+    std::string error;
+
+    if (enableJIT) {
+        // Mapped tapes of the host runtime, the static tape is a mapping of its own
+        std::uint32_t tapeFlags = (m_tapeStorage == TapeStorage::Grow ? BF_TAPE_GROWABLE : 0) |
+                                  llvm::Log2_32(m_cellBits / 8) << BF_TAPE_CELL_SHIFT;
+        std::optional<int> result = backend.run(program, tapeFlags, error);
+        if (!result) {
+            reportError(error);
+            return false;
+        }
+        std::cout << "JIT execution completed, return value: " << *result << std::endl;
+        return true;
+    }
+
+    // Executables keep the tape in .bss
+    if (m_tapeStorage != TapeStorage::Static) {
+        reportError("The fast backend keeps the tape of executables in static storage");
+        return false;
+    }
+
+    std::string executableFile = std::string(outputFile);
+    if (m_cache) {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Cache lookup");
+        m_cache->setProgramKey(computeCacheKey(program, "fast-exe"));
+        if (m_cache->loadExecutable(executableFile)) {
+            std::cout << "Compilation completed (cached): " << executableFile << std::endl;
+            return true;
+        }
+    }
+
+    std::vector<char> object;
+    if (!backend.emitObject(program, object, error)) {
+        reportError(error);
+        return false;
+    }
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Linking");
+        llvm::StringRef objectRef(object.data(), object.size());
+        if (!linkExecutable(objectRef, executableFile)) {
+            return false;
+        }
+    }
+
+    if (m_cache) {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Cache store");
+        m_cache->storeExecutable(executableFile);
+    }
+
+    std::cout << "Compilation completed: " << executableFile << std::endl;
+    return true;
+}
+
+bool BrainfuckCompiler::interpret(std::string_view source, std::size_t tierThreshold) {
+    try {
+        // Build Brainfuck IR
+        std::optional<BrainfuckProgram> program = buildProgram(source);
+        if (!program) {
+            return false;
+        }
+
+        // The host checks and the loops compiled for the interpreter use a fresh module
+        createModule();
+
+        if (m_freestanding) {
+            reportError("Freestanding builds produce executables and cannot run in tiered mode");
+            return false;
+        }
+        if (!checkHostTarget("Tiered mode") || !checkNotProfiling("Tiered mode")) {
+            return false;
+        }
+
+        // Loops compiled in the background are looked up in the cache under this program
+        if (m_cache) {
+            m_cache->setProgramKey(computeCacheKey(*program, "tiered"));
+        }
+
+        // Start interpreting right away, hot loops are compiled in the background
+        BrainfuckInterpreter::TapeOptions tape;
+        tape.flags = (m_tapeStorage == TapeStorage::Grow ? BF_TAPE_GROWABLE : 0) |
+                     llvm::Log2_32(m_cellBits / 8) << BF_TAPE_CELL_SHIFT;
+        tape.guardSize = m_boundsMode == BoundsMode::Guard ? (program->maxAccessStride() + 1) * (m_cellBits / 8) : 0;
+        tape.checkBounds = m_boundsMode == BoundsMode::Check;
+        int result;
+        std::size_t compiledLoops;
+        {
+            BrainfuckInterpreter interpreter(*program, m_memorySize, this, tierThreshold, tape);
+            {
+                BrainfuckTimeReport::Scope phase(m_timeReport, "Tiered execution");
+                result = interpreter.run();
+            }
+            compiledLoops = interpreter.compiledLoopCount();
+
+            // Leaving the block joins the compile thread, no loop is being compiled past this point
+        }
+
+        // The loop JIT is kept for the next program, the loops of this one go with its interpreter
+        if (m_loopTracker) {
+            if (auto error = m_loopTracker->remove()) {
+                reportError("JIT loop removal failed: " + llvm::toString(std::move(error)));
+            }
+            m_loopTracker = nullptr;
+        }
+
+        std::cout << "Tiered execution completed, return value: " << result
+                  << ", compiled loops: " << compiledLoops << std::endl;
+
+        return true;
+
+    } catch (const std::exception& e) {
+        reportError(std::string("Execution error: ") + e.what());
+        return false;
+    }
+}
+
+BrainfuckInterpreter::LoopFunction BrainfuckCompiler::compileLoop(const BrainfuckProgram& program,
+                                                                  std::size_t loopStart) {
+    try {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Loop compilation");
+
+        // Each loop gets a fresh module, calling into the interpreter's runtime
+        createModule();
+        m_hostRuntime = true;
+        setupRuntimeFunctions();
+
+        if (!createTargetMachine()) {
+            return nullptr;
+        }
+
+        // Create the loop JIT on first use, the loops of each program are tracked to be removed together
+        if (!m_loopJIT && !(m_loopJIT = createJIT())) {
+            return nullptr;
+        }
+        if (!m_loopTracker) {
+            m_loopTracker = m_loopJIT->getMainJITDylib().createResourceTracker();
+        }
+
+        // Loop function: cell_t* bf_loop_<ip>(cell_t* dataPtr), returns the data pointer after the loop
+        const std::vector<BrainfuckOp>& ops = program.ops();
+        std::string name = "bf_loop_" + std::to_string(ops[loopStart].sourcePos);
+
+        llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+        llvm::FunctionType* loopType = llvm::FunctionType::get(ptrType, {ptrType}, false);
+        llvm::Function* loopFunction =
+            llvm::Function::Create(loopType, llvm::Function::ExternalLinkage, name, m_module.get());
+        m_module->setModuleIdentifier(name);
+
+        llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_context, "entry", loopFunction);
+        m_builder->SetInsertPoint(entryBlock);
+        m_dataPtr = loopFunction->getArg(0);
+
+        // Generate the loop, including its brackets
+        m_outlineLoops = false;
+        m_outlineColdLoops = false;
+        generateOps(program, loopStart, ops[loopStart].match + 1);
+        m_builder->CreateRet(m_dataPtr);
+
+        // Verify IR
+        if (!verifyModule()) {
+            return nullptr;
+        }
+
+        // Apply optimizations, unless the object file is cached
+        if (m_optLevel != OptLevel::O0 && !isCached(*m_module)) {
+            optimizeModule(*m_module);
+        }
+
+        // Compile the loop
+        llvm::orc::ThreadSafeModule module(std::move(m_module), m_threadSafeContext);
+        if (auto error = m_loopJIT->addIRModule(m_loopTracker, std::move(module))) {
+            reportError("JIT module loading failed: " + llvm::toString(std::move(error)));
+            return nullptr;
+        }
+
+        auto loopSymbol = m_loopJIT->lookup(name);
+        if (!loopSymbol) {
+            reportError("JIT symbol lookup failed: " + llvm::toString(loopSymbol.takeError()));
+            return nullptr;
+        }
+
+        return loopSymbol->toPtr<BrainfuckInterpreter::LoopFunction>();
+
+    } catch (const std::exception& e) {
+        reportError(std::string("Loop compilation error: ") + e.what());
+        return nullptr;
+    }
+}
+
+std::unique_ptr<BrainfuckCompiledProgram> BrainfuckCompiler::compileProgram(std::string_view source) {
+    try {
+        // Build Brainfuck IR
+        std::optional<BrainfuckProgram> program = buildProgram(source);
+        if (!program) {
+            return nullptr;
+        }
+
+        createModule();
+        if (m_freestanding) {
+            reportError("Freestanding builds produce executables and cannot be compiled for the library interface");
+            return nullptr;
+        }
+        if (!checkHostTarget("The library interface") || !checkNotProfiling("The library interface")) {
+            return nullptr;
+        }
+
+        // Guard faults are handled for the whole process and end it
+        if (m_boundsMode == BoundsMode::Guard) {
+            reportError("Guard mode is not available for the library interface, use check mode");
+            return nullptr;
+        }
+
+        // The code calls into the host runtime with the bf_io of each run
+        m_hostRuntime = true;
+        m_outlineLoops = false;
+        m_outlineColdLoops = false;
+        m_guardSize = 0;
+
+        if (m_cache) {
+            m_cache->setProgramKey(computeCacheKey(*program, "library"));
+        }
+
+        // Entry point: int bf_run(bf_io* io, cell_t* tape)
+        llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+        llvm::FunctionType* entryType = llvm::FunctionType::get(m_builder->getInt32Ty(), {ptrType, ptrType}, false);
+        m_mainFunction = llvm::Function::Create(entryType, llvm::Function::ExternalLinkage, "bf_run", m_module.get());
+        m_ioContext = m_mainFunction->getArg(0);
+
+        // The tape belongs to the run alone, so cells can stay in registers across runtime calls
+        m_mainFunction->addParamAttr(1, llvm::Attribute::NoAlias);
+        m_mainFunction->addParamAttr(1, llvm::Attribute::getWithAlignment(*m_context, llvm::Align(scanBlockSize)));
+
+        llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_context, "entry", m_mainFunction);
+        m_builder->SetInsertPoint(entryBlock);
+        setupRuntimeFunctions();
+        if (program->usesTape()) {
+            m_memoryArray = m_mainFunction->getArg(1);
+            initializeDataPointer(*program);
+        }
+
+        // Generate IR
+        {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "IR generation");
+            generateIR(*program);
+        }
+
+        // Verify IR
+        if (!verifyModule()) {
+            return nullptr;
+        }
+
+        // Compile the whole program now, runs never wait for the compiler
+        if (!createTargetMachine()) {
+            return nullptr;
+        }
+        if (m_optLevel != OptLevel::O0 && !isCached(*m_module)) {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "Optimization");
+            optimizeModule(*m_module);
+        }
+
+        BrainfuckTimeReport::Scope phase(m_timeReport, "JIT code generation");
+        std::unique_ptr<llvm::orc::LLJIT> jit = createJIT();
+        if (!jit) {
+            return nullptr;
+        }
+
+        llvm::orc::ThreadSafeModule module(std::move(m_module), m_threadSafeContext);
+        if (auto error = jit->addIRModule(std::move(module))) {
+            reportError("JIT module loading failed: " + llvm::toString(std::move(error)));
+            return nullptr;
+        }
+
+        auto entrySymbol = jit->lookup("bf_run");
+        if (!entrySymbol) {
+            reportError("JIT symbol lookup failed: " + llvm::toString(entrySymbol.takeError()));
+            return nullptr;
+        }
+
+        // Tapes are padded to whole scan blocks, like the arrays of generated executables
+        unsigned cellBytes = m_cellBits / 8;
+        std::size_t tapeSize = llvm::alignTo(m_memorySize, scanBlockSize / cellBytes) * cellBytes;
+        auto entry = entrySymbol->toPtr<BrainfuckCompiledProgram::EntryFunction>();
+        return std::make_unique<BrainfuckCompiledProgram>(std::move(jit), entry, tapeSize, scanBlockSize);
+
+    } catch (const std::exception& e) {
+        reportError(std::string("Compilation error: ") + e.what());
+        return nullptr;
+    }
+}
+
+bool BrainfuckCompiler::compileBundle(const std::vector<BundleProgram>& programs, std::string_view outputFile,
+                                      BundleKind kind) {
+    try {
+        if (programs.empty()) {
+            reportError("A bundle needs at least one program");
+            return false;
+        }
+        if (m_backend == Backend::Fast) {
+            reportError("Bundles are built by the LLVM backend");
+            return false;
+        }
+        if (m_freestanding) {
+            reportError("Freestanding builds cannot be bundled");
+            return false;
+        }
+        if (m_enableDebugInfo || !m_profileFile.empty() || m_profile) {
+            reportError("Debug info and profiles are not available for bundles");
+            return false;
+        }
+
+        // Mapped tapes are never unmapped and install fault handlers, which belong to executables, not to hosts
+        bool mappedTape = m_tapeStorage == TapeStorage::Mmap || m_tapeStorage == TapeStorage::Grow ||
+                          m_boundsMode == BoundsMode::Guard;
+        if (kind == BundleKind::SharedLibrary && mappedTape) {
+            reportError("Shared objects need stack or static tapes and cannot use guard mode");
+            return false;
+        }
+
+        // Build the Brainfuck IR of every program first, errors are reported before any code generation
+        std::vector<BrainfuckProgram> built;
+        std::vector<std::string> entryNames;
+        for (const BundleProgram& program : programs) {
+            std::string entryName = getBundleEntryName(program.name);
+            if (program.name.empty() || llvm::is_contained(entryNames, entryName)) {
+                reportError("Bundled programs need distinct names: '" + program.name + "'");
+                return false;
+            }
+            std::optional<BrainfuckProgram> parsed = buildProgram(program.source);
+            if (!parsed) {
+                reportError("Program '" + program.name + "' cannot be compiled");
+                return false;
+            }
+            built.push_back(std::move(*parsed));
+            entryNames.push_back(std::move(entryName));
+        }
+
+        createModule();
+        m_hostRuntime = false;
+        m_outlineLoops = false;
+        m_outlineColdLoops = false;
+        m_linkShared = kind == BundleKind::SharedLibrary;
+        auto resetLink = llvm::make_scope_exit([this] {
+            m_linkShared = false;
+        });
+
+        // The bundle is cached as a whole, under the keys of its programs
+        if (m_cache) {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "Cache lookup");
+            llvm::SHA256 hasher;
+            hasher.update(kind == BundleKind::SharedLibrary ? "shared" : "bundle");
+            for (std::size_t i = 0; i < built.size(); ++i) {
+                std::string part = programs[i].name;
+                part += '\0';
+                part += computeCacheKey(built[i], "exe");
+                hasher.update(part);
+            }
+            m_cache->setProgramKey(llvm::toHex(hasher.final(), true));
+            if (m_cache->loadExecutable(outputFile)) {
+                std::cout << "Compilation completed (cached): " << outputFile << std::endl;
+                return true;
+            }
+        }
+
+        {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "IR generation");
+
+            // One runtime for all programs, each program gets an entry function and a tape of its own
+            setupRuntimeFunctions();
+            auto linkage =
+                kind == BundleKind::SharedLibrary ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+            llvm::FunctionType* entryType = llvm::FunctionType::get(m_builder->getInt32Ty(), false);
+            std::vector<llvm::Function*> entries;
+            for (std::size_t i = 0; i < built.size(); ++i) {
+                const BrainfuckProgram& program = built[i];
+                m_mainFunction = llvm::Function::Create(entryType, linkage, entryNames[i], m_module.get());
+                m_builder->SetInsertPoint(llvm::BasicBlock::Create(*m_context, "entry", m_mainFunction));
+
+                // Kept out of main, so a run only touches the pages of its own program
+                if (kind == BundleKind::Executable) {
+                    m_mainFunction->addFnAttr(llvm::Attribute::NoInline);
+                }
+
+                m_guardSize =
+                    m_boundsMode == BoundsMode::Guard ? (program.maxAccessStride() + 1) * (m_cellBits / 8) : 0;
+                if (program.usesTape() && !allocateMemory(program)) {
+                    return false;
+                }
+                generateIR(program);
+                entries.push_back(m_mainFunction);
+            }
+
+            if (kind == BundleKind::Executable) {
+                defineBundleMain(programs, entries);
+            }
+        }
+
+        if (!verifyModule() || !createTargetMachine()) {
+            return false;
+        }
+
+        return emitObjectFile(outputFile);
+
+    } catch (const std::exception& e) {
+        reportError(std::string("Compilation error: ") + e.what());
+        return false;
+    }
+}
+
+void BrainfuckCompiler::createMainFunction() {
+    // Create main function: int main()
+    llvm::FunctionType* mainType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*m_context), // Return type
+                                                           false // Not variadic
+    );
+
+    m_mainFunction = llvm::Function::Create(mainType, llvm::Function::ExternalLinkage, "main", m_module.get());
+
+    // Create entry basic block
+    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_context, "entry", m_mainFunction);
+
+    m_builder->SetInsertPoint(entryBlock);
+}
+
+void BrainfuckCompiler::defineBundleMain(const std::vector<BundleProgram>& programs,
+                                         const std::vector<llvm::Function*>& entries) {
+    llvm::Type* intType = m_builder->getInt32Ty();
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::FunctionCallee strcmpFunc =
+        getSystemFunction("strcmp", llvm::FunctionType::get(intType, {ptrType, ptrType}, false));
+    llvm::FunctionCallee strrchrFunc =
+        getSystemFunction("strrchr", llvm::FunctionType::get(ptrType, {ptrType, intType}, false));
+    llvm::FunctionCallee writeFunc =
+        getSystemFunction("write", llvm::FunctionType::get(sizeType, {intType, ptrType, sizeType}, false));
+
+    // int main(int argc, char** argv)
+    llvm::Function* main = llvm::Function::Create(llvm::FunctionType::get(intType, {intType, ptrType}, false),
+                                                  llvm::Function::ExternalLinkage, "main", m_module.get());
+    llvm::Value* argc = main->getArg(0);
+    llvm::Value* argv = main->getArg(1);
+    llvm::IRBuilder<> builder(*m_context);
+
+    // Each program runs in a block of its own and returns its status
+    std::vector<llvm::BasicBlock*> runBlocks;
+    std::vector<llvm::Constant*> names;
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        runBlocks.push_back(llvm::BasicBlock::Create(*m_context, "run", main));
+        builder.SetInsertPoint(runBlocks.back());
+        builder.CreateRet(builder.CreateCall(entries[i], {}, "status"));
+        names.push_back(builder.CreateGlobalString(programs[i].name, "bf_program_name"));
+    }
+
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", main, runBlocks.front());
+    llvm::BasicBlock* byCommand = llvm::BasicBlock::Create(*m_context, "by_command", main);
+    llvm::BasicBlock* checkArgument = llvm::BasicBlock::Create(*m_context, "check_argument", main);
+    llvm::BasicBlock* byArgument = llvm::BasicBlock::Create(*m_context, "by_argument", main);
+    llvm::BasicBlock* unknown = llvm::BasicBlock::Create(*m_context, "unknown", main);
+
+    // Compare a name with the program names in order, running the first program that matches
+    auto emitLookup = [&](llvm::Value* name, llvm::BasicBlock* notFound) {
+        for (std::size_t i = 0; i < programs.size(); ++i) {
+            llvm::Value* order = builder.CreateCall(strcmpFunc, {name, names[i]}, "order");
+            llvm::BasicBlock* next =
+                i + 1 < programs.size() ? llvm::BasicBlock::Create(*m_context, "next", main) : notFound;
+            builder.CreateCondBr(builder.CreateICmpEQ(order, builder.getInt32(0)), runBlocks[i], next);
+            builder.SetInsertPoint(next);
+        }
+    };
+
+    builder.SetInsertPoint(entry);
+    builder.CreateCondBr(builder.CreateICmpSGT(argc, builder.getInt32(0)), byCommand, unknown);
+
+    // The command name is the basename of argv[0], as for links to the bundle named after a program
+    builder.SetInsertPoint(byCommand);
+    llvm::Value* path = builder.CreateLoad(ptrType, argv, "path");
+    llvm::Value* slash = builder.CreateCall(strrchrFunc, {path, builder.getInt32('/')}, "slash");
+    llvm::Value* command = builder.CreateSelect(builder.CreateIsNull(slash), path,
+                                                builder.CreateConstInBoundsGEP1_64(builder.getInt8Ty(), slash, 1),
+                                                "command");
+    emitLookup(command, checkArgument);
+
+    // Otherwise the first argument names the program
+    builder.SetInsertPoint(checkArgument);
+    builder.CreateCondBr(builder.CreateICmpSGT(argc, builder.getInt32(1)), byArgument, unknown);
+    builder.SetInsertPoint(byArgument);
+    llvm::Value* argument =
+        builder.CreateLoad(ptrType, builder.CreateConstInBoundsGEP1_64(ptrType, argv, 1), "argument");
+    emitLookup(argument, unknown);
+
+    // No program matches, list the programs on stderr
+    std::string usage = "Usage: <program> or <bundle> <program>, programs:";
+    for (const BundleProgram& program : programs) {
+        usage += " " + program.name;
+    }
+    usage += "\n";
+    builder.SetInsertPoint(unknown);
+    builder.CreateCall(writeFunc, {builder.getInt32(2), builder.CreateGlobalString(usage, "bf_bundle_usage"),
+                                   llvm::ConstantInt::get(sizeType, usage.size())});
+    builder.CreateRet(builder.getInt32(1));
+}
+
+bool BrainfuckCompiler::allocateMemory(const BrainfuckProgram& program) {
+    llvm::Type* cellType = getCellType();
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    unsigned cellBytes = m_cellBits / 8;
+
+    // Arrays are padded to whole scan blocks, so block loads stay inside them
+    std::size_t arrayCells = llvm::alignTo(m_memorySize, scanBlockSize / cellBytes);
+    llvm::ArrayType* memoryArrayType = llvm::ArrayType::get(cellType, arrayCells);
+    llvm::Value* size = llvm::ConstantInt::get(sizeType, m_memorySize * cellBytes); // In bytes
+
+    // Guard regions need a mapped tape
+    TapeStorage storage = m_tapeStorage;
+    if (m_boundsMode == BoundsMode::Guard && (storage == TapeStorage::Stack || storage == TapeStorage::Static)) {
+        storage = TapeStorage::Mmap;
+    }
+
+    switch (storage) {
+    case TapeStorage::Stack: {
+        // cell_t memory[memorySize], initialized to 0 using memset
+        llvm::AllocaInst* memory = m_builder->CreateAlloca(memoryArrayType, nullptr, "memory");
+        memory->setAlignment(llvm::Align(scanBlockSize));
+        m_memoryArray = memory;
+        m_builder->CreateMemSet(m_memoryArray, m_builder->getInt8(0), arrayCells * cellBytes,
+                                llvm::MaybeAlign(scanBlockSize), false);
+        break;
+    }
+    case TapeStorage::Static: {
+        // Zero-initialized global, placed in .bss and cleared by the loader
+        auto* memory = new llvm::GlobalVariable(*m_module, memoryArrayType, false, llvm::GlobalValue::InternalLinkage,
+                                                llvm::ConstantAggregateZero::get(memoryArrayType), "memory");
+        memory->setAlignment(llvm::Align(scanBlockSize));
+        m_memoryArray = memory;
+
+        // Entry points of shared objects run any number of times, each run starts on a zero tape
+        if (m_linkShared) {
+            m_builder->CreateMemSet(m_memoryArray, m_builder->getInt8(0), arrayCells * cellBytes,
+                                    llvm::MaybeAlign(scanBlockSize), false);
+        }
+        break;
+    }
+    case TapeStorage::Mmap:
+    case TapeStorage::Grow: {
+        if (!m_hostRuntime && m_module->getTargetTriple().isOSWindows()) {
+            reportError("Mapped tapes require a POSIX target");
+            return false;
+        }
+
+        // uint8_t* bf_tape_alloc(size_t size, size_t guardSize, uint32_t flags), shared by the programs of a bundle
+        if (!m_tapeAllocFunc) {
+            auto linkage = m_hostRuntime ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+            m_tapeAllocFunc = llvm::Function::Create(
+                llvm::FunctionType::get(ptrType, {sizeType, sizeType, m_builder->getInt32Ty()}, false), linkage,
+                "bf_tape_alloc", m_module.get());
+            if (!m_hostRuntime) {
+                defineTapeFunctions();
+            }
+        }
+
+        llvm::Value* guardSize = llvm::ConstantInt::get(sizeType, m_guardSize);
+        llvm::Value* flags = m_builder->getInt32((storage == TapeStorage::Grow ? BF_TAPE_GROWABLE : 0) |
+                                                 llvm::Log2_32(cellBytes) << BF_TAPE_CELL_SHIFT);
+        m_memoryArray = m_builder->CreateCall(m_tapeAllocFunc, {size, guardSize, flags}, "memory");
+
+        // Exit with status 1 if the tape cannot be mapped, the runtime reports the error
+        llvm::BasicBlock* failed = llvm::BasicBlock::Create(*m_context, "tape_failed", m_mainFunction);
+        llvm::BasicBlock* mapped = llvm::BasicBlock::Create(*m_context, "tape_mapped", m_mainFunction);
+        m_builder->CreateCondBr(m_builder->CreateIsNull(m_memoryArray), failed, mapped);
+        m_builder->SetInsertPoint(failed);
+        m_builder->CreateRet(m_builder->getInt32(1));
+        m_builder->SetInsertPoint(mapped);
+
+        // The host process outlives the program, so JIT code unmaps the tape again
+        if (m_hostRuntime) {
+            m_tapeFreeFunc = llvm::Function::Create(
+                llvm::FunctionType::get(m_builder->getVoidTy(), {ptrType, sizeType, sizeType, m_builder->getInt32Ty()},
+                                        false),
+                llvm::Function::ExternalLinkage, "bf_tape_free", m_module.get());
+            m_tapeFreeArgs = {m_memoryArray, size, guardSize, flags};
+        }
+        break;
+    }
+    }
+
+    // Loops outlined from main and loops compiled by the tiered interpreter check against the host's tape
+    if (m_boundsTapeVar) {
+        m_builder->CreateStore(m_memoryArray, m_boundsTapeVar);
+    }
+
+    initializeDataPointer(program);
+    return true;
+}
+
+void BrainfuckCompiler::initializeDataPointer(const BrainfuckProgram& program) {
+    llvm::Type* cellType = getCellType();
+    llvm::Type* sizeType = getSizeType();
+    unsigned cellBytes = m_cellBits / 8;
+
+    // Initialize data pointer to middle of memory: cell_t* dataPtr = &memory[memorySize/2]
+    // The pointer lives in an SSA value, loops carry it through PHI nodes
+    llvm::Value* origin = m_builder->CreateInBoundsGEP(
+        cellType, m_memoryArray, llvm::ConstantInt::get(sizeType, m_memorySize / 2), "origin");
+
+    // Copy the tape state left by the precomputed program prefix
+    const std::vector<std::uint64_t>& initialTape = program.initialTape();
+    if (!initialTape.empty()) {
+        llvm::Constant* image = createTapeImage(initialTape);
+        auto* imageGlobal = new llvm::GlobalVariable(*m_module, image->getType(), true,
+                                                     llvm::GlobalValue::PrivateLinkage, image, "initial_tape");
+        imageGlobal->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+
+        llvm::Value* imageStart = m_builder->CreateInBoundsGEP(
+            cellType, origin, m_builder->getInt64(program.initialTapeOffset()), "initial_tape_ptr");
+        m_builder->CreateMemCpy(imageStart, llvm::MaybeAlign(cellBytes), imageGlobal, llvm::MaybeAlign(cellBytes),
+                                llvm::ConstantInt::get(sizeType, initialTape.size() * cellBytes));
+    }
+
+    m_dataPtr =
+        m_builder->CreateInBoundsGEP(cellType, origin, m_builder->getInt64(program.initialPointer()), "initial_ptr");
+}
+
+void BrainfuckCompiler::setupRuntimeFunctions() {
+    llvm::Type* voidType = llvm::Type::getVoidTy(*m_context);
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+
+    // JIT-compiled code calls into the host runtime, native executables carry their own copy
+    auto linkage = m_hostRuntime ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+
+    // The library interface passes the bf_io of the run first
+    std::vector<llvm::Type*> context;
+    const char* prefix = "bf_";
+    if (m_ioContext) {
+        context.push_back(ptrType);
+        prefix = "bf_io_";
+    }
+    auto create = [&](llvm::Type* result, std::vector<llvm::Type*> params, const char* name) {
+        params.insert(params.begin(), context.begin(), context.end());
+        return llvm::Function::Create(llvm::FunctionType::get(result, params, false), linkage,
+                                      std::string(prefix) + name, m_module.get());
+    };
+
+    // void bf_output(int8_t value)
+    m_outputFunc = create(voidType, {byteType}, "output");
+
+    // void bf_write(const int8_t* data, size_t size)
+    m_writeFunc = create(voidType, {ptrType, sizeType}, "write");
+
+    // int8_t bf_input()
+    m_inputFunc = create(byteType, {}, "input");
+
+    // void bf_flush()
+    m_flushFunc = create(voidType, {}, "flush");
+
+    if (!m_hostRuntime) {
+        defineRuntimeFunctions();
+    }
+
+    setupBoundsFunctions();
+}
+
+llvm::CallInst* BrainfuckCompiler::callRuntime(llvm::Function* function, llvm::ArrayRef<llvm::Value*> args,
+                                               const llvm::Twine& name) {
+    if (!m_ioContext) {
+        return m_builder->CreateCall(function, args, name);
+    }
+
+    llvm::SmallVector<llvm::Value*, 4> ioArgs{m_ioContext};
+    ioArgs.append(args.begin(), args.end());
+    return m_builder->CreateCall(function, ioArgs, name);
+}
+
+llvm::IntegerType* BrainfuckCompiler::getCellType() {
+    return llvm::Type::getIntNTy(*m_context, m_cellBits);
+}
+
+llvm::ConstantInt* BrainfuckCompiler::getCellConstant(std::int64_t value) {
+    std::uint64_t mask = llvm::maskTrailingOnes<std::uint64_t>(m_cellBits);
+    return llvm::ConstantInt::get(getCellType(), static_cast<std::uint64_t>(value) & mask);
+}
+
+llvm::Constant* BrainfuckCompiler::createTapeImage(const std::vector<std::uint64_t>& cells) {
+    // Constant array of the cell width, values are already wrapped to it
+    auto create = [&](auto cell) {
+        std::vector<decltype(cell)> image(cells.begin(), cells.end());
+        return llvm::ConstantDataArray::get(*m_context, image);
+    };
+
+    switch (m_cellBits) {
+    case 16:
+        return create(std::uint16_t{});
+    case 32:
+        return create(std::uint32_t{});
+    case 64:
+        return create(std::uint64_t{});
+    default:
+        return create(std::uint8_t{});
+    }
+}
+
+llvm::Type* BrainfuckCompiler::getSizeType() {
+    return llvm::Type::getIntNTy(*m_context, m_module->getTargetTriple().isArch64Bit() ? 64 : 32);
+}
+
+void BrainfuckCompiler::defineRuntimeFunctions() {
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::IRBuilder<> builder(*m_context);
+
+    // ssize_t write(int fd, const void* data, size_t size), ssize_t read(int fd, void* data, size_t size)
+    llvm::FunctionType* ioType = llvm::FunctionType::get(sizeType, {intType, ptrType, sizeType}, false);
+    llvm::FunctionCallee writeFunc = getSystemFunction("write", ioType);
+    llvm::FunctionCallee readFunc = getSystemFunction("read", ioType);
+
+    // Runtime state
+    llvm::ArrayType* bufferType = llvm::ArrayType::get(byteType, BF_RUNTIME_BUFFER_SIZE);
+    auto createGlobal = [&](llvm::Type* type, const char* name) {
+        return new llvm::GlobalVariable(*m_module, type, false, llvm::GlobalValue::InternalLinkage,
+                                        llvm::Constant::getNullValue(type), name);
+    };
+    llvm::GlobalVariable* outputBuffer = createGlobal(bufferType, "bf_output_buffer");
+    llvm::GlobalVariable* outputLength = createGlobal(sizeType, "bf_output_length");
+    llvm::GlobalVariable* inputBuffer = createGlobal(bufferType, "bf_input_buffer");
+    llvm::GlobalVariable* inputPos = createGlobal(sizeType, "bf_input_pos");
+    llvm::GlobalVariable* inputEnd = createGlobal(sizeType, "bf_input_end");
+
+    llvm::Value* zeroSize = llvm::ConstantInt::get(sizeType, 0);
+    llvm::Value* bufferSize = llvm::ConstantInt::get(sizeType, BF_RUNTIME_BUFFER_SIZE);
+
+    // bf_flush: write the whole output buffer, retrying partial writes
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_flushFunc);
+        llvm::BasicBlock* writeLoop = llvm::BasicBlock::Create(*m_context, "write_loop", m_flushFunc);
+        llvm::BasicBlock* writeNext = llvm::BasicBlock::Create(*m_context, "write_next", m_flushFunc);
+        llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", m_flushFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* length = builder.CreateLoad(sizeType, outputLength, "length");
+        builder.CreateCondBr(builder.CreateICmpEQ(length, zeroSize), done, writeLoop);
+
+        builder.SetInsertPoint(writeLoop);
+        llvm::PHINode* written = builder.CreatePHI(sizeType, 2, "written");
+        written->addIncoming(zeroSize, entry);
+        llvm::Value* data = builder.CreateInBoundsGEP(byteType, outputBuffer, written, "data");
+        llvm::Value* result = builder.CreateCall(
+            writeFunc, {llvm::ConstantInt::get(intType, 1), data, builder.CreateSub(length, written)}, "result");
+        builder.CreateCondBr(builder.CreateICmpSLE(result, zeroSize), done, writeNext);
+
+        builder.SetInsertPoint(writeNext);
+        llvm::Value* nextWritten = builder.CreateAdd(written, result, "next_written");
+        written->addIncoming(nextWritten, writeNext);
+        builder.CreateCondBr(builder.CreateICmpULT(nextWritten, length), writeLoop, done);
+
+        builder.SetInsertPoint(done);
+        builder.CreateStore(zeroSize, outputLength);
+        builder.CreateRetVoid();
+    }
+
+    // bf_output: append one byte, flushing a full buffer first
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_outputFunc);
+        llvm::BasicBlock* flush = llvm::BasicBlock::Create(*m_context, "flush", m_outputFunc);
+        llvm::BasicBlock* append = llvm::BasicBlock::Create(*m_context, "append", m_outputFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* length = builder.CreateLoad(sizeType, outputLength, "length");
+        builder.CreateCondBr(builder.CreateICmpEQ(length, bufferSize), flush, append);
+
+        builder.SetInsertPoint(flush);
+        builder.CreateCall(m_flushFunc);
+        builder.CreateBr(append);
+
+        builder.SetInsertPoint(append);
+        llvm::Value* current = builder.CreateLoad(sizeType, outputLength, "current");
+        builder.CreateStore(m_outputFunc->getArg(0), builder.CreateInBoundsGEP(byteType, outputBuffer, current));
+        builder.CreateStore(builder.CreateAdd(current, llvm::ConstantInt::get(sizeType, 1)), outputLength);
+        builder.CreateRetVoid();
+    }
+
+    // bf_write: copy a constant string into the output buffer in buffer-sized chunks
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_writeFunc);
+        llvm::BasicBlock* copyLoop = llvm::BasicBlock::Create(*m_context, "copy_loop", m_writeFunc);
+        llvm::BasicBlock* checkSpace = llvm::BasicBlock::Create(*m_context, "check_space", m_writeFunc);
+        llvm::BasicBlock* flush = llvm::BasicBlock::Create(*m_context, "flush", m_writeFunc);
+        llvm::BasicBlock* copy = llvm::BasicBlock::Create(*m_context, "copy", m_writeFunc);
+        llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", m_writeFunc);
+
+        builder.SetInsertPoint(entry);
+        builder.CreateBr(copyLoop);
+
+        builder.SetInsertPoint(copyLoop);
+        llvm::PHINode* data = builder.CreatePHI(ptrType, 2, "data");
+        llvm::PHINode* remaining = builder.CreatePHI(sizeType, 2, "remaining");
+        data->addIncoming(m_writeFunc->getArg(0), entry);
+        remaining->addIncoming(m_writeFunc->getArg(1), entry);
+        builder.CreateCondBr(builder.CreateICmpEQ(remaining, zeroSize), done, checkSpace);
+
+        builder.SetInsertPoint(checkSpace);
+        llvm::Value* length = builder.CreateLoad(sizeType, outputLength, "length");
+        builder.CreateCondBr(builder.CreateICmpEQ(length, bufferSize), flush, copy);
+
+        builder.SetInsertPoint(flush);
+        builder.CreateCall(m_flushFunc);
+        builder.CreateBr(copy);
+
+        builder.SetInsertPoint(copy);
+        llvm::Value* current = builder.CreateLoad(sizeType, outputLength, "current");
+        llvm::Value* space = builder.CreateSub(bufferSize, current, "space");
+        llvm::Value* chunk =
+            builder.CreateSelect(builder.CreateICmpULT(remaining, space), remaining, space, "chunk");
+        builder.CreateMemCpy(builder.CreateInBoundsGEP(byteType, outputBuffer, current), llvm::MaybeAlign(1), data,
+                             llvm::MaybeAlign(1), chunk);
+        builder.CreateStore(builder.CreateAdd(current, chunk), outputLength);
+        data->addIncoming(builder.CreateInBoundsGEP(byteType, data, chunk), copy);
+        remaining->addIncoming(builder.CreateSub(remaining, chunk), copy);
+        builder.CreateBr(copyLoop);
+
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+
+    // bf_input: return the next input byte, reading a new block when the buffer is empty, 255 at end of input
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_inputFunc);
+        llvm::BasicBlock* refill = llvm::BasicBlock::Create(*m_context, "refill", m_inputFunc);
+        llvm::BasicBlock* endOfInput = llvm::BasicBlock::Create(*m_context, "end_of_input", m_inputFunc);
+        llvm::BasicBlock* filled = llvm::BasicBlock::Create(*m_context, "filled", m_inputFunc);
+        llvm::BasicBlock* next = llvm::BasicBlock::Create(*m_context, "next", m_inputFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* pos = builder.CreateLoad(sizeType, inputPos, "pos");
+        llvm::Value* end = builder.CreateLoad(sizeType, inputEnd, "end");
+        builder.CreateCondBr(builder.CreateICmpEQ(pos, end), refill, next);
+
+        // Prompts written so far must be visible before blocking on input
+        builder.SetInsertPoint(refill);
+        builder.CreateCall(m_flushFunc);
+        llvm::Value* result =
+            builder.CreateCall(readFunc, {llvm::ConstantInt::get(intType, 0), inputBuffer, bufferSize}, "result");
+        builder.CreateCondBr(builder.CreateICmpSLE(result, zeroSize), endOfInput, filled);
+
+        builder.SetInsertPoint(endOfInput);
+        builder.CreateRet(llvm::ConstantInt::get(byteType, 255));
+
+        builder.SetInsertPoint(filled);
+        builder.CreateStore(zeroSize, inputPos);
+        builder.CreateStore(result, inputEnd);
+        builder.CreateBr(next);
+
+        builder.SetInsertPoint(next);
+        llvm::Value* current = builder.CreateLoad(sizeType, inputPos, "current");
+        llvm::Value* value =
+            builder.CreateLoad(byteType, builder.CreateInBoundsGEP(byteType, inputBuffer, current), "value");
+        builder.CreateStore(builder.CreateAdd(current, llvm::ConstantInt::get(sizeType, 1)), inputPos);
+        builder.CreateRet(value);
+    }
+}
+
+void BrainfuckCompiler::setupBoundsFunctions() {
+    if (m_boundsMode == BoundsMode::None) {
+        return;
+    }
+
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    auto linkage = m_hostRuntime ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+
+    // void bf_bounds_error(int64_t cell, size_t sourcePos), never returns
+    // void bf_io_bounds_error(bf_io* io, int64_t cell, size_t sourcePos) of the library interface records the access
+    if (m_ioContext) {
+        m_boundsErrorFunc = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(*m_context),
+                                    {ptrType, llvm::Type::getInt64Ty(*m_context), sizeType}, false),
+            linkage, "bf_io_bounds_error", m_module.get());
+    } else {
+        m_boundsErrorFunc = llvm::Function::Create(
+            llvm::FunctionType::get(llvm::Type::getVoidTy(*m_context), {llvm::Type::getInt64Ty(*m_context), sizeType},
+                                    false),
+            linkage, "bf_bounds_error", m_module.get());
+        m_boundsErrorFunc->setDoesNotReturn();
+    }
+    m_boundsErrorFunc->addFnAttr(llvm::Attribute::Cold);
+
+    // size_t bf_source_pos, the source position of the last loop boundary
+    if (m_boundsMode == BoundsMode::Guard) {
+        m_sourcePosVar =
+            new llvm::GlobalVariable(*m_module, sizeType, false, linkage,
+                                     m_hostRuntime ? nullptr : llvm::Constant::getNullValue(sizeType), "bf_source_pos");
+    }
+
+    // int8_t* bf_bounds_tape, the tape of code running outside main
+    if (m_boundsMode == BoundsMode::Check && (m_hostRuntime || m_outlineLoops || m_outlineColdLoops) &&
+        !m_ioContext) {
+        m_boundsTapeVar =
+            new llvm::GlobalVariable(*m_module, ptrType, false, linkage,
+                                     m_hostRuntime ? nullptr : llvm::Constant::getNullValue(ptrType), "bf_bounds_tape");
+    }
+
+    if (!m_hostRuntime) {
+        defineBoundsFunctions();
+    }
+}
+
+void BrainfuckCompiler::defineBoundsFunctions() {
+    llvm::Type* voidType = llvm::Type::getVoidTy(*m_context);
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* longType = llvm::Type::getInt64Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::IRBuilder<> builder(*m_context);
+
+    // ssize_t write(int fd, const void* data, size_t size), void _Exit(int status)
+    llvm::FunctionCallee writeFunc =
+        getSystemFunction("write", llvm::FunctionType::get(sizeType, {intType, ptrType, sizeType}, false));
+    llvm::FunctionCallee exitFunc = getSystemFunction("_Exit", llvm::FunctionType::get(voidType, {intType}, false));
+
+    // bf_write_number: write a signed decimal number to stderr
+    constexpr unsigned numberSize = 24;
+    llvm::Function* numberFunc = llvm::Function::Create(llvm::FunctionType::get(voidType, {longType}, false),
+                                                        llvm::Function::InternalLinkage, "bf_write_number",
+                                                        m_module.get());
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", numberFunc);
+        llvm::BasicBlock* digitLoop = llvm::BasicBlock::Create(*m_context, "digit_loop", numberFunc);
+        llvm::BasicBlock* sign = llvm::BasicBlock::Create(*m_context, "sign", numberFunc);
+        llvm::BasicBlock* minus = llvm::BasicBlock::Create(*m_context, "minus", numberFunc);
+        llvm::BasicBlock* write = llvm::BasicBlock::Create(*m_context, "write", numberFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* buffer = builder.CreateAlloca(llvm::ArrayType::get(byteType, numberSize), nullptr, "buffer");
+        llvm::Value* value = numberFunc->getArg(0);
+        llvm::Value* negative = builder.CreateICmpSLT(value, builder.getInt64(0), "negative");
+        llvm::Value* magnitude = builder.CreateSelect(negative, builder.CreateNeg(value), value, "magnitude");
+        builder.CreateBr(digitLoop);
+
+        // Digits are produced from the end of the buffer
+        builder.SetInsertPoint(digitLoop);
+        llvm::PHINode* pos = builder.CreatePHI(longType, 2, "pos");
+        llvm::PHINode* rest = builder.CreatePHI(longType, 2, "rest");
+        pos->addIncoming(builder.getInt64(numberSize), entry);
+        rest->addIncoming(magnitude, entry);
+        llvm::Value* digitPos = builder.CreateSub(pos, builder.getInt64(1), "digit_pos");
+        llvm::Value* digit = builder.CreateTrunc(builder.CreateURem(rest, builder.getInt64(10)), byteType);
+        builder.CreateStore(builder.CreateAdd(digit, builder.getInt8('0')),
+                            builder.CreateInBoundsGEP(byteType, buffer, digitPos));
+        llvm::Value* nextRest = builder.CreateUDiv(rest, builder.getInt64(10), "next_rest");
+        pos->addIncoming(digitPos, digitLoop);
+        rest->addIncoming(nextRest, digitLoop);
+        builder.CreateCondBr(builder.CreateICmpNE(nextRest, builder.getInt64(0)), digitLoop, sign);
+
+        builder.SetInsertPoint(sign);
+        builder.CreateCondBr(negative, minus, write);
+
+        builder.SetInsertPoint(minus);
+        llvm::Value* minusPos = builder.CreateSub(digitPos, builder.getInt64(1), "minus_pos");
+        builder.CreateStore(builder.getInt8('-'), builder.CreateInBoundsGEP(byteType, buffer, minusPos));
+        builder.CreateBr(write);
+
+        builder.SetInsertPoint(write);
+        llvm::PHINode* start = builder.CreatePHI(longType, 2, "start");
+        start->addIncoming(digitPos, sign);
+        start->addIncoming(minusPos, minus);
+        llvm::Value* length =
+            builder.CreateZExtOrTrunc(builder.CreateSub(builder.getInt64(numberSize), start), sizeType, "length");
+        llvm::Value* digits = builder.CreateInBoundsGEP(byteType, buffer, start, "digits");
+        builder.CreateCall(writeFunc, {builder.getInt32(2), digits, length});
+        builder.CreateRetVoid();
+    }
+
+    // bf_bounds_error: flush the output, report the cell and source position, exit with status 1
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_boundsErrorFunc);
+        builder.SetInsertPoint(entry);
+        builder.CreateCall(m_flushFunc);
+
+        auto writeText = [&](std::string_view text, const char* name) {
+            builder.CreateCall(writeFunc, {builder.getInt32(2), builder.CreateGlobalString(text, name),
+                                           llvm::ConstantInt::get(sizeType, text.size())});
+        };
+        writeText("Error: tape access out of bounds at cell ", "bf_bounds_prefix");
+        builder.CreateCall(numberFunc, {m_boundsErrorFunc->getArg(0)});
+        writeText(" (source position ", "bf_bounds_middle");
+        builder.CreateCall(numberFunc, {builder.CreateZExtOrTrunc(m_boundsErrorFunc->getArg(1), longType)});
+        writeText(")\n", "bf_bounds_suffix");
+        builder.CreateCall(exitFunc, {builder.getInt32(1)});
+        builder.CreateUnreachable();
+    }
+}
+
+void BrainfuckCompiler::defineTapeFunctions() {
+    llvm::Type* voidType = llvm::Type::getVoidTy(*m_context);
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::IRBuilder<> builder(*m_context);
+
+    // Target constants of the POSIX calls below, Linux and Darwin layouts
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    bool darwin = triple.isOSDarwin();
+    unsigned pointerSize = triple.isArch64Bit() ? 8 : 4;
+    int protNone = 0;
+    int protReadWrite = 3;
+    int mapFlags = darwin ? 0x1002 : 0x4022; // MAP_PRIVATE | MAP_ANON (| MAP_NORESERVE on Linux)
+    int sigSegv = 11;
+    int sigBus = darwin ? 10 : 7;
+    int saSigInfo = darwin ? 0x40 : 4;
+    unsigned sigactionFlagsOffset = darwin ? 12 : pointerSize + 128; // After the handler and sa_mask
+    unsigned sigactionSize = darwin ? 16 : 2 * pointerSize + 136;
+    unsigned siginfoAddrOffset = darwin ? 24 : (pointerSize == 8 ? 16 : 12); // si_addr
+
+    // void* mmap(void*, size_t, int, int, int, off_t), int mprotect(void*, size_t, int)
+    llvm::FunctionCallee mmapFunc = getSystemFunction(
+        "mmap", llvm::FunctionType::get(ptrType, {ptrType, sizeType, intType, intType, intType, sizeType}, false));
+    llvm::FunctionCallee mprotectFunc =
+        getSystemFunction("mprotect", llvm::FunctionType::get(intType, {ptrType, sizeType, intType}, false));
+
+    // int sigaction(int, const struct sigaction*, struct sigaction*), void (*signal(int, void (*)(int)))(int)
+    llvm::FunctionCallee sigactionFunc =
+        getSystemFunction("sigaction", llvm::FunctionType::get(intType, {intType, ptrType, ptrType}, false));
+    llvm::FunctionCallee signalFunc =
+        getSystemFunction("signal", llvm::FunctionType::get(ptrType, {intType, ptrType}, false));
+    llvm::FunctionCallee writeFunc =
+        getSystemFunction("write", llvm::FunctionType::get(sizeType, {intType, ptrType, sizeType}, false));
+
+    // Mapped tape served by the fault handler
+    auto createGlobal = [&](llvm::Type* type, const char* name) {
+        return new llvm::GlobalVariable(*m_module, type, false, llvm::GlobalValue::InternalLinkage,
+                                        llvm::Constant::getNullValue(type), name);
+    };
+    llvm::GlobalVariable* tapeBase = createGlobal(ptrType, "bf_tape_base");
+    llvm::GlobalVariable* tapeSize = createGlobal(sizeType, "bf_tape_size");
+    llvm::GlobalVariable* tapeGuard = createGlobal(sizeType, "bf_tape_guard");
+    llvm::GlobalVariable* tapeGrowable = createGlobal(builder.getInt1Ty(), "bf_tape_growable");
+
+    llvm::Value* chunkSize = llvm::ConstantInt::get(sizeType, BF_TAPE_CHUNK_SIZE);
+    llvm::Value* chunkMask = llvm::ConstantInt::get(sizeType, ~(BF_TAPE_CHUNK_SIZE - 1));
+    auto roundToChunk = [&](llvm::Value* size, const char* name) {
+        return builder.CreateAnd(builder.CreateAdd(size, llvm::ConstantInt::get(sizeType, BF_TAPE_CHUNK_SIZE - 1)),
+                                 chunkMask, name);
+    };
+
+    // bf_tape_fault: commit the chunk of a growable tape, report guard accesses, rerun anything else
+    // without the handler
+    llvm::Function* faultFunc =
+        llvm::Function::Create(llvm::FunctionType::get(voidType, {intType, ptrType, ptrType}, false),
+                               llvm::Function::InternalLinkage, "bf_tape_fault", m_module.get());
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", faultFunc);
+        llvm::BasicBlock* commit = llvm::BasicBlock::Create(*m_context, "commit", faultFunc);
+        llvm::BasicBlock* checkGuard = llvm::BasicBlock::Create(*m_context, "check_guard", faultFunc);
+        llvm::BasicBlock* report = llvm::BasicBlock::Create(*m_context, "report", faultFunc);
+        llvm::BasicBlock* fallback = llvm::BasicBlock::Create(*m_context, "fallback", faultFunc);
+        llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", faultFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* address = builder.CreateLoad(
+            ptrType, builder.CreateConstInBoundsGEP1_32(byteType, faultFunc->getArg(1), siginfoAddrOffset), "address");
+        llvm::Value* base = builder.CreateLoad(ptrType, tapeBase, "base");
+        llvm::Value* size = builder.CreateLoad(sizeType, tapeSize, "size");
+        llvm::Value* guard = builder.CreateLoad(sizeType, tapeGuard, "guard");
+        llvm::Value* growable = builder.CreateLoad(builder.getInt1Ty(), tapeGrowable, "growable");
+        llvm::Value* cell = builder.CreateSub(builder.CreatePtrToInt(address, sizeType),
+                                              builder.CreatePtrToInt(base, sizeType), "cell");
+        builder.CreateCondBr(builder.CreateAnd(growable, builder.CreateICmpULT(cell, size)), commit, checkGuard);
+
+        builder.SetInsertPoint(commit);
+        llvm::Value* chunk = builder.CreateInBoundsGEP(byteType, base, builder.CreateAnd(cell, chunkMask));
+        llvm::Value* result = builder.CreateCall(mprotectFunc, {chunk, chunkSize, builder.getInt32(protReadWrite)});
+        builder.CreateCondBr(builder.CreateICmpEQ(result, builder.getInt32(0)), done, fallback);
+
+        // Guard regions cover [-guard, size + guard) around the tape
+        builder.SetInsertPoint(checkGuard);
+        llvm::Value* guardOffset = builder.CreateAdd(cell, guard, "guard_offset");
+        llvm::Value* guardEnd = builder.CreateAdd(size, builder.CreateShl(guard, 1), "guard_end");
+        builder.CreateCondBr(builder.CreateICmpULT(guardOffset, guardEnd), report, fallback);
+
+        builder.SetInsertPoint(report);
+        if (m_boundsErrorFunc && m_sourcePosVar) {
+            llvm::Value* sourcePos = builder.CreateLoad(sizeType, m_sourcePosVar, true, "source_pos");
+            llvm::Value* cellIndex = builder.CreateAShr(cell, llvm::Log2_32(m_cellBits / 8), "cell_index");
+            builder.CreateCall(m_boundsErrorFunc,
+                               {builder.CreateSExtOrTrunc(cellIndex, builder.getInt64Ty()), sourcePos});
+            builder.CreateUnreachable();
+        } else {
+            builder.CreateBr(fallback);
+        }
+
+        // SIG_DFL is a null handler
+        builder.SetInsertPoint(fallback);
+        builder.CreateCall(signalFunc, {faultFunc->getArg(0), llvm::Constant::getNullValue(ptrType)});
+        builder.CreateBr(done);
+
+        builder.SetInsertPoint(done);
+        builder.CreateRetVoid();
+    }
+
+    // bf_tape_alloc: map zero pages between guard regions, protected tapes install the fault handler
+    {
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_tapeAllocFunc);
+        llvm::BasicBlock* failed = llvm::BasicBlock::Create(*m_context, "failed", m_tapeAllocFunc);
+        llvm::BasicBlock* mapped = llvm::BasicBlock::Create(*m_context, "mapped", m_tapeAllocFunc);
+        llvm::BasicBlock* protectedTape = llvm::BasicBlock::Create(*m_context, "protected", m_tapeAllocFunc);
+        llvm::BasicBlock* commitAll = llvm::BasicBlock::Create(*m_context, "commit_all", m_tapeAllocFunc);
+        llvm::BasicBlock* install = llvm::BasicBlock::Create(*m_context, "install", m_tapeAllocFunc);
+        llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", m_tapeAllocFunc);
+
+        builder.SetInsertPoint(entry);
+        llvm::Value* action = builder.CreateAlloca(byteType, builder.getInt32(sigactionSize), "action");
+        llvm::Value* growable =
+            builder.CreateICmpNE(builder.CreateAnd(m_tapeAllocFunc->getArg(2), BF_TAPE_GROWABLE), builder.getInt32(0));
+        llvm::Value* size = roundToChunk(m_tapeAllocFunc->getArg(0), "size");
+        llvm::Value* guard = roundToChunk(m_tapeAllocFunc->getArg(1), "guard");
+        llvm::Value* mapSize = builder.CreateAdd(size, builder.CreateShl(guard, 1), "map_size");
+
+        // Plain tapes are mapped accessible, otherwise only the committed part is
+        llvm::Value* protect =
+            builder.CreateOr(growable, builder.CreateICmpNE(guard, llvm::ConstantInt::get(sizeType, 0)), "protect");
+        llvm::Value* prot =
+            builder.CreateSelect(protect, builder.getInt32(protNone), builder.getInt32(protReadWrite), "prot");
+        llvm::Value* region =
+            builder.CreateCall(mmapFunc,
+                               {llvm::Constant::getNullValue(ptrType), mapSize, prot, builder.getInt32(mapFlags),
+                                builder.getInt32(-1), llvm::ConstantInt::get(sizeType, 0)},
+                               "region");
+        // MAP_FAILED is -1, the system call of freestanding builds returns -errno, both are in [-4095, -1]
+        llvm::Value* mapFailed = builder.CreateICmpUGT(builder.CreatePtrToInt(region, sizeType),
+                                                       llvm::ConstantInt::getSigned(sizeType, -4096), "map_failed");
+        llvm::Value* tape = builder.CreateGEP(byteType, region, guard, "tape");
+        builder.CreateCondBr(mapFailed, failed, mapped);
+
+        builder.SetInsertPoint(failed);
+        static const char message[] = "Cannot allocate tape memory\n";
+        builder.CreateCall(writeFunc, {builder.getInt32(2), builder.CreateGlobalString(message, "bf_tape_error"),
+                                       llvm::ConstantInt::get(sizeType, sizeof(message) - 1)});
+        builder.CreateRet(llvm::Constant::getNullValue(ptrType));
+
+        builder.SetInsertPoint(mapped);
+        builder.CreateCondBr(protect, protectedTape, done);
+
+        // Guarded tapes that do not grow are committed up front
+        builder.SetInsertPoint(protectedTape);
+        builder.CreateCondBr(growable, install, commitAll);
+
+        builder.SetInsertPoint(commitAll);
+        llvm::Value* result = builder.CreateCall(mprotectFunc, {tape, size, builder.getInt32(protReadWrite)});
+        builder.CreateCondBr(builder.CreateICmpEQ(result, builder.getInt32(0)), install, failed);
+
+        builder.SetInsertPoint(install);
+        builder.CreateStore(tape, tapeBase);
+        builder.CreateStore(size, tapeSize);
+        builder.CreateStore(guard, tapeGuard);
+        builder.CreateStore(growable, tapeGrowable);
+        builder.CreateMemSet(action, builder.getInt8(0), sigactionSize, llvm::MaybeAlign(pointerSize));
+        builder.CreateStore(faultFunc, action);
+        builder.CreateStore(builder.getInt32(saSigInfo),
+                            builder.CreateConstInBoundsGEP1_32(byteType, action, sigactionFlagsOffset));
+        llvm::Value* noOldAction = llvm::Constant::getNullValue(ptrType);
+        builder.CreateCall(sigactionFunc, {builder.getInt32(sigSegv), action, noOldAction});
+        builder.CreateCall(sigactionFunc, {builder.getInt32(sigBus), action, noOldAction});
+        builder.CreateBr(done);
+
+        builder.SetInsertPoint(done);
+        builder.CreateRet(tape);
+    }
+}
+
+bool BrainfuckCompiler::setupProfile(const BrainfuckProgram& program) {
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+
+    if (!m_hostRuntime && m_module->getTargetTriple().isOSWindows()) {
+        reportError("Profiled executables require a POSIX target");
+        return false;
+    }
+
+    // uint64_t bf_profile[], the counters in the layout of the profile file. Mutable, so it exists once
+    // across partitions of parallel code generation.
+    std::vector<std::uint64_t> counters = BrainfuckProfile::createCounters(program, m_sourceHash);
+    llvm::Constant* initializer = llvm::ConstantDataArray::get(*m_context, counters);
+    m_profileVar = new llvm::GlobalVariable(*m_module, initializer->getType(), false,
+                                            llvm::GlobalValue::InternalLinkage, initializer, "bf_profile");
+    m_profileVar->setAlignment(llvm::Align(sizeof(std::uint64_t)));
+
+    // void bf_profile_write(const char* path, const uint64_t* counters, size_t size)
+    auto linkage = m_hostRuntime ? llvm::Function::ExternalLinkage : llvm::Function::InternalLinkage;
+    m_profileWriteFunc = llvm::Function::Create(
+        llvm::FunctionType::get(m_builder->getVoidTy(), {ptrType, ptrType, sizeType}, false), linkage,
+        "bf_profile_write", m_module.get());
+    if (!m_hostRuntime) {
+        defineProfileFunctions();
+    }
+
+    return true;
+}
+
+void BrainfuckCompiler::defineProfileFunctions() {
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::IRBuilder<> builder(*m_context);
+
+    // int creat(const char* path, mode_t mode), ssize_t write(int fd, const void* data, size_t size), int close(int fd)
+    llvm::FunctionCallee creatFunc =
+        getSystemFunction("creat", llvm::FunctionType::get(intType, {ptrType, intType}, false));
+    llvm::FunctionCallee writeFunc =
+        getSystemFunction("write", llvm::FunctionType::get(sizeType, {intType, ptrType, sizeType}, false));
+    llvm::FunctionCallee closeFunc = getSystemFunction("close", llvm::FunctionType::get(intType, {intType}, false));
+
+    // bf_profile_write: replace the profile file with the counters, report failures on stderr
+    llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", m_profileWriteFunc);
+    llvm::BasicBlock* opened = llvm::BasicBlock::Create(*m_context, "opened", m_profileWriteFunc);
+    llvm::BasicBlock* failed = llvm::BasicBlock::Create(*m_context, "failed", m_profileWriteFunc);
+    llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", m_profileWriteFunc);
+
+    builder.SetInsertPoint(entry);
+    llvm::Value* fd = builder.CreateCall(creatFunc, {m_profileWriteFunc->getArg(0), builder.getInt32(0644)}, "fd");
+    builder.CreateCondBr(builder.CreateICmpSLT(fd, builder.getInt32(0)), failed, opened);
+
+    // Regular files take the whole write at once, anything shorter is an error
+    builder.SetInsertPoint(opened);
+    llvm::Value* size = m_profileWriteFunc->getArg(2);
+    llvm::Value* written = builder.CreateCall(writeFunc, {fd, m_profileWriteFunc->getArg(1), size}, "written");
+    llvm::Value* closed = builder.CreateCall(closeFunc, {fd}, "closed");
+    llvm::Value* complete = builder.CreateAnd(builder.CreateICmpEQ(written, size),
+                                              builder.CreateICmpEQ(closed, builder.getInt32(0)), "complete");
+    builder.CreateCondBr(complete, done, failed);
+
+    builder.SetInsertPoint(failed);
+    std::string message = "Error: Cannot write profile " + m_profileFile + "\n";
+    builder.CreateCall(writeFunc, {builder.getInt32(2), builder.CreateGlobalString(message, "bf_profile_error"),
+                                   llvm::ConstantInt::get(sizeType, message.size())});
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    builder.CreateRetVoid();
+}
+
+llvm::FunctionCallee BrainfuckCompiler::getSystemFunction(llvm::StringRef name, llvm::FunctionType* type) {
+    // Hosted executables call the C library
+    if (!m_freestanding) {
+        return m_module->getOrInsertFunction(name, type);
+    }
+
+    // Freestanding executables get an internal replacement built on system calls
+    std::string replacementName = ("bf_sys_" + name).str();
+    if (llvm::Function* replacement = m_module->getFunction(replacementName)) {
+        return replacement;
+    }
+
+    llvm::Function* replacement =
+        llvm::Function::Create(type, llvm::Function::InternalLinkage, replacementName, m_module.get());
+    defineSystemFunction(replacement, name);
+    return replacement;
+}
+
+bool BrainfuckCompiler::verifyModule() {
+    BrainfuckTimeReport::Scope phase(m_timeReport, "Verification");
+    if (llvm::verifyModule(*m_module, &llvm::errs())) {
+        reportError("Generated IR is invalid");
+        return false;
+    }
+
+    // The verified module is the IR before optimization
+    if (m_timeReport) {
+        m_timeReport->addIRCounts(false, *m_module);
+    }
+    return true;
+}
+
+bool BrainfuckCompiler::checkHostTarget(std::string_view mode) {
+    // JIT code runs inside this process
+    if (m_targetTriple.empty()) {
+        return true;
+    }
+
+    llvm::Triple host(llvm::sys::getProcessTriple());
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    if (triple.getArch() != host.getArch() || triple.getOS() != host.getOS()) {
+        reportError(std::string(mode) + " runs on the host, target " + m_targetTriple + " is only available for "
+                    "executables");
+        return false;
+    }
+
+    return true;
+}
+
+bool BrainfuckCompiler::checkNotProfiling(std::string_view mode) {
+    if (!m_profileFile.empty()) {
+        reportError(std::string(mode) + " cannot be profiled, profile an executable or a JIT run");
+        return false;
+    }
+
+    return true;
+}
+
+bool BrainfuckCompiler::checkFreestandingTarget() {
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    if (!triple.isOSLinux() ||
+        (triple.getArch() != llvm::Triple::x86_64 && triple.getArch() != llvm::Triple::aarch64)) {
+        reportError("Freestanding executables require Linux on x86-64 or AArch64");
+        return false;
+    }
+
+    return true;
+}
+
+void BrainfuckCompiler::defineSystemFunction(llvm::Function* function, llvm::StringRef name) {
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* wordType = llvm::Type::getInt64Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Triple::ArchType arch = m_module->getTargetTriple().getArch();
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(*m_context, "entry", function));
+
+    std::vector<llvm::Value*> args;
+    for (llvm::Argument& arg : function->args()) {
+        args.push_back(&arg);
+    }
+
+    auto syscall = [&](SystemCall call, llvm::ArrayRef<llvm::Value*> callArgs) {
+        return emitSyscall(builder, getSyscallNumber(arch, call), callArgs);
+    };
+    auto returnResult = [&](llvm::Value* result) {
+        llvm::Type* returnType = function->getReturnType();
+        builder.CreateRet(returnType->isPointerTy() ? builder.CreateIntToPtr(result, returnType)
+                                                    : builder.CreateSExtOrTrunc(result, returnType));
+    };
+
+    // Most calls map one to one, errors are returned as negative values instead of through errno
+    if (name == "read") {
+        returnResult(syscall(SystemCall::Read, args));
+    } else if (name == "write") {
+        returnResult(syscall(SystemCall::Write, args));
+    } else if (name == "mmap") {
+        returnResult(syscall(SystemCall::Mmap, args));
+    } else if (name == "mprotect") {
+        returnResult(syscall(SystemCall::Mprotect, args));
+    } else if (name == "creat") {
+        // creat(path, mode) is openat(AT_FDCWD, path, O_WRONLY | O_CREAT | O_TRUNC, mode)
+        constexpr std::int64_t atCurrentDirectory = -100;
+        constexpr std::int64_t createFlags = 01 | 0100 | 01000;
+        returnResult(syscall(SystemCall::Openat, {builder.getInt64(atCurrentDirectory), args[0],
+                                                  builder.getInt64(createFlags), args[1]}));
+    } else if (name == "close") {
+        returnResult(syscall(SystemCall::Close, args));
+    } else if (name == "_Exit") {
+        syscall(SystemCall::ExitGroup, args);
+        builder.CreateUnreachable();
+        function->setDoesNotReturn();
+    } else if (name == "sigaction" || name == "signal") {
+        // struct kernel_sigaction { void* handler; unsigned long flags; void* restorer; uint64_t mask; }
+        llvm::Value* action = builder.CreateAlloca(wordType, builder.getInt32(4), "kernel_action");
+        llvm::Value* handler = args[1];
+        llvm::Value* flags = builder.getInt64(0);
+        if (name == "sigaction") {
+            // Translate the C library's struct sigaction: handler, 128-byte sa_mask, int sa_flags
+            handler = builder.CreateLoad(ptrType, args[1], "handler");
+            llvm::Value* flagsPtr = builder.CreateConstInBoundsGEP1_32(byteType, args[1], 8 + 128);
+            flags = builder.CreateZExt(builder.CreateLoad(intType, flagsPtr, "flags"), wordType);
+        }
+
+        // x86-64 signal handlers return through a restorer that is normally part of the C library
+        llvm::Value* restorer = llvm::Constant::getNullValue(ptrType);
+        if (arch == llvm::Triple::x86_64) {
+            constexpr std::uint64_t saRestorer = 0x04000000;
+            flags = builder.CreateOr(flags, saRestorer);
+
+            llvm::Function* sigreturn = m_module->getFunction("bf_sigreturn");
+            if (!sigreturn) {
+                sigreturn = llvm::Function::Create(llvm::FunctionType::get(builder.getVoidTy(), false),
+                                                   llvm::Function::InternalLinkage, "bf_sigreturn", m_module.get());
+                sigreturn->addFnAttr(llvm::Attribute::Naked);
+                sigreturn->addFnAttr(llvm::Attribute::NoInline);
+                llvm::IRBuilder<> sigreturnBuilder(llvm::BasicBlock::Create(*m_context, "entry", sigreturn));
+                std::string code =
+                    "mov $$" + std::to_string(getSyscallNumber(arch, SystemCall::RtSigreturn)) + ", %eax\n\tsyscall";
+                sigreturnBuilder.CreateCall(
+                    llvm::InlineAsm::get(llvm::FunctionType::get(builder.getVoidTy(), false), code, "", true));
+                sigreturnBuilder.CreateUnreachable();
+            }
+            restorer = sigreturn;
+        }
+
+        builder.CreateStore(handler, action);
+        builder.CreateStore(flags, builder.CreateConstInBoundsGEP1_32(wordType, action, 1));
+        builder.CreateStore(restorer, builder.CreateConstInBoundsGEP1_32(wordType, action, 2));
+        builder.CreateStore(builder.getInt64(0), builder.CreateConstInBoundsGEP1_32(wordType, action, 3));
+        llvm::Value* result = syscall(SystemCall::RtSigaction, {args[0], action, llvm::Constant::getNullValue(ptrType),
+                                                                builder.getInt64(8)});
+
+        // signal() would return the previous handler, no caller needs it
+        if (name == "sigaction") {
+            returnResult(result);
+        } else {
+            builder.CreateRet(llvm::Constant::getNullValue(ptrType));
+        }
+    } else {
+        reportError("No system call replacement for " + name.str());
+        builder.CreateUnreachable();
+    }
+}
+
+llvm::Value* BrainfuckCompiler::emitSyscall(llvm::IRBuilder<>& builder, unsigned number,
+                                            llvm::ArrayRef<llvm::Value*> args) {
+    static const char* const x86_64Registers[] = {"rdi", "rsi", "rdx", "r10", "r8", "r9"};
+    static const char* const aarch64Registers[] = {"x0", "x1", "x2", "x3", "x4", "x5"};
+    bool x86_64 = m_module->getTargetTriple().getArch() == llvm::Triple::x86_64;
+
+    // All arguments are passed as 64-bit words, the result is returned in the first register
+    llvm::Type* wordType = builder.getInt64Ty();
+    std::string constraints = x86_64 ? "={rax},{rax}" : "={x0},{x8}";
+    std::vector<llvm::Value*> operands = {builder.getInt64(number)};
+    for (std::size_t i{}; i < args.size(); ++i) {
+        constraints += std::string(",{") + (x86_64 ? x86_64Registers[i] : aarch64Registers[i]) + "}";
+        operands.push_back(args[i]->getType()->isPointerTy() ? builder.CreatePtrToInt(args[i], wordType)
+                                                             : builder.CreateSExtOrTrunc(args[i], wordType));
+    }
+    constraints += x86_64 ? ",~{rcx},~{r11},~{memory}" : ",~{memory}";
+
+    std::vector<llvm::Type*> operandTypes(operands.size(), wordType);
+    llvm::InlineAsm* code = llvm::InlineAsm::get(llvm::FunctionType::get(wordType, operandTypes, false),
+                                                  x86_64 ? "syscall" : "svc #0", constraints, true);
+    return builder.CreateCall(code, operands, "syscall");
+}
+
+void BrainfuckCompiler::defineStartFunction() {
+    // void _start(): run main and exit with its status. The kernel enters with an aligned stack instead of
+    // one holding a return address, so the stack is realigned.
+    llvm::Function* start = llvm::Function::Create(llvm::FunctionType::get(m_builder->getVoidTy(), false),
+                                                   llvm::Function::ExternalLinkage, "_start", m_module.get());
+    start->addFnAttr("stackrealign");
+    start->setDoesNotReturn();
+
+    llvm::IRBuilder<> builder(llvm::BasicBlock::Create(*m_context, "entry", start));
+    llvm::Value* status = builder.CreateCall(m_mainFunction, {}, "status");
+    emitSyscall(builder, getSyscallNumber(m_module->getTargetTriple().getArch(), SystemCall::ExitGroup), {status});
+    builder.CreateUnreachable();
+}
+
+void BrainfuckCompiler::defineMemoryFunctions() {
+    llvm::Type* byteType = llvm::Type::getInt8Ty(*m_context);
+    llvm::Type* intType = llvm::Type::getInt32Ty(*m_context);
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    llvm::IRBuilder<> builder(*m_context);
+
+    // Code generation lowers large memset/memcpy intrinsics to these calls, which the C library normally provides.
+    // no-builtins keeps the optimizer from turning the loops back into calls of themselves.
+    auto define = [&](const char* name, bool copy) {
+        llvm::Type* sourceType = copy ? ptrType : intType;
+        llvm::FunctionType* type = llvm::FunctionType::get(ptrType, {ptrType, sourceType, sizeType}, false);
+        llvm::Function* function = llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, m_module.get());
+        function->addFnAttr("no-builtins");
+
+        llvm::BasicBlock* entry = llvm::BasicBlock::Create(*m_context, "entry", function);
+        llvm::BasicBlock* loop = llvm::BasicBlock::Create(*m_context, "loop", function);
+        llvm::BasicBlock* done = llvm::BasicBlock::Create(*m_context, "done", function);
+        llvm::Value* dest = function->getArg(0);
+        llvm::Value* size = function->getArg(2);
+
+        builder.SetInsertPoint(entry);
+        builder.CreateCondBr(builder.CreateICmpEQ(size, llvm::ConstantInt::get(sizeType, 0)), done, loop);
+
+        builder.SetInsertPoint(loop);
+        llvm::PHINode* index = builder.CreatePHI(sizeType, 2, "index");
+        index->addIncoming(llvm::ConstantInt::get(sizeType, 0), entry);
+        llvm::Value* value = nullptr;
+        if (copy) {
+            llvm::Value* source = builder.CreateInBoundsGEP(byteType, function->getArg(1), index);
+            value = builder.CreateLoad(byteType, source, "value");
+        } else {
+            value = builder.CreateTrunc(function->getArg(1), byteType, "value");
+        }
+        builder.CreateStore(value, builder.CreateInBoundsGEP(byteType, dest, index));
+        llvm::Value* next = builder.CreateAdd(index, llvm::ConstantInt::get(sizeType, 1), "next");
+        index->addIncoming(next, loop);
+        builder.CreateCondBr(builder.CreateICmpEQ(next, size), done, loop);
+
+        builder.SetInsertPoint(done);
+        builder.CreateRet(dest);
+    };
+    define("memset", false);
+    define("memcpy", true);
+}
+
+void BrainfuckCompiler::generateIR(const BrainfuckProgram& program) {
+    generateOps(program, 0, program.ops().size());
+
+    // Flush buffered output before exit
+    callRuntime(m_flushFunc);
+
+    // Instrumented programs write their loop counters last
+    if (m_profileVar) {
+        llvm::Value* path = m_builder->CreateGlobalString(m_profileFile, "bf_profile_path");
+        llvm::Value* size = llvm::ConstantInt::get(
+            getSizeType(), m_profileVar->getValueType()->getArrayNumElements() * sizeof(std::uint64_t));
+        m_builder->CreateCall(m_profileWriteFunc, {path, m_profileVar, size});
+    }
+
+    if (m_tapeFreeFunc) {
+        m_builder->CreateCall(m_tapeFreeFunc, m_tapeFreeArgs);
+    }
+
+    // Create return instruction
+    llvm::Value* retValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(*m_context), 0);
+    m_builder->CreateRet(retValue);
+
+    if (m_profile) {
+        setProfileSummary();
+    }
+}
+
+void BrainfuckCompiler::setProfileSummary() {
+    // The profile is one run: main is entered once, outlined loops as often as their loop
+    m_mainFunction->setEntryCount(1);
+    std::vector<std::uint64_t> counts = {1};
+    std::uint64_t maxFunctionCount = 1;
+    std::uint64_t maxInternalCount = 0;
+    std::size_t functionCount = 1;
+    for (const BrainfuckProfile::Loop& loop : m_profile->loops()) {
+        counts.push_back(loop.entries);
+        counts.push_back(loop.iterations);
+        maxInternalCount = std::max({maxInternalCount, loop.entries, loop.iterations});
+        if (llvm::Function* loopFunction = m_module->getFunction("bf_loop_" + std::to_string(loop.sourcePos))) {
+            loopFunction->setEntryCount(loop.entries);
+            maxFunctionCount = std::max(maxFunctionCount, loop.entries);
+            ++functionCount;
+        }
+    }
+
+    // Each cutoff gets the smallest count of the hottest counts that make up that share of the total
+    std::sort(counts.begin(), counts.end(), std::greater<>());
+    std::uint64_t totalCount = 0;
+    for (std::uint64_t count : counts) {
+        totalCount += count;
+    }
+    llvm::SummaryEntryVector detailedSummary;
+    std::size_t hotCounts = 0;
+    std::uint64_t hotTotal = 0;
+    for (std::uint32_t cutoff : llvm::ProfileSummaryBuilder::DefaultCutoffs) {
+        double cutoffTotal = static_cast<double>(totalCount) * cutoff / llvm::ProfileSummary::Scale;
+        while (hotCounts < counts.size() && (hotCounts == 0 || hotTotal < cutoffTotal)) {
+            hotTotal += counts[hotCounts++];
+        }
+        detailedSummary.emplace_back(cutoff, counts[hotCounts - 1], hotCounts);
+    }
+
+    // With a summary the optimizer tells hot from cold code, such as blocks it optimizes for size
+    llvm::ProfileSummary summary(llvm::ProfileSummary::PSK_Instr, detailedSummary, totalCount, counts.front(),
+                                 maxInternalCount, maxFunctionCount, static_cast<std::uint32_t>(counts.size()),
+                                 static_cast<std::uint32_t>(functionCount));
+    m_module->setProfileSummary(summary.getMD(*m_context), llvm::ProfileSummary::PSK_Instr);
+}
+
+void BrainfuckCompiler::generateOps(const BrainfuckProgram& program, std::size_t begin, std::size_t end) {
+    const std::vector<BrainfuckOp>& ops = program.ops();
+    m_currentIP = 0;
+
+    // Iterate through each Brainfuck IR operation
+    for (std::size_t i = begin; i < end; ++i) {
+        const BrainfuckOp& op = ops[i];
+        m_currentIP = op.sourcePos;
+
+        switch (op.kind) {
+        case BrainfuckOpKind::Move:
+            handleMovePtr(op.value);
+            break;
+        case BrainfuckOpKind::Add:
+            handleAddByte(op.offset, op.value);
+            break;
+        case BrainfuckOpKind::Output:
+            handleOutput(op.offset);
+            break;
+        case BrainfuckOpKind::Input:
+            handleInput(op.offset);
+            break;
+        case BrainfuckOpKind::LoopStart:
+            handleLoopStart(op.sourcePos);
+            break;
+        case BrainfuckOpKind::LoopEnd:
+            handleLoopEnd(op.sourcePos);
+            break;
+        case BrainfuckOpKind::SetZero:
+            handleSetZero(op.offset);
+            break;
+        case BrainfuckOpKind::MulAdd:
+            handleMulAdd(op.srcOffset, op.offset, op.value);
+            break;
+        case BrainfuckOpKind::Write:
+            handleWrite(program.strings()[op.value]);
+            break;
+        case BrainfuckOpKind::ScanRight:
+            handleScan(op.value);
+            break;
+        case BrainfuckOpKind::ScanLeft:
+            handleScan(-op.value);
+            break;
+        }
+    }
+}
+
+llvm::Value* BrainfuckCompiler::getCellPtr(std::int32_t offset) {
+    llvm::Value* cellPtr =
+        offset == 0 ? m_dataPtr : m_builder->CreateConstGEP1_32(getCellType(), m_dataPtr, offset, "cell_ptr");
+    if (m_boundsMode == BoundsMode::Check) {
+        emitBoundsCheck(cellPtr);
+    }
+    return cellPtr;
+}
+
+void BrainfuckCompiler::emitBoundsCheck(llvm::Value* cellPtr) {
+    llvm::Type* sizeType = getSizeType();
+    llvm::Function* function = m_builder->GetInsertBlock()->getParent();
+
+    // main addresses its own tape, outlined and tiered loops use the tape registered with the host runtime
+    llvm::Value* tape = m_memoryArray;
+    if (function != m_mainFunction || !tape) {
+        auto* load = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_boundsTapeVar, "bounds_tape");
+        load->setMetadata(llvm::LLVMContext::MD_invariant_load, llvm::MDNode::get(*m_context, {}));
+        tape = load;
+    }
+
+    // One unsigned compare covers both ends of the tape, cells are always aligned within it
+    llvm::Value* offset = m_builder->CreateSub(m_builder->CreatePtrToInt(cellPtr, sizeType),
+                                               m_builder->CreatePtrToInt(tape, sizeType), "cell_offset");
+    llvm::Value* cell = m_builder->CreateAShr(offset, llvm::Log2_32(m_cellBits / 8), "cell", true);
+    llvm::Value* inBounds = m_builder->CreateICmpULT(cell, llvm::ConstantInt::get(sizeType, m_memorySize), "in_bounds");
+
+    llvm::BasicBlock* outOfBounds = llvm::BasicBlock::Create(*m_context, "out_of_bounds", function);
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(*m_context, "bounds_ok", function);
+    m_builder->CreateCondBr(inBounds, next, outOfBounds, llvm::MDBuilder(*m_context).createBranchWeights(1 << 20, 1));
+
+    m_builder->SetInsertPoint(outOfBounds);
+    llvm::Value* cellIndex = m_builder->CreateSExtOrTrunc(cell, m_builder->getInt64Ty());
+    callRuntime(m_boundsErrorFunc, {cellIndex, llvm::ConstantInt::get(sizeType, m_currentIP)});
+    if (m_ioContext) {
+        // Library runs end with status 1, the whole program is in the entry function
+        m_builder->CreateRet(m_builder->getInt32(1));
+    } else {
+        m_builder->CreateUnreachable();
+    }
+
+    m_builder->SetInsertPoint(next);
+}
+
+void BrainfuckCompiler::recordSourcePos(std::size_t ip) {
+    // Volatile, so the fault handler sees the position even if the optimizer could keep it in a register
+    if (m_sourcePosVar) {
+        m_builder->CreateStore(llvm::ConstantInt::get(getSizeType(), ip), m_sourcePosVar, true);
+    }
+}
+
+void BrainfuckCompiler::emitProfileCount(std::size_t word) {
+    // Programs are single-threaded, a plain increment is enough
+    llvm::Type* wordType = m_builder->getInt64Ty();
+    llvm::Value* counter =
+        m_builder->CreateConstInBoundsGEP2_64(m_profileVar->getValueType(), m_profileVar, 0, word, "profile_counter");
+    llvm::Value* count = m_builder->CreateLoad(wordType, counter, "profile_count");
+    m_builder->CreateStore(m_builder->CreateAdd(count, llvm::ConstantInt::get(wordType, 1)), counter);
+}
+
+llvm::MDNode* BrainfuckCompiler::createLoopMetadata(const BrainfuckProfile::Loop& loop) {
+    std::vector<llvm::Metadata*> properties;
+    auto addProperty = [&](const char* name, llvm::Metadata* value = nullptr) {
+        std::vector<llvm::Metadata*> operands = {llvm::MDString::get(*m_context, name)};
+        if (value) {
+            operands.push_back(value);
+        }
+        properties.push_back(llvm::MDNode::get(*m_context, operands));
+    };
+
+    // Loops that ran are left to the optimizer, which takes their trip counts from the branch weights
+    if (loop.iterations > 0) {
+        return nullptr;
+    }
+
+    // Never ran, code size is all unrolling or vectorizing would add
+    addProperty("llvm.loop.unroll.disable");
+    addProperty("llvm.loop.vectorize.enable", llvm::ConstantAsMetadata::get(m_builder->getFalse()));
+
+    // Loop IDs are distinct and refer to themselves
+    properties.insert(properties.begin(), nullptr);
+    llvm::MDNode* loopID = llvm::MDNode::getDistinct(*m_context, properties);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
+}
+
+void BrainfuckCompiler::handleMovePtr(std::int32_t distance) {
+    // Move pointer by the folded distance
+    m_dataPtr = m_builder->CreateConstGEP1_32(getCellType(), m_dataPtr, distance, "ptr_move");
+}
+
+void BrainfuckCompiler::handleAddByte(std::int32_t offset, std::int32_t delta) {
+    // Load current cell value
+    llvm::Value* cellPtr = getCellPtr(offset);
+    llvm::Value* currentValue = m_builder->CreateLoad(getCellType(), cellPtr, "current_val");
+
+    // Cell value addition, wrapping modulo 2^cellBits
+    llvm::Value* newValue = m_builder->CreateAdd(currentValue, getCellConstant(delta), "val_add");
+
+    // Store new cell value
+    m_builder->CreateStore(newValue, cellPtr);
+}
+
+void BrainfuckCompiler::handleOutput(std::int32_t offset) {
+    // Load current cell value
+    llvm::Value* currentValue = m_builder->CreateLoad(getCellType(), getCellPtr(offset), "output_val");
+
+    // Append the low byte to the output buffer
+    callRuntime(m_outputFunc, {m_builder->CreateTrunc(currentValue, m_builder->getInt8Ty(), "output_byte")});
+}
+
+void BrainfuckCompiler::handleInput(std::int32_t offset) {
+    // Read from the input buffer
+    llvm::Value* inputValue = callRuntime(m_inputFunc, {}, "input_byte");
+
+    // Store input value, zero-extended to the cell width
+    m_builder->CreateStore(m_builder->CreateZExt(inputValue, getCellType(), "input_val"), getCellPtr(offset));
+}
+
+void BrainfuckCompiler::handleWrite(std::string_view text) {
+    // Constant string with all the output of a block
+    llvm::Constant* data = m_builder->CreateGlobalString(text, "output_str");
+
+    // Copy it into the output buffer with one call
+    callRuntime(m_writeFunc, {data, llvm::ConstantInt::get(getSizeType(), text.size())});
+}
+
+void BrainfuckCompiler::handleScan(std::int32_t stride) {
+    // Guard faults report the scan like a loop
+    recordSourcePos(m_currentIP);
+
+    // Strides that divide a block select the same lanes in every block, checked accesses stay scalar
+    std::uint32_t distance = stride > 0 ? stride : -stride;
+    unsigned lanes = scanBlockSize / (m_cellBits / 8);
+    if (m_boundsMode == BoundsMode::Check || !llvm::isPowerOf2_32(distance) || distance > lanes) {
+        emitScanLoop(stride);
+    } else {
+        emitVectorScan(stride);
+    }
+}
+
+void BrainfuckCompiler::emitScanLoop(std::int32_t stride) {
+    llvm::Function* function = m_builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* preheader = m_builder->GetInsertBlock();
+    llvm::BasicBlock* header = llvm::BasicBlock::Create(*m_context, "scan_header", function);
+    llvm::BasicBlock* exit = llvm::BasicBlock::Create(*m_context, "scan_end", function);
+    m_builder->CreateBr(header);
+
+    // while (*ptr) ptr += stride
+    m_builder->SetInsertPoint(header);
+    llvm::PHINode* ptrPhi = m_builder->CreatePHI(llvm::PointerType::get(*m_context, 0), 2, "scan_ptr");
+    ptrPhi->addIncoming(m_dataPtr, preheader);
+    m_dataPtr = ptrPhi;
+
+    llvm::Value* value = m_builder->CreateLoad(getCellType(), getCellPtr(0), "scan_val");
+    llvm::Value* next = m_builder->CreateConstGEP1_32(getCellType(), ptrPhi, stride, "scan_next");
+    ptrPhi->addIncoming(next, m_builder->GetInsertBlock());
+    m_builder->CreateCondBr(m_builder->CreateICmpEQ(value, getCellConstant(0)), exit, header);
+
+    m_builder->SetInsertPoint(exit);
+}
+
+void BrainfuckCompiler::emitVectorScan(std::int32_t stride) {
+    llvm::Type* byteType = m_builder->getInt8Ty();
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::Type* sizeType = getSizeType();
+    unsigned cellBytes = m_cellBits / 8;
+    unsigned lanes = scanBlockSize / cellBytes;
+    unsigned distance = stride > 0 ? stride : -stride;
+    bool right = stride > 0;
+
+    // Each block is compared as one vector, lanes become the bits of a mask
+    llvm::IntegerType* maskType = m_builder->getIntNTy(lanes);
+    auto* blockType = llvm::FixedVectorType::get(getCellType(), lanes);
+
+    // Aligned block around the start cell, its lane and the lanes on the stride
+    llvm::Function* function = m_builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* preheader = m_builder->GetInsertBlock();
+    llvm::Value* misalign = m_builder->CreateAnd(m_builder->CreatePtrToInt(m_dataPtr, sizeType), scanBlockSize - 1,
+                                                 "scan_misalign");
+    llvm::Value* firstBlock = m_builder->CreateIntrinsic(
+        llvm::Intrinsic::ptrmask, {ptrType, sizeType},
+        {m_dataPtr, llvm::ConstantInt::get(sizeType, ~std::uint64_t{scanBlockSize - 1})}, nullptr, "scan_block");
+    llvm::Value* lane =
+        m_builder->CreateTrunc(m_builder->CreateLShr(misalign, llvm::Log2_32(cellBytes)), maskType, "scan_lane");
+
+    llvm::APInt pattern(lanes, 0);
+    for (unsigned i{}; i < lanes; i += distance) {
+        pattern.setBit(i);
+    }
+    llvm::Value* candidates = m_builder->CreateShl(llvm::ConstantInt::get(maskType, pattern),
+                                                   m_builder->CreateAnd(lane, distance - 1), "scan_candidates");
+
+    // The first block only counts lanes from the start cell on, in scan direction
+    llvm::Value* allLanes = llvm::ConstantInt::getAllOnesValue(maskType);
+    llvm::Value* lastLane = llvm::ConstantInt::get(maskType, lanes - 1);
+    llvm::Value* firstLanes = right ? m_builder->CreateShl(allLanes, lane)
+                                    : m_builder->CreateLShr(allLanes, m_builder->CreateSub(lastLane, lane));
+    llvm::Value* firstMask = m_builder->CreateAnd(candidates, firstLanes, "scan_first_mask");
+
+    llvm::BasicBlock* loop = llvm::BasicBlock::Create(*m_context, "scan_loop", function);
+    llvm::BasicBlock* found = llvm::BasicBlock::Create(*m_context, "scan_found", function);
+    m_builder->CreateBr(loop);
+
+    m_builder->SetInsertPoint(loop);
+    llvm::PHINode* block = m_builder->CreatePHI(ptrType, 2, "scan_block_ptr");
+    llvm::PHINode* mask = m_builder->CreatePHI(maskType, 2, "scan_mask");
+    block->addIncoming(firstBlock, preheader);
+    mask->addIncoming(firstMask, preheader);
+
+    llvm::Value* cells = m_builder->CreateAlignedLoad(blockType, block, llvm::Align(scanBlockSize), "scan_cells");
+    llvm::Value* zeros = m_builder->CreateBitCast(
+        m_builder->CreateICmpEQ(cells, llvm::Constant::getNullValue(blockType)), maskType, "scan_zeros");
+    llvm::Value* hits = m_builder->CreateAnd(zeros, mask, "scan_hits");
+    llvm::Value* nextBlock =
+        m_builder->CreateConstGEP1_32(byteType, block, right ? scanBlockSize : -static_cast<int>(scanBlockSize));
+    block->addIncoming(nextBlock, loop);
+    mask->addIncoming(candidates, loop);
+    m_builder->CreateCondBr(m_builder->CreateIsNotNull(hits), found, loop);
+
+    // First zero lane in scan direction
+    m_builder->SetInsertPoint(found);
+    llvm::Value* hitLane;
+    if (right) {
+        hitLane = m_builder->CreateBinaryIntrinsic(llvm::Intrinsic::cttz, hits, m_builder->getTrue());
+    } else {
+        llvm::Value* leading = m_builder->CreateBinaryIntrinsic(llvm::Intrinsic::ctlz, hits, m_builder->getTrue());
+        hitLane = m_builder->CreateSub(lastLane, leading);
+    }
+    m_dataPtr =
+        m_builder->CreateGEP(getCellType(), block, m_builder->CreateZExt(hitLane, sizeType), "scan_result");
+}
+
+void BrainfuckCompiler::handleLoopStart(std::size_t ip) {
+    const BrainfuckProfile::Loop* profiled = m_profile ? m_profile->findLoop(ip) : nullptr;
+
+    // Top-level loops get their own function in JIT mode, so only loops that are reached get compiled
+    bool coldLoop = m_outlineColdLoops && profiled && profiled->iterations == 0;
+    if ((m_outlineLoops || coldLoop) && m_loops.empty()) {
+        beginOutlinedLoop(ip);
+    }
 
-void BrainfuckCompiler::initializeLLVM() {
-    // Initialize LLVM targets
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
-
-    // Create LLVM context and module
-    m_context = std::make_unique<llvm::LLVMContext>();
-    m_module = std::make_unique<llvm::Module>("brainfuck_module", *m_context);
-    m_builder = std::make_unique<llvm::IRBuilder<>>(*m_context);
+    // Guard faults report the last loop boundary
+    recordSourcePos(ip);
 
-    // Set target triple
-    auto targetTriple = llvm::sys::getDefaultTargetTriple();
-    m_module->setTargetTriple(llvm::Triple(targetTriple));
-}
+    // Profiled loops count their entries here and their iterations at the top of the body
+    std::size_t profileRecord = 0;
+    if (m_profileVar) {
+        profileRecord = BrainfuckProfile::headerWords + m_profileLoops++ * BrainfuckProfile::loopWords;
+        emitProfileCount(profileRecord + 2);
+    }
 
-bool BrainfuckCompiler::compile(std::string_view source, std::string_view outputFile, bool enableJIT) {
-    try {
-        // Check bracket matching
-        if (!checkBrackets(source)) {
-            return false;
-        }
+    // Create loop basic blocks
+    llvm::Function* function = m_builder->GetInsertBlock()->getParent();
+    // Twine names are only formatted when names are kept
+    llvm::BasicBlock* loopHeader = llvm::BasicBlock::Create(*m_context, "loop_header_" + llvm::Twine(ip), function);
+    llvm::BasicBlock* loopBody = llvm::BasicBlock::Create(*m_context, "loop_body_" + llvm::Twine(ip), function);
+    llvm::BasicBlock* loopEnd = llvm::BasicBlock::Create(*m_context, "loop_end_" + llvm::Twine(ip), function);
 
-        // Reset statistics
-        m_statistics.clear();
+    // Jump to loop header
+    llvm::BasicBlock* preheader = m_builder->GetInsertBlock();
+    m_builder->CreateBr(loopHeader);
 
-        // Create main function and allocate memory
-        createMainFunction();
-        allocateMemory();
-        setupRuntimeFunctions();
+    // Set insert point to loop header
+    m_builder->SetInsertPoint(loopHeader);
 
-        // Generate debug info (if enabled)
-        if (m_enableDebugInfo) {
-            createDebugInfo();
-        }
+    // Data pointer on loop entry, the back edge is added in handleLoopEnd
+    llvm::PHINode* ptrPhi = m_builder->CreatePHI(llvm::PointerType::get(*m_context, 0), 2, "loop_ptr");
+    ptrPhi->addIncoming(m_dataPtr, preheader);
+    m_dataPtr = ptrPhi;
 
-        // Generate IR
-        generateIR(source);
+    // Load current cell value
+    llvm::Value* currentValue = m_builder->CreateLoad(getCellType(), getCellPtr(0), "loop_val");
 
-        // Verify IR
-        if (llvm::verifyModule(*m_module, &llvm::errs())) {
-            reportError("Generated IR is invalid");
-            return false;
-        }
+    // Compare value to 0
+    llvm::Value* zero = getCellConstant(0);
+    llvm::Value* condition = m_builder->CreateICmpEQ(currentValue, zero, "loop_cond");
 
-        // Apply optimizations
-        if (m_enableOptimization) {
-            optimizeModule();
-        }
+    // Conditional branch, profiled loops exit once per entry and take the body once per iteration
+    llvm::MDNode* weights = nullptr;
+    if (profiled && (profiled->entries > 0 || profiled->iterations > 0)) {
+        weights = createCountWeights(*m_context, profiled->entries, profiled->iterations);
+    }
+    m_builder->CreateCondBr(condition, loopEnd, loopBody, weights);
 
-        // Output IR (for debugging)
-        // m_module->print(errs(), nullptr);
+    // Set insert point to loop body
+    m_builder->SetInsertPoint(loopBody);
+    if (m_profileVar) {
+        emitProfileCount(profileRecord + 3);
+    }
 
-        if (enableJIT) {
-            // JIT mode: direct execution
-            executeJIT();
-        } else {
-            // Generate object file
-            emitObjectFile(outputFile);
-        }
+    // Push to loop stack
+    m_loops.push_back(LoopFrame{loopHeader, loopEnd, ptrPhi, profiled ? createLoopMetadata(*profiled) : nullptr});
+}
 
-        return true;
+void BrainfuckCompiler::handleLoopEnd(std::size_t ip) {
+    if (m_loops.empty()) {
+        reportError("Syntax error: Extra right bracket ']' at position " + std::to_string(ip));
+        return;
+    }
 
-    } catch (const std::exception& e) {
-        reportError(std::string("Compilation error: ") + e.what());
-        return false;
+    // Pop from loop stack
+    auto [loopHeader, loopEnd, ptrPhi, loopID] = m_loops.back();
+    m_loops.pop_back();
+
+    // Jump back to loop header, carrying the data pointer of the loop body
+    ptrPhi->addIncoming(m_dataPtr, m_builder->GetInsertBlock());
+    llvm::BranchInst* backEdge = m_builder->CreateBr(loopHeader);
+    if (loopID) {
+        backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+    }
+
+    // Set insert point to loop end block, the loop exits from its header
+    m_builder->SetInsertPoint(loopEnd);
+    m_dataPtr = ptrPhi;
+    recordSourcePos(ip);
+
+    if (m_outlinedLoopCall && m_loops.empty()) {
+        endOutlinedLoop();
     }
 }
 
-bool BrainfuckCompiler::checkBrackets(std::string_view source) {
-    int bracketCount = 0;
+void BrainfuckCompiler::beginOutlinedLoop(std::size_t ip) {
+    // Loop function: cell_t* bf_loop_<ip>(cell_t* dataPtr), returns the data pointer after the loop
+    llvm::Type* ptrType = llvm::PointerType::get(*m_context, 0);
+    llvm::FunctionType* loopType = llvm::FunctionType::get(ptrType, {ptrType}, false);
 
-    for (char c : source) {
-        if (c == '[') {
-            bracketCount++;
-        } else if (c == ']') {
-            bracketCount--;
-            if (bracketCount < 0) {
-                reportError("Syntax error: Extra right bracket ']'");
-                return false;
-            }
-        }
+    llvm::Function* loopFunction = llvm::Function::Create(loopType, llvm::Function::ExternalLinkage,
+                                                          "bf_loop_" + std::to_string(ip), m_module.get());
+
+    // Executables call loops of other partitions directly, they are not exported
+    if (!m_hostRuntime) {
+        loopFunction->setVisibility(llvm::GlobalValue::HiddenVisibility);
     }
 
-    if (bracketCount != 0) {
-        reportError("Syntax error: Brackets do not match");
-        return false;
+    // Loops that never ran in the profile are laid out and optimized as cold code
+    const BrainfuckProfile::Loop* profiled = m_profile ? m_profile->findLoop(ip) : nullptr;
+    if (profiled && profiled->iterations == 0) {
+        loopFunction->addFnAttr(llvm::Attribute::Cold);
+        loopFunction->addFnAttr(llvm::Attribute::NoInline);
     }
 
-    return true;
+    // Call the loop function from the current position
+    m_outlinedLoopCall = m_builder->CreateCall(loopFunction, {m_dataPtr}, "loop_result_ptr");
+
+    // Continue generating code inside the loop function
+    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_context, "entry", loopFunction);
+    m_builder->SetInsertPoint(entryBlock);
+    m_dataPtr = loopFunction->getArg(0);
 }
 
-void BrainfuckCompiler::createMainFunction() {
-    // Create main function: int main()
-    llvm::FunctionType* mainType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*m_context), // Return type
-                                                           false // Not variadic
-    );
+void BrainfuckCompiler::endOutlinedLoop() {
+    // Return the data pointer to the caller
+    m_builder->CreateRet(m_dataPtr);
 
-    m_mainFunction = llvm::Function::Create(mainType, llvm::Function::ExternalLinkage, "main", m_module.get());
+    // Continue after the call, which is the last instruction of the calling block
+    m_builder->SetInsertPoint(m_outlinedLoopCall->getParent());
+    m_dataPtr = m_outlinedLoopCall;
+    m_outlinedLoopCall = nullptr;
+}
 
-    // Create entry basic block
-    llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(*m_context, "entry", m_mainFunction);
+void BrainfuckCompiler::handleSetZero(std::int32_t offset) {
+    // Store zero to the cell
+    m_builder->CreateStore(getCellConstant(0), getCellPtr(offset));
+}
 
-    m_builder->SetInsertPoint(entryBlock);
+void BrainfuckCompiler::handleMulAdd(std::int32_t srcOffset, std::int32_t offset, std::int32_t factor) {
+    // Load the loop counter cell
+    llvm::Value* counterValue = m_builder->CreateLoad(getCellType(), getCellPtr(srcOffset), "counter_val");
+
+    // Load the target cell
+    llvm::Value* targetPtr = getCellPtr(offset);
+    llvm::Value* targetValue = m_builder->CreateLoad(getCellType(), targetPtr, "target_val");
+
+    // target += counter * factor, wrapping modulo 2^cellBits
+    llvm::Value* product = m_builder->CreateMul(counterValue, getCellConstant(factor), "mul_val");
+    llvm::Value* newValue = m_builder->CreateAdd(targetValue, product, "muladd_val");
+
+    // Store new target value
+    m_builder->CreateStore(newValue, targetPtr);
 }
 
-void BrainfuckCompiler::allocateMemory() {
-    // Allocate memory array: int8_t memory[memorySize]
-    llvm::ArrayType* memoryArrayType = llvm::ArrayType::get(llvm::Type::getInt8Ty(*m_context), m_memorySize);
+bool BrainfuckCompiler::createTargetMachine() {
+    // The target machine is shared by all modules of this compiler
+    if (!m_targetMachine) {
+        m_targetMachine = buildTargetMachine();
+        if (!m_targetMachine) {
+            return false;
+        }
+    }
+
+    // Set data layout
+    m_module->setDataLayout(m_targetMachine->createDataLayout());
 
-    m_memoryArray = m_builder->CreateAlloca(memoryArrayType, nullptr, "memory");
+    return true;
+}
 
-    // Initialize memory to 0 using memset
-    llvm::Value* zero = llvm::ConstantInt::get(llvm::Type::getInt8Ty(*m_context), 0);
-    llvm::Value* size = llvm::ConstantInt::get(llvm::Type::getInt64Ty(*m_context), m_memorySize);
+std::unique_ptr<llvm::TargetMachine> BrainfuckCompiler::buildTargetMachine() {
+    // Get target
+    std::string error;
+    const llvm::Target* target = lookupTarget(error);
 
-    // Use IRBuilder's CreateMemSet which handles the intrinsic correctly
-    m_builder->CreateMemSet(m_memoryArray, zero, size, llvm::MaybeAlign(1), false);
+    if (!target) {
+        reportError("Target lookup failed: " + error);
+        return nullptr;
+    }
 
-    // Allocate data pointer: int8_t* dataPtr = &memory[memorySize/2]
-    m_dataPtr = m_builder->CreateAlloca(llvm::PointerType::get(*m_context, 0), nullptr, "dataptr");
+    // Code generation level follows the IR optimization level
+    llvm::CodeGenOptLevel codeGenLevel = llvm::CodeGenOptLevel::Default;
+    switch (m_optLevel) {
+    case OptLevel::O0:
+        codeGenLevel = llvm::CodeGenOptLevel::None;
+        break;
+    case OptLevel::O1:
+        codeGenLevel = llvm::CodeGenOptLevel::Less;
+        break;
+    case OptLevel::O2:
+    case OptLevel::Os:
+        codeGenLevel = llvm::CodeGenOptLevel::Default;
+        break;
+    case OptLevel::O3:
+        codeGenLevel = llvm::CodeGenOptLevel::Aggressive;
+        break;
+    }
 
-    // Initialize pointer to middle of memory
-    llvm::Value* indices[] = {llvm::ConstantInt::get(llvm::Type::getInt32Ty(*m_context), 0),
-                              llvm::ConstantInt::get(llvm::Type::getInt32Ty(*m_context), m_memorySize / 2)};
+    // Target machine options, position independent code so the tape and runtime globals link into PIE executables
+    llvm::TargetOptions options;
+    std::unique_ptr<llvm::TargetMachine> targetMachine(target->createTargetMachine(
+        m_module->getTargetTriple(), m_targetCPU, m_targetFeatures, options, llvm::Reloc::PIC_, std::nullopt,
+        codeGenLevel));
 
-    llvm::Value* initialPtr = m_builder->CreateInBoundsGEP(memoryArrayType, m_memoryArray, indices, "initial_ptr");
+    if (!targetMachine) {
+        reportError("Target machine creation failed");
+    }
 
-    m_builder->CreateStore(initialPtr, m_dataPtr);
+    return targetMachine;
 }
 
-void BrainfuckCompiler::setupRuntimeFunctions() {
-    // Create putchar function declaration: int putchar(int)
-    llvm::FunctionType* putcharType =
-        llvm::FunctionType::get(llvm::Type::getInt32Ty(*m_context), {llvm::Type::getInt32Ty(*m_context)}, false);
-
-    m_putcharFunc = llvm::Function::Create(putcharType, llvm::Function::ExternalLinkage, "putchar", m_module.get());
+BrainfuckCompiler::OptimizationPipeline::OptimizationPipeline(llvm::TargetMachine* targetMachine, OptLevel optLevel,
+                                                              BrainfuckTimeReport* timeReport)
+    : report(timeReport),
+      passTimer(timeReport, callbacks),
+      passBuilder(targetMachine, llvm::PipelineTuningOptions(), std::nullopt, timeReport ? &callbacks : nullptr) {
+    // Register analyses, the target machine provides target-specific cost models to the vectorizers
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+    // Select the standard pipeline
+    llvm::OptimizationLevel level = llvm::OptimizationLevel::O2;
+    switch (optLevel) {
+    case OptLevel::O0:
+        level = llvm::OptimizationLevel::O0;
+        break;
+    case OptLevel::O1:
+        level = llvm::OptimizationLevel::O1;
+        break;
+    case OptLevel::O2:
+        level = llvm::OptimizationLevel::O2;
+        break;
+    case OptLevel::O3:
+        level = llvm::OptimizationLevel::O3;
+        break;
+    case OptLevel::Os:
+        level = llvm::OptimizationLevel::Os;
+        break;
+    }
+    mpm = level == llvm::OptimizationLevel::O0 ? passBuilder.buildO0DefaultPipeline(level)
+                                               : passBuilder.buildPerModuleDefaultPipeline(level);
+}
 
-    // Create getchar function declaration: int getchar()
-    llvm::FunctionType* getcharType = llvm::FunctionType::get(llvm::Type::getInt32Ty(*m_context), false);
+void BrainfuckCompiler::OptimizationPipeline::run(llvm::Module& module) {
+    mpm.run(module, mam);
 
-    m_getcharFunc = llvm::Function::Create(getcharType, llvm::Function::ExternalLinkage, "getchar", m_module.get());
+    // Cached results describe this module only, the next module may even be allocated at its address
+    lam.clear();
+    fam.clear();
+    cgam.clear();
+    mam.clear();
 }
 
-void BrainfuckCompiler::generateIR(std::string_view source) {
-    m_currentIP = 0;
+void BrainfuckCompiler::optimizeModule(llvm::Module& module, llvm::TargetMachine* targetMachine) {
+    if (m_optLevel == OptLevel::O0) {
+        return;
+    }
+
+    if (targetMachine && targetMachine != m_targetMachine.get()) {
+        // Partitions compiled on other threads each run a pipeline of their own target machine
+        OptimizationPipeline(targetMachine, m_optLevel, m_timeReport).run(module);
+    } else {
+        // Modules optimized for the shared target machine reuse its pipeline
+        if (!m_pipeline || m_pipeline->report != m_timeReport) {
+            m_pipeline = std::make_unique<OptimizationPipeline>(m_targetMachine.get(), m_optLevel, m_timeReport);
+        }
+        m_pipeline->run(module);
+    }
+
+    if (m_timeReport) {
+        m_timeReport->addIRCounts(true, module);
+    }
+}
 
-    // Iterate through each character in source code
-    for (std::size_t i{}; i < source.length(); ++i) {
-        char c = source[i];
-        m_currentIP = i;
+bool BrainfuckCompiler::emitObjectFile(std::string_view outputFile) {
+    std::string executableFile = std::string(outputFile);
 
-        // Skip non-Brainfuck instruction characters
-        if (c != '>' && c != '<' && c != '+' && c != '-' && c != '.' && c != ',' && c != '[' && c != ']') {
-            continue;
+    // Generate the object files in memory, one per partition of the program
+    std::vector<llvm::SmallVector<char, 0>> objects;
+    if (m_outlineLoops) {
+        if (!compilePartitions(objects)) {
+            return false;
+        }
+    } else {
+        // Apply optimizations
+        if (m_optLevel != OptLevel::O0) {
+            BrainfuckTimeReport::Scope phase(m_timeReport, "Optimization");
+            optimizeModule(*m_module);
         }
 
-        // Count instruction usage
-        m_statistics[c]++;
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Code generation");
+        objects.emplace_back();
+        if (!generateObject(*m_module, *m_targetMachine, objects.back())) {
+            return false;
+        }
+    }
 
-        switch (c) {
-        case '>':
-            handleIncrementPtr();
-            break;
-        case '<':
-            handleDecrementPtr();
-            break;
-        case '+':
-            handleIncrementByte();
-            break;
-        case '-':
-            handleDecrementByte();
-            break;
-        case '.':
-            handleOutput();
-            break;
-        case ',':
-            handleInput();
-            break;
-        case '[':
-            handleLoopStart(i);
-            break;
-        case ']':
-            handleLoopEnd(i);
-            break;
+    // Link to generate executable file
+    std::vector<llvm::StringRef> objectRefs;
+    for (const llvm::SmallVector<char, 0>& object : objects) {
+        objectRefs.emplace_back(object.data(), object.size());
+    }
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Linking");
+        if (!linkExecutable(objectRefs, executableFile)) {
+            return false;
         }
     }
 
-    // Create return instruction
-    llvm::Value* retValue = llvm::ConstantInt::get(llvm::Type::getInt32Ty(*m_context), 0);
-    m_builder->CreateRet(retValue);
+    if (m_cache) {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Cache store");
+        m_cache->storeExecutable(executableFile);
+    }
+
+    std::cout << "Compilation completed: " << executableFile << std::endl;
+    return true;
 }
 
-void BrainfuckCompiler::handleIncrementPtr() {
-    // Load current pointer value
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+bool BrainfuckCompiler::generateObject(llvm::Module& module, llvm::TargetMachine& targetMachine,
+                                       llvm::SmallVectorImpl<char>& object) {
+    llvm::raw_svector_ostream dest(object);
+
+    // Create pass manager
+    llvm::legacy::PassManager pass;
 
-    // Pointer increment
-    llvm::Value* newPtr = m_builder->CreateConstGEP1_32(llvm::Type::getInt8Ty(*m_context), currentPtr, 1, "ptr_inc");
+    // Add object file generation pass
+    if (targetMachine.addPassesToEmitFile(pass, dest, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+        reportError("Target machine does not support object file generation");
+        return false;
+    }
 
-    // Store new pointer value
-    m_builder->CreateStore(newPtr, m_dataPtr);
+    // Run pass
+    pass.run(module);
+    return true;
 }
 
-void BrainfuckCompiler::handleDecrementPtr() {
-    // Load current pointer value
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+std::vector<llvm::SmallVector<char, 0>> BrainfuckCompiler::splitModule(unsigned partitions) {
+    // Units of work are the functions called from outside their module: main and the outlined top-level loops
+    std::vector<llvm::Function*> units;
+    for (llvm::Function& function : *m_module) {
+        if (!function.isDeclaration() && !function.hasLocalLinkage()) {
+            units.push_back(&function);
+        }
+    }
 
-    // Pointer decrement
-    llvm::Value* newPtr = m_builder->CreateConstGEP1_32(llvm::Type::getInt8Ty(*m_context), currentPtr, -1, "ptr_dec");
+    // Largest unit first to the least loaded partition
+    std::sort(units.begin(), units.end(), [](llvm::Function* a, llvm::Function* b) {
+        return a->getInstructionCount() > b->getInstructionCount();
+    });
+    std::vector<std::size_t> load(partitions, 0);
+    std::map<const llvm::GlobalValue*, unsigned> owner;
+    for (llvm::Function* unit : units) {
+        unsigned partition = static_cast<unsigned>(std::min_element(load.begin(), load.end()) - load.begin());
+        owner[unit] = partition;
+        load[partition] += unit->getInstructionCount() + 1;
+    }
 
-    // Store new pointer value
-    m_builder->CreateStore(newPtr, m_dataPtr);
-}
+    // Mutable state such as the tape, the I/O buffers and the bounds variables exists once, partition 0
+    // defines it for all others. Internal functions and constants are copied into every partition.
+    for (llvm::GlobalVariable& global : m_module->globals()) {
+        if (global.hasLocalLinkage() && !global.isConstant()) {
+            global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            global.setVisibility(llvm::GlobalValue::HiddenVisibility);
+            owner[&global] = 0;
+        }
+    }
 
-void BrainfuckCompiler::handleIncrementByte() {
-    // Load current pointer
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+    std::vector<llvm::SmallVector<char, 0>> bitcode(partitions);
+    for (unsigned partition{}; partition < partitions; ++partition) {
+        llvm::ValueToValueMapTy valueMap;
+        std::unique_ptr<llvm::Module> module =
+            llvm::CloneModule(*m_module, valueMap, [&](const llvm::GlobalValue* global) {
+                auto found = owner.find(global);
+                return found == owner.end() ? global->hasLocalLinkage() : found->second == partition;
+            });
+        module->setModuleIdentifier(m_module->getModuleIdentifier() + ".part" + std::to_string(partition));
+        if (partition != 0) {
+            // Module assembly defines its symbols once
+            module->setModuleInlineAsm("");
+        }
 
-    // Load current byte value
-    llvm::Value* currentValue = m_builder->CreateLoad(llvm::Type::getInt8Ty(*m_context), currentPtr, "current_val");
+        // Drop the copies this partition does not use, until only reachable ones remain
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (llvm::Function& function : llvm::make_early_inc_range(*module)) {
+                if (function.hasLocalLinkage() && function.use_empty()) {
+                    function.eraseFromParent();
+                    changed = true;
+                }
+            }
+            for (llvm::GlobalVariable& global : llvm::make_early_inc_range(module->globals())) {
+                if (global.hasLocalLinkage() && global.use_empty()) {
+                    global.eraseFromParent();
+                    changed = true;
+                }
+            }
+        }
 
-    // Byte value increment (8-bit unsigned addition)
-    llvm::Value* newValue =
-        m_builder->CreateAdd(currentValue, llvm::ConstantInt::get(llvm::Type::getInt8Ty(*m_context), 1), "val_inc",
-                             true, // Signed overflow
-                             true // Unsigned overflow
-        );
+        // Contexts are not thread-safe, each partition is read back into its own context
+        llvm::raw_svector_ostream stream(bitcode[partition]);
+        llvm::WriteBitcodeToFile(*module, stream);
+    }
 
-    // Store new byte value
-    m_builder->CreateStore(newValue, currentPtr);
+    return bitcode;
 }
 
-void BrainfuckCompiler::handleDecrementByte() {
-    // Load current pointer
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+bool BrainfuckCompiler::compilePartitions(std::vector<llvm::SmallVector<char, 0>>& objects) {
+    std::size_t units = llvm::count_if(*m_module, [](const llvm::Function& function) {
+        return !function.isDeclaration() && !function.hasLocalLinkage();
+    });
+    unsigned partitions = static_cast<unsigned>(std::min<std::size_t>(m_compileThreads, units));
+    std::vector<llvm::SmallVector<char, 0>> bitcode;
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "Module splitting");
+        bitcode = splitModule(std::max(partitions, 1u));
+    }
 
-    // Load current byte value
-    llvm::Value* currentValue = m_builder->CreateLoad(llvm::Type::getInt8Ty(*m_context), currentPtr, "current_val");
+    // Optimize and generate code of the partitions in parallel, with a target machine per thread. The first
+    // partition is compiled on this thread, with the shared target machine and pipeline.
+    objects.assign(bitcode.size(), {});
+    std::vector<char> succeeded(bitcode.size(), false);
+    auto compilePartition = [&](std::size_t partition) {
+        llvm::LLVMContext context;
+#ifdef NDEBUG
+        context.setDiscardValueNames(true);
+#endif
+        llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode[partition].data(), bitcode[partition].size()),
+                                     "partition");
+        auto module = llvm::parseBitcodeFile(buffer, context);
+        if (!module) {
+            reportError("Cannot read partition: " + llvm::toString(module.takeError()));
+            return;
+        }
 
-    // Byte value decrement (8-bit unsigned subtraction)
-    llvm::Value* newValue =
-        m_builder->CreateSub(currentValue, llvm::ConstantInt::get(llvm::Type::getInt8Ty(*m_context), 1), "val_dec",
-                             true, // Signed overflow
-                             true // Unsigned overflow
-        );
+        std::unique_ptr<llvm::TargetMachine> ownTargetMachine;
+        llvm::TargetMachine* targetMachine = m_targetMachine.get();
+        if (partition != 0) {
+            if (!(ownTargetMachine = buildTargetMachine())) {
+                return;
+            }
+            targetMachine = ownTargetMachine.get();
+        }
 
-    // Store new byte value
-    m_builder->CreateStore(newValue, currentPtr);
-}
+        optimizeModule(**module, targetMachine);
+        succeeded[partition] = generateObject(**module, *targetMachine, objects[partition]);
+    };
 
-void BrainfuckCompiler::handleOutput() {
-    // Load current pointer
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+    BrainfuckTimeReport::Scope phase(m_timeReport, "Parallel optimization and codegen");
+    std::vector<std::thread> threads;
+    for (std::size_t partition = 1; partition < bitcode.size(); ++partition) {
+        threads.emplace_back(compilePartition, partition);
+    }
+    compilePartition(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
 
-    // Load current byte value
-    llvm::Value* currentValue = m_builder->CreateLoad(llvm::Type::getInt8Ty(*m_context), currentPtr, "output_val");
+    return llvm::all_of(succeeded, [](char partitionSucceeded) {
+        return partitionSucceeded;
+    });
+}
 
-    // Zero extend to 32-bit (putchar needs int parameter)
-    llvm::Value* extendedValue = m_builder->CreateZExt(currentValue, llvm::Type::getInt32Ty(*m_context), "output_int");
+bool BrainfuckCompiler::linkExecutable(llvm::ArrayRef<llvm::StringRef> objects, const std::string& executableFile) {
+    // Link in-process where the target's C library is known, anything else goes through the compiler driver
+    if (std::optional<bool> linked = linkInProcess(objects, executableFile)) {
+        return *linked;
+    }
 
-    // Call putchar
-    m_builder->CreateCall(m_putcharFunc, {extendedValue});
+    return linkWithDriver(objects, executableFile);
 }
 
-void BrainfuckCompiler::handleInput() {
-    // Call getchar
-    llvm::Value* inputValue = m_builder->CreateCall(m_getcharFunc, {}, "input_char");
+bool BrainfuckCompiler::getLinkArgs(const std::vector<std::string>& objectFiles, std::vector<std::string>& args) {
+    // Freestanding executables need nothing but their own object files
+    if (m_freestanding) {
+        args = {"-static", "-e", "_start"};
+        args.insert(args.end(), objectFiles.begin(), objectFiles.end());
+        return true;
+    }
 
-    // Truncate to 8-bit
-    llvm::Value* truncatedValue = m_builder->CreateTrunc(inputValue, llvm::Type::getInt8Ty(*m_context), "input_byte");
+    // Only glibc on Linux is known well enough to link without a compiler driver
+    const llvm::Triple& triple = m_module->getTargetTriple();
+    if (!triple.isOSLinux() || !triple.isGNUEnvironment()) {
+        return false;
+    }
 
-    // Load current pointer
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
+    const char* dynamicLinker = nullptr;
+    switch (triple.getArch()) {
+    case llvm::Triple::x86_64:
+        dynamicLinker = "/lib64/ld-linux-x86-64.so.2";
+        break;
+    case llvm::Triple::aarch64:
+        dynamicLinker = "/lib/ld-linux-aarch64.so.1";
+        break;
+    case llvm::Triple::riscv64:
+        dynamicLinker = "/lib/ld-linux-riscv64-lp64d.so.1";
+        break;
+    default:
+        return false;
+    }
 
-    // Store input value
-    m_builder->CreateStore(truncatedValue, currentPtr);
-}
+    if (!llvm::sys::fs::exists(dynamicLinker)) {
+        return false;
+    }
 
-void BrainfuckCompiler::handleLoopStart(std::size_t ip) {
-    // Create loop basic blocks
-    llvm::BasicBlock* loopHeader =
-        llvm::BasicBlock::Create(*m_context, "loop_header_" + std::to_string(ip), m_mainFunction);
+    // C library startup files, in the multiarch directory or a plain library directory
+    std::string multiarch = triple.getArchName().str() + "-linux-gnu";
+    std::string libraryDir;
+    for (const std::string& dir : {"/usr/lib/" + multiarch, "/lib/" + multiarch, std::string("/usr/lib64"),
+                                   std::string("/usr/lib")}) {
+        if (llvm::sys::fs::exists(dir + "/Scrt1.o") && llvm::sys::fs::exists(dir + "/crti.o") &&
+            llvm::sys::fs::exists(dir + "/crtn.o")) {
+            libraryDir = dir;
+            break;
+        }
+    }
 
-    llvm::BasicBlock* loopBody =
-        llvm::BasicBlock::Create(*m_context, "loop_body_" + std::to_string(ip), m_mainFunction);
+    if (libraryDir.empty()) {
+        return false;
+    }
 
-    llvm::BasicBlock* loopEnd = llvm::BasicBlock::Create(*m_context, "loop_end_" + std::to_string(ip), m_mainFunction);
+    // Position independent executable or shared object against the shared C library, which provides write/read/mmap
+    if (m_linkShared) {
+        args = {"-shared", "--eh-frame-hdr", libraryDir + "/crti.o"};
+    } else {
+        args = {"-pie", "--eh-frame-hdr", "-dynamic-linker", dynamicLinker};
+        args.insert(args.end(), {libraryDir + "/Scrt1.o", libraryDir + "/crti.o"});
+    }
+    args.insert(args.end(), objectFiles.begin(), objectFiles.end());
+    args.insert(args.end(), {"-L" + libraryDir, "-lc", libraryDir + "/crtn.o"});
+    return true;
+}
 
-    // Jump to loop header
-    m_builder->CreateBr(loopHeader);
+std::optional<bool> BrainfuckCompiler::linkInProcess(llvm::ArrayRef<llvm::StringRef> objects,
+                                                     const std::string& executableFile) {
+#ifdef BF_HAVE_LLD
+    // lld cannot run again after some failures, later links use the driver
+    static bool lldUsable = true;
+    if (!lldUsable) {
+        return std::nullopt;
+    }
 
-    // Set insert point to loop header
-    m_builder->SetInsertPoint(loopHeader);
+    // lld takes input files by name, temporary files are its only inputs
+    std::vector<std::string> objectFiles;
+    auto removeObjects = llvm::make_scope_exit([&] {
+        for (const std::string& objectFile : objectFiles) {
+            llvm::sys::fs::remove(objectFile);
+        }
+    });
+    for (llvm::StringRef object : objects) {
+        int fd;
+        llvm::SmallString<128> objectFile;
+        if (std::error_code ec = llvm::sys::fs::createTemporaryFile("bf", "o", fd, objectFile)) {
+            reportError("Cannot create temporary object file: " + ec.message());
+            return false;
+        }
+        objectFiles.push_back(std::string(objectFile));
 
-    // Load current byte value
-    llvm::Value* currentPtr = m_builder->CreateLoad(llvm::PointerType::get(*m_context, 0), m_dataPtr, "current_ptr");
-    llvm::Value* currentValue = m_builder->CreateLoad(llvm::Type::getInt8Ty(*m_context), currentPtr, "loop_val");
+        llvm::raw_fd_ostream stream(fd, true);
+        stream << object;
+    }
 
-    // Compare value to 0
-    llvm::Value* zero = llvm::ConstantInt::get(llvm::Type::getInt8Ty(*m_context), 0);
-    llvm::Value* condition = m_builder->CreateICmpEQ(currentValue, zero, "loop_cond");
+    std::vector<std::string> args;
+    if (!getLinkArgs(objectFiles, args)) {
+        return std::nullopt;
+    }
 
-    // Conditional branch
-    m_builder->CreateCondBr(condition, loopEnd, loopBody);
+    std::vector<const char*> argv = {"ld.lld", "-o", executableFile.c_str()};
+    for (const std::string& arg : args) {
+        argv.push_back(arg.c_str());
+    }
 
-    // Set insert point to loop body
-    m_builder->SetInsertPoint(loopBody);
+    std::string errors;
+    llvm::raw_string_ostream errorStream(errors);
+    lld::Result result = lld::lldMain(argv, llvm::outs(), errorStream, {{lld::Gnu, &lld::elf::link}});
+    lldUsable = result.canRunAgain;
 
-    // Push to loop stack
-    m_loopStartBlocks.push(loopHeader);
-    m_loopEndBlocks.push(loopEnd);
+    if (result.retCode != 0) {
+        reportError("Linking failed: " + errors);
+        return false;
+    }
+
+    return true;
+#else
+    (void)objects;
+    (void)executableFile;
+    return std::nullopt;
+#endif
 }
 
-void BrainfuckCompiler::handleLoopEnd(std::size_t ip) {
-    if (m_loopStartBlocks.empty() || m_loopEndBlocks.empty()) {
-        reportError("Syntax error: Extra right bracket ']' at position " + std::to_string(ip));
-        return;
+bool BrainfuckCompiler::linkWithDriver(llvm::ArrayRef<llvm::StringRef> objects, const std::string& executableFile) {
+    // The compiler driver knows the C library of any target
+    std::vector<std::string> objectFiles;
+    auto removeObjects = llvm::make_scope_exit([&] {
+        for (const std::string& objectFile : objectFiles) {
+            std::remove(objectFile.c_str());
+        }
+    });
+    std::string linkCommand =
+        std::string("clang ") + (m_freestanding ? "-nostdlib -static " : "") + (m_linkShared ? "-shared " : "");
+    if (!m_targetTriple.empty()) {
+        linkCommand += "--target=" + m_targetTriple + " ";
     }
+    for (std::size_t i{}; i < objects.size(); ++i) {
+        std::string objectFile = executableFile + (objects.size() > 1 ? "." + std::to_string(i) : "") + ".o";
+        std::error_code ec;
+        llvm::raw_fd_ostream dest(objectFile, ec, llvm::sys::fs::OF_None);
 
-    // Get loop basic blocks
-    llvm::BasicBlock* loopHeader = m_loopStartBlocks.top();
-    llvm::BasicBlock* loopEnd = m_loopEndBlocks.top();
+        if (ec) {
+            reportError("Cannot open output file: " + ec.message());
+            return false;
+        }
 
-    // Pop from loop stack
-    m_loopStartBlocks.pop();
-    m_loopEndBlocks.pop();
+        objectFiles.push_back(objectFile);
+        dest << objects[i];
+        linkCommand += objectFile + " ";
+    }
 
-    // Jump back to loop header
-    m_builder->CreateBr(loopHeader);
+    linkCommand += "-o " + executableFile;
+    int result = system(linkCommand.c_str());
 
-    // Set insert point to loop end block
-    m_builder->SetInsertPoint(loopEnd);
+    if (result != 0) {
+        reportError("Linking failed");
+        return false;
+    }
+
+    return true;
 }
 
-void BrainfuckCompiler::optimizeModule() {
-    // Create optimization pass manager
-    llvm::legacy::PassManager pm;
+llvm::Expected<llvm::orc::JITTargetMachineBuilder> BrainfuckCompiler::createJITTargetMachineBuilder() {
+    initializeLLVM();
+
+    // Describe the host, overriding CPU and features if requested
+    auto targetMachineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!targetMachineBuilder) {
+        return targetMachineBuilder.takeError();
+    }
+
+    if (m_targetCPU != "generic") {
+        targetMachineBuilder->setCPU(m_targetCPU);
+    }
+
+    if (!m_targetFeatures.empty()) {
+        llvm::SmallVector<llvm::StringRef, 16> features;
+        llvm::StringRef(m_targetFeatures).split(features, ',', -1, false);
+        targetMachineBuilder->addFeatures(std::vector<std::string>(features.begin(), features.end()));
+    }
 
-    // Add optimization passes
-    pm.add(llvm::createInstructionCombiningPass());
-    pm.add(llvm::createReassociatePass());
-    pm.add(llvm::createGVNPass());
-    pm.add(llvm::createCFGSimplificationPass());
+    targetMachineBuilder->setCodeGenOptLevel(m_targetMachine ? m_targetMachine->getOptLevel()
+                                                             : llvm::CodeGenOptLevel::Default);
 
-    // Run optimization
-    pm.run(*m_module);
+    return targetMachineBuilder;
 }
 
-void BrainfuckCompiler::emitObjectFile(std::string_view outputFile) {
-    // Get target machine
-    std::string error;
-    auto target = llvm::TargetRegistry::lookupTarget(m_module->getTargetTriple(), error);
+bool BrainfuckCompiler::addRuntimeSymbols(llvm::orc::LLJIT& jit) {
+    // JIT-compiled code shares the buffered I/O runtime with the interpreter
+    llvm::orc::SymbolMap runtimeSymbols;
+    auto addSymbol = [&](const char* name, auto* function) {
+        runtimeSymbols[jit.mangleAndIntern(name)] =
+            llvm::orc::ExecutorSymbolDef(llvm::orc::ExecutorAddr::fromPtr(function),
+                                         llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+    };
+    addSymbol("bf_output", &bf_output);
+    addSymbol("bf_write", &bf_write);
+    addSymbol("bf_input", &bf_input);
+    addSymbol("bf_flush", &bf_flush);
+    addSymbol("bf_tape_alloc", &bf_tape_alloc);
+    addSymbol("bf_tape_free", &bf_tape_free);
+    addSymbol("bf_bounds_error", &bf_bounds_error);
+    addSymbol("bf_profile_write", &bf_profile_write);
+    addSymbol("bf_io_output", &bf_io_output);
+    addSymbol("bf_io_write", &bf_io_write);
+    addSymbol("bf_io_input", &bf_io_input);
+    addSymbol("bf_io_flush", &bf_io_flush);
+    addSymbol("bf_io_bounds_error", &bf_io_bounds_error);
+
+    // Bounds checking state is shared with the host runtime as well
+    auto addVariable = [&](const char* name, auto* variable) {
+        runtimeSymbols[jit.mangleAndIntern(name)] = llvm::orc::ExecutorSymbolDef(
+            llvm::orc::ExecutorAddr::fromPtr(variable), llvm::JITSymbolFlags::Exported);
+    };
+    addVariable("bf_source_pos", &bf_source_pos);
+    addVariable("bf_bounds_tape", &bf_bounds_tape);
+
+    if (auto error = jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(runtimeSymbols)))) {
+        reportError("JIT runtime registration failed: " + llvm::toString(std::move(error)));
+        return false;
+    }
 
-    if (!target) {
-        reportError("Target lookup failed: " + error);
-        return;
+    // Resolve remaining library calls (such as memset) from the current process
+    auto processSymbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit.getDataLayout().getGlobalPrefix());
+    if (!processSymbols) {
+        reportError("JIT symbol resolution failed: " + llvm::toString(processSymbols.takeError()));
+        return false;
     }
+    jit.getMainJITDylib().addGenerator(std::move(*processSymbols));
 
-    // Target machine options
-    llvm::TargetOptions options;
-    auto targetMachine = target->createTargetMachine(m_module->getTargetTriple(), "generic", "", options,
-                                                     std::optional<llvm::Reloc::Model>());
+    return true;
+}
 
-    // Set data layout
-    m_module->setDataLayout(targetMachine->createDataLayout());
+std::unique_ptr<llvm::orc::LLJIT> BrainfuckCompiler::createJIT() {
+    auto targetMachineBuilder = createJITTargetMachineBuilder();
+    if (!targetMachineBuilder) {
+        reportError("JIT target detection failed: " + llvm::toString(targetMachineBuilder.takeError()));
+        return nullptr;
+    }
 
-    // Output filenames
-    std::string objectFile = std::string(outputFile) + ".o";
-    std::string executableFile = std::string(outputFile);
+    llvm::orc::LLJITBuilder builder;
+    builder.setJITTargetMachineBuilder(std::move(*targetMachineBuilder));
+    if (m_cache) {
+        builder.setCompileFunctionCreator(createCachingCompiler());
+    }
 
-    // Generate object file
-    std::error_code ec;
-    llvm::raw_fd_ostream dest(objectFile, ec, llvm::sys::fs::OF_None);
+    auto jit = builder.create();
+    if (!jit) {
+        reportError("JIT engine creation failed: " + llvm::toString(jit.takeError()));
+        return nullptr;
+    }
 
-    if (ec) {
-        reportError("Cannot open output file: " + ec.message());
-        return;
+    if (!addRuntimeSymbols(**jit)) {
+        return nullptr;
     }
 
-    // Create pass manager
-    llvm::legacy::PassManager pass;
+    return std::move(*jit);
+}
 
-    // Add object file generation pass
-    if (targetMachine->addPassesToEmitFile(pass, dest, nullptr, llvm::CodeGenFileType::ObjectFile)) {
-        reportError("Target machine does not support object file generation");
+void BrainfuckCompiler::executeJIT() {
+    auto targetMachineBuilder = createJITTargetMachineBuilder();
+    if (!targetMachineBuilder) {
+        reportError("JIT target detection failed: " + llvm::toString(targetMachineBuilder.takeError()));
         return;
     }
 
-    // Run pass
-    pass.run(*m_module);
-    dest.flush();
-
-    // Link to generate executable file
-    std::string linkCommand = "clang " + objectFile + " -o " + executableFile;
-    int result = system(linkCommand.c_str());
+    // Create lazy JIT, functions are compiled on first call through stubs
+    llvm::orc::LLLazyJITBuilder builder;
+    builder.setJITTargetMachineBuilder(std::move(*targetMachineBuilder));
+    if (m_cache) {
+        builder.setCompileFunctionCreator(createCachingCompiler());
+    }
 
-    if (result != 0) {
-        reportError("Linking failed");
+    auto jit = builder.create();
+    if (!jit) {
+        reportError("JIT engine creation failed: " + llvm::toString(jit.takeError()));
         return;
     }
 
-    // Delete object file
-    std::remove(objectFile.c_str());
+    // Compile only the requested function instead of the whole module
+    (*jit)->setPartitionFunction(llvm::orc::IRPartitionLayer::compileRequested);
+
+    // Optimize each function when it is materialized, cached object files are already optimized
+    if (m_optLevel != OptLevel::O0) {
+        (*jit)->getIRTransformLayer().setTransform(
+            [this](llvm::orc::ThreadSafeModule module,
+                   const llvm::orc::MaterializationResponsibility&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                module.withModuleDo([this](llvm::Module& m) {
+                    if (!isCached(m)) {
+                        optimizeModule(m);
+                    }
+                });
+                return module;
+            });
+    }
 
-    std::cout << "Compilation completed: " << executableFile << std::endl;
-}
+    if (!addRuntimeSymbols(**jit)) {
+        return;
+    }
 
-void BrainfuckCompiler::executeJIT() {
-    // Create JIT execution engine
-    std::string error;
-    llvm::ExecutionEngine* ee = llvm::EngineBuilder(std::move(m_module)).setErrorStr(&error).create();
+    // Hand the module over to the JIT
+    llvm::orc::ThreadSafeModule module(std::move(m_module), m_threadSafeContext);
+    if (auto error = (*jit)->addLazyIRModule(std::move(module))) {
+        reportError("JIT module loading failed: " + llvm::toString(std::move(error)));
+        return;
+    }
 
-    if (!ee) {
-        reportError("JIT engine creation failed: " + error);
+    // Look up main, which compiles main only
+    auto mainSymbol = (*jit)->lookup("main");
+    if (!mainSymbol) {
+        reportError("JIT symbol lookup failed: " + llvm::toString(mainSymbol.takeError()));
         return;
     }
 
     // Execute main function
-    std::vector<llvm::GenericValue> noargs;
-    llvm::GenericValue result = ee->runFunction(m_mainFunction, noargs);
-
-    std::cout << "JIT execution completed, return value: " << result.IntVal.getZExtValue() << std::endl;
+    auto* mainFunction = mainSymbol->toPtr<int (*)()>();
+    int result = mainFunction();
 
-    delete ee;
+    std::cout << "JIT execution completed, return value: " << result << std::endl;
 }
 
 void BrainfuckCompiler::createDebugInfo() {
@@ -496,6 +3171,7 @@ void BrainfuckCompiler::createDebugInfo() {
 void BrainfuckCompiler::finalizeDebugInfo() {
     if (m_diBuilder) {
         m_diBuilder->finalize();
+        m_diBuilder.reset();
     }
 }
 
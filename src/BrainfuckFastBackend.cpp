@@ -0,0 +1,1270 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/Memory.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include "BrainfuckFastBackend.h"
+#include "BrainfuckIR.h"
+#include "BrainfuckRuntime.h"
+#include "BrainfuckTimeReport.h"
+
+namespace {
+
+// Symbols the generated code refers to. Executables define the sections, main and the runtime functions
+// themselves and take write, read and memcpy from the C library; code run in memory calls the host runtime.
+enum Symbol : std::size_t {
+    TextSection,
+    RodataSection,
+    BssSection,
+    MainFunction,
+    OutputFunction,
+    WriteFunction,
+    InputFunction,
+    FlushFunction,
+    SystemWrite,
+    SystemRead,
+    SystemMemcpy,
+};
+
+// References in the generated instructions, named after their ELF relocation types
+enum class RelocationKind {
+    X86PC32, // 32-bit PC-relative displacement
+    X86PLT32, // 32-bit PC-relative call target
+    AArch64Call26, // BL target
+    AArch64AdrPage, // ADRP page distance
+    AArch64AddLo12, // ADD immediate of the offset within the page
+};
+
+struct Relocation {
+    std::size_t offset; // Position of the instruction in .text
+    RelocationKind kind;
+    Symbol symbol;
+    std::int64_t addend;
+};
+
+// Generated code and data, with references not yet resolved
+struct CodeImage {
+    std::vector<std::uint8_t> text;
+    std::vector<std::uint8_t> rodata;
+    std::size_t bssSize = 0;
+    std::map<Symbol, std::size_t> definitions; // Offsets of the functions defined in .text
+    std::vector<Relocation> relocations;
+};
+
+// .bss of executables: the I/O buffers and state of the runtime, then the tape
+constexpr std::size_t outputBufferOffset = 0;
+constexpr std::size_t inputBufferOffset = BF_RUNTIME_BUFFER_SIZE;
+constexpr std::size_t outputLengthOffset = 2 * BF_RUNTIME_BUFFER_SIZE;
+constexpr std::size_t inputPosOffset = outputLengthOffset + 8;
+constexpr std::size_t inputEndOffset = outputLengthOffset + 16;
+constexpr std::size_t tapeOffset = outputLengthOffset + 64;
+
+// Initial state of an executable's main, code run in memory gets its data pointer from the host
+struct EntryState {
+    std::int64_t pointerOffset = 0; // Data pointer in .bss
+    std::int64_t imageOffset = 0; // Destination of the initial tape image in .bss
+    std::int64_t imageRodataOffset = 0; // Initial tape image in .rodata
+    std::size_t imageSize = 0; // Image size in bytes, 0 if the tape starts zeroed
+};
+
+void writeLE(std::uint8_t* data, std::uint64_t value, unsigned bytes) {
+    for (unsigned i{}; i < bytes; ++i) {
+        data[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint64_t readLE(const std::uint8_t* data, unsigned bytes) {
+    std::uint64_t value = 0;
+    for (unsigned i{}; i < bytes; ++i) {
+        value |= std::uint64_t{data[i]} << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * Instruction emitter of one instruction set. The driver walks the IR once and asks for the
+ * fixed sequence of each operation; loops are closed by patching their forward branch.
+ */
+class Emitter {
+public:
+    Emitter(CodeImage& image, unsigned cellBytes) : m_image(image), m_cellBytes(cellBytes) {}
+    virtual ~Emitter() = default;
+
+    void emitProgram(const BrainfuckProgram& program, const std::vector<std::int64_t>& stringOffsets) {
+        for (const BrainfuckOp& op : program.ops()) {
+            std::int64_t disp = std::int64_t{op.offset} * m_cellBytes;
+            switch (op.kind) {
+            case BrainfuckOpKind::Add:
+                emitAdd(disp, op.value);
+                break;
+            case BrainfuckOpKind::Move:
+                emitMove(std::int64_t{op.value} * m_cellBytes);
+                break;
+            case BrainfuckOpKind::Output:
+                emitOutput(disp);
+                break;
+            case BrainfuckOpKind::Input:
+                emitInput(disp);
+                break;
+            case BrainfuckOpKind::LoopStart:
+                emitLoopStart();
+                break;
+            case BrainfuckOpKind::LoopEnd:
+                emitLoopEnd();
+                break;
+            case BrainfuckOpKind::SetZero:
+                emitSetZero(disp);
+                break;
+            case BrainfuckOpKind::MulAdd:
+                emitMulAdd(std::int64_t{op.srcOffset} * m_cellBytes, disp, op.value);
+                break;
+            case BrainfuckOpKind::Write:
+                emitWrite(stringOffsets[op.value], program.strings()[op.value].size());
+                break;
+            case BrainfuckOpKind::ScanRight:
+                emitScan(std::int64_t{op.value} * m_cellBytes);
+                break;
+            case BrainfuckOpKind::ScanLeft:
+                emitScan(-std::int64_t{op.value} * m_cellBytes);
+                break;
+            }
+        }
+    }
+
+    // Function entry and exit, main of an executable when entry is set, otherwise `int run(cell_t* ptr)`
+    virtual void emitEntry(const EntryState* entry) = 0;
+    virtual void emitExit(bool executable) = 0;
+
+    // Buffered I/O runtime of executables, mirroring BrainfuckRuntime.cpp
+    virtual void emitRuntime() = 0;
+
+protected:
+    // Operations, displacements and distances in bytes
+    virtual void emitAdd(std::int64_t disp, std::int32_t delta) = 0;
+    virtual void emitMove(std::int64_t distance) = 0;
+    virtual void emitOutput(std::int64_t disp) = 0;
+    virtual void emitInput(std::int64_t disp) = 0;
+    virtual void emitLoopStart() = 0;
+    virtual void emitLoopEnd() = 0;
+    virtual void emitSetZero(std::int64_t disp) = 0;
+    virtual void emitMulAdd(std::int64_t srcDisp, std::int64_t disp, std::int32_t factor) = 0;
+    virtual void emitWrite(std::int64_t rodataOffset, std::size_t size) = 0;
+    virtual void emitScan(std::int64_t stride) = 0;
+
+    std::size_t position() const {
+        return m_image.text.size();
+    }
+
+    void emit8(std::uint64_t value) {
+        m_image.text.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    void emitLE(std::uint64_t value, unsigned bytes) {
+        for (unsigned i{}; i < bytes; ++i) {
+            emit8(value >> (8 * i));
+        }
+    }
+
+    void emitBytes(std::initializer_list<std::uint8_t> bytes) {
+        m_image.text.insert(m_image.text.end(), bytes);
+    }
+
+    void relocate(RelocationKind kind, Symbol symbol, std::int64_t addend) {
+        m_image.relocations.push_back(Relocation{position(), kind, symbol, addend});
+    }
+
+    void define(Symbol symbol) {
+        m_image.definitions[symbol] = position();
+    }
+
+    CodeImage& m_image;
+    unsigned m_cellBytes;
+};
+
+/**
+ * x86-64, System V calling convention. rbx holds the data pointer, rax, rcx, rdx, rsi and rdi
+ * are scratch registers.
+ */
+class X86Emitter : public Emitter {
+public:
+    using Emitter::Emitter;
+
+    void emitEntry(const EntryState* entry) override {
+        define(MainFunction);
+        emit8(0x53); // push rbx, aligns the stack for calls
+        if (!entry) {
+            emitBytes({0x48, 0x89, 0xFB}); // mov rbx, rdi
+            return;
+        }
+
+        emitBytes({0x48, 0x8D}); // lea rbx, [rip + tape]
+        emitRipOperand(3, BssSection, entry->pointerOffset);
+        if (entry->imageSize > 0) {
+            emitBytes({0x48, 0x8D}); // lea rdi, [rip + image destination]
+            emitRipOperand(7, BssSection, entry->imageOffset);
+            emitBytes({0x48, 0x8D}); // lea rsi, [rip + image]
+            emitRipOperand(6, RodataSection, entry->imageRodataOffset);
+            emit8(0xBA); // mov edx, size
+            emitLE(entry->imageSize, 4);
+            emitCall(SystemMemcpy);
+        }
+    }
+
+    void emitExit(bool executable) override {
+        if (executable) {
+            emitCall(FlushFunction);
+        }
+        emitBytes({0x31, 0xC0}); // xor eax, eax
+        emit8(0x5B); // pop rbx
+        emit8(0xC3); // ret
+    }
+
+    void emitRuntime() override {
+        // bf_flush: write the whole output buffer, retrying partial writes
+        define(FlushFunction);
+        {
+            emit8(0x53); // push rbx
+            emitBytes({0x31, 0xDB}); // xor ebx, ebx: bytes written
+            std::size_t loop = position();
+            emitBytes({0x48, 0x8B}); // mov rdx, [rip + length]
+            emitRipOperand(2, BssSection, outputLengthOffset);
+            emitBytes({0x48, 0x29, 0xDA}); // sub rdx, rbx
+            std::size_t empty = emitJump({0x0F, 0x86}); // jbe done
+            emit8(0xBF); // mov edi, 1
+            emitLE(1, 4);
+            emitBytes({0x48, 0x8D}); // lea rsi, [rip + buffer]
+            emitRipOperand(6, BssSection, outputBufferOffset);
+            emitBytes({0x48, 0x01, 0xDE}); // add rsi, rbx
+            emitCall(SystemWrite);
+            emitBytes({0x48, 0x85, 0xC0}); // test rax, rax
+            std::size_t failed = emitJump({0x0F, 0x8E}); // jle done
+            emitBytes({0x48, 0x01, 0xC3}); // add rbx, rax
+            bindJump(emitJump({0xE9}), loop); // jmp loop
+            bindJump(empty, position());
+            bindJump(failed, position());
+            emitBytes({0x48, 0xC7}); // mov qword [rip + length], 0
+            emitRipOperand(0, BssSection, outputLengthOffset, 4);
+            emitLE(0, 4);
+            emit8(0x5B); // pop rbx
+            emit8(0xC3); // ret
+        }
+
+        // bf_output: append one byte, flushing a full buffer first
+        define(OutputFunction);
+        {
+            std::size_t top = position();
+            emitBytes({0x48, 0x8B}); // mov rax, [rip + length]
+            emitRipOperand(0, BssSection, outputLengthOffset);
+            emitBytes({0x48, 0x3D}); // cmp rax, buffer size
+            emitLE(BF_RUNTIME_BUFFER_SIZE, 4);
+            std::size_t append = emitJump({0x0F, 0x85}); // jne append
+            emit8(0x57); // push rdi
+            emitCall(FlushFunction);
+            emit8(0x5F); // pop rdi
+            bindJump(emitJump({0xE9}), top); // jmp top
+            bindJump(append, position());
+            emitBytes({0x48, 0x8D}); // lea rcx, [rip + buffer]
+            emitRipOperand(1, BssSection, outputBufferOffset);
+            emitBytes({0x40, 0x88, 0x3C, 0x01}); // mov [rcx + rax], dil
+            emitBytes({0x48, 0xFF, 0xC0}); // inc rax
+            emitBytes({0x48, 0x89}); // mov [rip + length], rax
+            emitRipOperand(0, BssSection, outputLengthOffset);
+            emit8(0xC3); // ret
+        }
+
+        // bf_write: output a constant string byte by byte
+        define(WriteFunction);
+        {
+            emitBytes({0x53, 0x41, 0x54, 0x50}); // push rbx; push r12; push rax
+            emitBytes({0x48, 0x89, 0xFB}); // mov rbx, rdi
+            emitBytes({0x49, 0x89, 0xF4}); // mov r12, rsi
+            std::size_t loop = position();
+            emitBytes({0x4D, 0x85, 0xE4}); // test r12, r12
+            std::size_t done = emitJump({0x0F, 0x84}); // je done
+            emitBytes({0x0F, 0xB6, 0x3B}); // movzx edi, byte [rbx]
+            emitCall(OutputFunction);
+            emitBytes({0x48, 0xFF, 0xC3}); // inc rbx
+            emitBytes({0x49, 0xFF, 0xCC}); // dec r12
+            bindJump(emitJump({0xE9}), loop); // jmp loop
+            bindJump(done, position());
+            emitBytes({0x58, 0x41, 0x5C, 0x5B}); // pop rax; pop r12; pop rbx
+            emit8(0xC3); // ret
+        }
+
+        // bf_input: return the next input byte, reading a new block when the buffer is empty, 255 at end of input
+        define(InputFunction);
+        {
+            std::size_t top = position();
+            emitBytes({0x48, 0x8B}); // mov rax, [rip + pos]
+            emitRipOperand(0, BssSection, inputPosOffset);
+            emitBytes({0x48, 0x3B}); // cmp rax, [rip + end]
+            emitRipOperand(0, BssSection, inputEndOffset);
+            std::size_t next = emitJump({0x0F, 0x85}); // jne next
+            emit8(0x50); // push rax
+            emitCall(FlushFunction); // Prompts written so far must be visible before blocking on input
+            emitBytes({0x31, 0xFF}); // xor edi, edi
+            emitBytes({0x48, 0x8D}); // lea rsi, [rip + buffer]
+            emitRipOperand(6, BssSection, inputBufferOffset);
+            emit8(0xBA); // mov edx, buffer size
+            emitLE(BF_RUNTIME_BUFFER_SIZE, 4);
+            emitCall(SystemRead);
+            emit8(0x59); // pop rcx
+            emitBytes({0x48, 0x85, 0xC0}); // test rax, rax
+            std::size_t endOfInput = emitJump({0x0F, 0x8E}); // jle end of input
+            emitBytes({0x48, 0x89}); // mov [rip + end], rax
+            emitRipOperand(0, BssSection, inputEndOffset);
+            emitBytes({0x48, 0xC7}); // mov qword [rip + pos], 0
+            emitRipOperand(0, BssSection, inputPosOffset, 4);
+            emitLE(0, 4);
+            bindJump(emitJump({0xE9}), top); // jmp top
+            bindJump(next, position());
+            emitBytes({0x48, 0x8D}); // lea rcx, [rip + buffer]
+            emitRipOperand(1, BssSection, inputBufferOffset);
+            emitBytes({0x0F, 0xB6, 0x14, 0x01}); // movzx edx, byte [rcx + rax]
+            emitBytes({0x48, 0xFF, 0xC0}); // inc rax
+            emitBytes({0x48, 0x89}); // mov [rip + pos], rax
+            emitRipOperand(0, BssSection, inputPosOffset);
+            emitBytes({0x89, 0xD0}); // mov eax, edx
+            emit8(0xC3); // ret
+            bindJump(endOfInput, position());
+            emit8(0xB8); // mov eax, 255
+            emitLE(255, 4);
+            emit8(0xC3); // ret
+        }
+    }
+
+protected:
+    void emitAdd(std::int64_t disp, std::int32_t delta) override {
+        emitCellImmediate(0, disp, delta); // add cell, delta
+    }
+
+    void emitMove(std::int64_t distance) override {
+        if (distance == 0) {
+            return;
+        }
+        // add rbx, distance
+        if (llvm::isInt<8>(distance)) {
+            emitBytes({0x48, 0x83, 0xC3});
+            emit8(distance);
+        } else {
+            emitBytes({0x48, 0x81, 0xC3});
+            emitLE(distance, 4);
+        }
+    }
+
+    void emitOutput(std::int64_t disp) override {
+        // movzx edi, byte cell: the low byte is the first on little-endian targets
+        emitBytes({0x0F, 0xB6});
+        emitCellOperand(7, disp);
+        emitCall(OutputFunction);
+    }
+
+    void emitInput(std::int64_t disp) override {
+        emitCall(InputFunction);
+        if (m_cellBytes > 1) {
+            emitBytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+        }
+        emitCellRegister(0x88, 0x89, 0, disp); // mov cell, eax
+    }
+
+    void emitLoopStart() override {
+        emitCellImmediate(7, 0, 0); // cmp cell, 0
+        std::size_t exit = emitJump({0x0F, 0x84}); // je after the loop
+        m_loops.push_back(Loop{exit, position()});
+    }
+
+    void emitLoopEnd() override {
+        Loop loop = m_loops.back();
+        m_loops.pop_back();
+
+        emitCellImmediate(7, 0, 0); // cmp cell, 0
+        std::int64_t back = static_cast<std::int64_t>(loop.body) - static_cast<std::int64_t>(position() + 2);
+        if (llvm::isInt<8>(back)) {
+            emit8(0x75); // jne body
+            emit8(back);
+        } else {
+            bindJump(emitJump({0x0F, 0x85}), loop.body);
+        }
+        bindJump(loop.exit, position());
+    }
+
+    void emitSetZero(std::int64_t disp) override {
+        // mov cell, 0
+        if (m_cellBytes == 1) {
+            emit8(0xC6);
+            emitCellOperand(0, disp);
+            emit8(0);
+            return;
+        }
+        emitWidthPrefix();
+        emit8(0xC7);
+        emitCellOperand(0, disp);
+        emitLE(0, m_cellBytes == 2 ? 2 : 4);
+    }
+
+    void emitMulAdd(std::int64_t srcDisp, std::int64_t disp, std::int32_t factor) override {
+        // Load the counter zero-extended into eax
+        static const std::uint8_t loads[][2] = {{0x0F, 0xB6}, {0x0F, 0xB7}, {0x8B, 0}, {0x8B, 0}};
+        const std::uint8_t* load = loads[llvm::Log2_32(m_cellBytes)];
+        if (m_cellBytes == 8) {
+            emit8(0x48);
+        }
+        emit8(load[0]);
+        if (load[1]) {
+            emit8(load[1]);
+        }
+        emitCellOperand(0, srcDisp);
+
+        if (factor == -1) {
+            emitCellRegister(0x28, 0x29, 0, disp); // sub cell, eax
+            return;
+        }
+        if (factor != 1) {
+            // imul eax, eax, factor
+            if (m_cellBytes == 8) {
+                emit8(0x48);
+            }
+            emitBytes({0x69, 0xC0});
+            emitLE(static_cast<std::uint32_t>(factor), 4);
+        }
+        emitCellRegister(0x00, 0x01, 0, disp); // add cell, eax
+    }
+
+    void emitWrite(std::int64_t rodataOffset, std::size_t size) override {
+        emitBytes({0x48, 0x8D}); // lea rdi, [rip + string]
+        emitRipOperand(7, RodataSection, rodataOffset);
+        emit8(0xBE); // mov esi, size
+        emitLE(size, 4);
+        emitCall(WriteFunction);
+    }
+
+    void emitScan(std::int64_t stride) override {
+        // Test first: jmp test; step: add rbx, stride; test: cmp cell, 0; jne step
+        std::size_t test = emitShortJump(0xEB);
+        std::size_t step = position();
+        emitMove(stride);
+        bindShortJump(test, position());
+        emitCellImmediate(7, 0, 0);
+        emit8(0x75);
+        emit8(static_cast<std::int64_t>(step) - static_cast<std::int64_t>(position() + 1));
+    }
+
+private:
+    struct Loop {
+        std::size_t exit; // rel32 of the forward branch
+        std::size_t body; // First instruction of the body
+    };
+
+    // Operand size prefix of 16-bit and 64-bit cells
+    void emitWidthPrefix() {
+        if (m_cellBytes == 2) {
+            emit8(0x66);
+        } else if (m_cellBytes == 8) {
+            emit8(0x48);
+        }
+    }
+
+    // ModRM and displacement of [rbx + disp]
+    void emitCellOperand(unsigned reg, std::int64_t disp) {
+        if (disp == 0) {
+            emit8(0x03 | reg << 3);
+        } else if (llvm::isInt<8>(disp)) {
+            emit8(0x43 | reg << 3);
+            emit8(disp);
+        } else {
+            emit8(0x83 | reg << 3);
+            emitLE(disp, 4);
+        }
+    }
+
+    // ModRM and displacement of [rip + symbol + offset], immediates after the displacement move the reference point
+    void emitRipOperand(unsigned reg, Symbol symbol, std::int64_t offset, unsigned immediateBytes = 0) {
+        emit8(0x05 | reg << 3);
+        relocate(RelocationKind::X86PC32, symbol, offset - 4 - immediateBytes);
+        emitLE(0, 4);
+    }
+
+    // Group 1 arithmetic of a cell with an immediate: /0 add, /7 cmp
+    void emitCellImmediate(unsigned operation, std::int64_t disp, std::int32_t value) {
+        if (m_cellBytes == 1) {
+            emit8(0x80);
+            emitCellOperand(operation, disp);
+            emit8(value);
+            return;
+        }
+        emitWidthPrefix();
+        bool shortImmediate = llvm::isInt<8>(value);
+        emit8(shortImmediate ? 0x83 : 0x81);
+        emitCellOperand(operation, disp);
+        emitLE(static_cast<std::uint32_t>(value), shortImmediate ? 1 : (m_cellBytes == 2 ? 2 : 4));
+    }
+
+    // Register to cell operation, byteOpcode for byte cells and wordOpcode for wider ones
+    void emitCellRegister(std::uint8_t byteOpcode, std::uint8_t wordOpcode, unsigned reg, std::int64_t disp) {
+        if (m_cellBytes == 1) {
+            emit8(byteOpcode);
+        } else {
+            emitWidthPrefix();
+            emit8(wordOpcode);
+        }
+        emitCellOperand(reg, disp);
+    }
+
+    void emitCall(Symbol function) {
+        emit8(0xE8);
+        relocate(RelocationKind::X86PLT32, function, -4);
+        emitLE(0, 4);
+    }
+
+    // Jump with a rel32 target, returns the position of the displacement
+    std::size_t emitJump(std::initializer_list<std::uint8_t> opcode) {
+        emitBytes(opcode);
+        std::size_t displacement = position();
+        emitLE(0, 4);
+        return displacement;
+    }
+
+    void bindJump(std::size_t displacement, std::size_t target) {
+        writeLE(&m_image.text[displacement], target - (displacement + 4), 4);
+    }
+
+    std::size_t emitShortJump(std::uint8_t opcode) {
+        emit8(opcode);
+        emit8(0);
+        return position() - 1;
+    }
+
+    void bindShortJump(std::size_t displacement, std::size_t target) {
+        m_image.text[displacement] = static_cast<std::uint8_t>(target - (displacement + 1));
+    }
+
+    std::vector<Loop> m_loops;
+};
+
+/**
+ * AArch64, AAPCS64. x19 holds the data pointer, x9 to x17 are scratch registers, x16 and x17
+ * materialize addresses and immediates.
+ */
+class AArch64Emitter : public Emitter {
+public:
+    using Emitter::Emitter;
+
+    void emitEntry(const EntryState* entry) override {
+        define(MainFunction);
+        emitPrologue();
+        if (!entry) {
+            emit32(0xAA0003F3); // mov x19, x0
+            return;
+        }
+
+        emitAddress(19, BssSection, entry->pointerOffset);
+        if (entry->imageSize > 0) {
+            emitAddress(0, BssSection, entry->imageOffset);
+            emitAddress(1, RodataSection, entry->imageRodataOffset);
+            emitMovImmediate(2, static_cast<std::int64_t>(entry->imageSize), true);
+            emitCall(SystemMemcpy);
+        }
+    }
+
+    void emitExit(bool executable) override {
+        if (executable) {
+            emitCall(FlushFunction);
+        }
+        emit32(0x52800000); // mov w0, #0
+        emitEpilogue();
+    }
+
+    void emitRuntime() override {
+        // bf_flush: write the whole output buffer, retrying partial writes
+        define(FlushFunction);
+        {
+            emitPrologue();
+            emit32(0xD2800013); // mov x19, #0: bytes written
+            std::size_t loop = position();
+            emitAddress(16, BssSection, outputLengthOffset);
+            emit32(0xF9400202); // ldr x2, [x16]
+            emit32(0xEB130042); // subs x2, x2, x19
+            std::size_t empty = emitBranch(0x54000009); // b.ls done
+            emit32(0x52800020); // mov w0, #1
+            emitAddress(1, BssSection, outputBufferOffset);
+            emit32(0x8B130021); // add x1, x1, x19
+            emitCall(SystemWrite);
+            emit32(0xF100001F); // cmp x0, #0
+            std::size_t failed = emitBranch(0x5400000D); // b.le done
+            emit32(0x8B000273); // add x19, x19, x0
+            bindBranch(emitBranch(0x14000000), loop); // b loop
+            bindBranch(empty, position());
+            bindBranch(failed, position());
+            emitAddress(16, BssSection, outputLengthOffset);
+            emit32(0xF900021F); // str xzr, [x16]
+            emitEpilogue();
+        }
+
+        // bf_output: append one byte, flushing a full buffer first
+        define(OutputFunction);
+        {
+            std::size_t top = position();
+            emitAddress(16, BssSection, outputLengthOffset);
+            emit32(0xF9400211); // ldr x17, [x16]
+            emit32(0xF140423F); // cmp x17, #16, lsl #12: the buffer size
+            std::size_t append = emitBranch(0x54000001); // b.ne append
+            emit32(0xA9BE7BFD); // stp x29, x30, [sp, #-32]!
+            emit32(0x910003FD); // mov x29, sp
+            emit32(0xF9000BE0); // str x0, [sp, #16]
+            emitCall(FlushFunction);
+            emit32(0xF9400BE0); // ldr x0, [sp, #16]
+            emit32(0xA8C27BFD); // ldp x29, x30, [sp], #32
+            bindBranch(emitBranch(0x14000000), top); // b top
+            bindBranch(append, position());
+            emitAddress(15, BssSection, outputBufferOffset);
+            emit32(0x383169E0); // strb w0, [x15, x17]
+            emit32(0x91000631); // add x17, x17, #1
+            emit32(0xF9000211); // str x17, [x16]
+            emit32(0xD65F03C0); // ret
+        }
+
+        // bf_write: output a constant string byte by byte
+        define(WriteFunction);
+        {
+            emit32(0xA9BE7BFD); // stp x29, x30, [sp, #-32]!
+            emit32(0x910003FD); // mov x29, sp
+            emit32(0xA90153F3); // stp x19, x20, [sp, #16]
+            emit32(0xAA0003F3); // mov x19, x0
+            emit32(0xAA0103F4); // mov x20, x1
+            std::size_t loop = position();
+            std::size_t done = emitBranch(0xB4000014); // cbz x20, done
+            emit32(0x38401660); // ldrb w0, [x19], #1
+            emitCall(OutputFunction);
+            emit32(0xD1000694); // sub x20, x20, #1
+            bindBranch(emitBranch(0x14000000), loop); // b loop
+            bindBranch(done, position());
+            emit32(0xA94153F3); // ldp x19, x20, [sp, #16]
+            emit32(0xA8C27BFD); // ldp x29, x30, [sp], #32
+            emit32(0xD65F03C0); // ret
+        }
+
+        // bf_input: return the next input byte, reading a new block when the buffer is empty, 255 at end of input
+        define(InputFunction);
+        {
+            std::size_t top = position();
+            emitAddress(16, BssSection, inputPosOffset);
+            emit32(0xF9400211); // ldr x17, [x16]
+            emitAddress(15, BssSection, inputEndOffset);
+            emit32(0xF94001EE); // ldr x14, [x15]
+            emit32(0xEB0E023F); // cmp x17, x14
+            std::size_t next = emitBranch(0x54000001); // b.ne next
+            emit32(0xA9BF7BFD); // stp x29, x30, [sp, #-16]!
+            emit32(0x910003FD); // mov x29, sp
+            emitCall(FlushFunction); // Prompts written so far must be visible before blocking on input
+            emit32(0x52800000); // mov w0, #0
+            emitAddress(1, BssSection, inputBufferOffset);
+            emitMovImmediate(2, BF_RUNTIME_BUFFER_SIZE, true);
+            emitCall(SystemRead);
+            emit32(0xA8C17BFD); // ldp x29, x30, [sp], #16
+            emit32(0xF100001F); // cmp x0, #0
+            std::size_t endOfInput = emitBranch(0x5400000D); // b.le end of input
+            emitAddress(15, BssSection, inputEndOffset);
+            emit32(0xF90001E0); // str x0, [x15]
+            emitAddress(16, BssSection, inputPosOffset);
+            emit32(0xF900021F); // str xzr, [x16]
+            bindBranch(emitBranch(0x14000000), top); // b top
+            bindBranch(next, position());
+            emitAddress(15, BssSection, inputBufferOffset);
+            emit32(0x387169E0); // ldrb w0, [x15, x17]
+            emit32(0x91000631); // add x17, x17, #1
+            emit32(0xF9000211); // str x17, [x16]
+            emit32(0xD65F03C0); // ret
+            bindBranch(endOfInput, position());
+            emit32(0x52801FE0); // mov w0, #255
+            emit32(0xD65F03C0); // ret
+        }
+    }
+
+protected:
+    void emitAdd(std::int64_t disp, std::int32_t delta) override {
+        emitCellAccess(true, 9, disp);
+        emitAddImmediate(9, 9, delta, m_cellBytes == 8);
+        emitCellAccess(false, 9, disp);
+    }
+
+    void emitMove(std::int64_t distance) override {
+        emitAddImmediate(19, 19, distance, true);
+    }
+
+    void emitOutput(std::int64_t disp) override {
+        emitAccess(true, 0, disp, 0); // ldrb w0, cell: the low byte is the first on little-endian targets
+        emitCall(OutputFunction);
+    }
+
+    void emitInput(std::int64_t disp) override {
+        emitCall(InputFunction);
+        emit32(0x53001C00); // uxtb w0, w0, the upper bits of a byte result are unspecified
+        emitCellAccess(false, 0, disp);
+    }
+
+    void emitLoopStart() override {
+        // The exit distance is not known yet, a plain branch reaches any loop end
+        emitCellAccess(true, 9, 0);
+        emit32(compareBranch(true) | 2 << 5 | 9); // cbnz w9, body
+        std::size_t exit = emitBranch(0x14000000); // b after the loop
+        m_loops.push_back(Loop{exit, position()});
+    }
+
+    void emitLoopEnd() override {
+        Loop loop = m_loops.back();
+        m_loops.pop_back();
+
+        emitCellAccess(true, 9, 0);
+        std::int64_t back = (static_cast<std::int64_t>(loop.body) - static_cast<std::int64_t>(position())) / 4;
+        if (llvm::isInt<19>(back)) {
+            emit32(compareBranch(true) | (static_cast<std::uint32_t>(back) & 0x7FFFF) << 5 | 9); // cbnz w9, body
+        } else {
+            emit32(compareBranch(false) | 2 << 5 | 9); // cbz w9, after the loop
+            bindBranch(emitBranch(0x14000000), loop.body); // b body
+        }
+        bindBranch(loop.exit, position());
+    }
+
+    void emitSetZero(std::int64_t disp) override {
+        emitCellAccess(false, 31, disp); // str wzr, cell
+    }
+
+    void emitMulAdd(std::int64_t srcDisp, std::int64_t disp, std::int32_t factor) override {
+        bool wide = m_cellBytes == 8;
+        emitCellAccess(true, 9, srcDisp);
+        emitCellAccess(true, 10, disp);
+        if (factor == 1) {
+            emit32((wide ? 0x8B000000 : 0x0B000000) | 9 << 16 | 10 << 5 | 10); // add w10, w10, w9
+        } else if (factor == -1) {
+            emit32((wide ? 0xCB000000 : 0x4B000000) | 9 << 16 | 10 << 5 | 10); // sub w10, w10, w9
+        } else {
+            emitMovImmediate(11, factor, wide);
+            emit32((wide ? 0x9B000000 : 0x1B000000) | 11 << 16 | 10 << 10 | 9 << 5 | 10); // madd w10, w9, w11, w10
+        }
+        emitCellAccess(false, 10, disp);
+    }
+
+    void emitWrite(std::int64_t rodataOffset, std::size_t size) override {
+        emitAddress(0, RodataSection, rodataOffset);
+        emitMovImmediate(1, static_cast<std::int64_t>(size), true);
+        emitCall(WriteFunction);
+    }
+
+    void emitScan(std::int64_t stride) override {
+        // loop: ldr w9, cell; cbz w9, done; add x19, x19, stride; b loop
+        std::size_t loop = position();
+        emitCellAccess(true, 9, 0);
+        std::size_t done = emitBranch(compareBranch(false) | 9);
+        emitMove(stride);
+        bindBranch(emitBranch(0x14000000), loop);
+        bindBranch(done, position());
+    }
+
+private:
+    struct Loop {
+        std::size_t exit; // B to the end of the loop
+        std::size_t body; // First instruction of the body
+    };
+
+    void emit32(std::uint32_t instruction) {
+        emitLE(instruction, 4);
+    }
+
+    void emitPrologue() {
+        emit32(0xA9BE7BFD); // stp x29, x30, [sp, #-32]!
+        emit32(0x910003FD); // mov x29, sp
+        emit32(0xF9000BF3); // str x19, [sp, #16]
+    }
+
+    void emitEpilogue() {
+        emit32(0xF9400BF3); // ldr x19, [sp, #16]
+        emit32(0xA8C27BFD); // ldp x29, x30, [sp], #32
+        emit32(0xD65F03C0); // ret
+    }
+
+    // CBNZ or CBZ on the register width of a cell
+    std::uint32_t compareBranch(bool nonZero) const {
+        return (m_cellBytes == 8 ? 0xB4000000 : 0x34000000) | (nonZero ? 1u << 24 : 0);
+    }
+
+    // adrp rd, symbol; add rd, rd, :lo12:symbol
+    void emitAddress(unsigned rd, Symbol symbol, std::int64_t offset) {
+        relocate(RelocationKind::AArch64AdrPage, symbol, offset);
+        emit32(0x90000000 | rd);
+        relocate(RelocationKind::AArch64AddLo12, symbol, offset);
+        emit32(0x91000000 | rd << 5 | rd);
+    }
+
+    void emitCall(Symbol function) {
+        relocate(RelocationKind::AArch64Call26, function, 0);
+        emit32(0x94000000);
+    }
+
+    // Load or store of a cell into rt
+    void emitCellAccess(bool load, unsigned rt, std::int64_t disp) {
+        emitAccess(load, rt, disp, llvm::Log2_32(m_cellBytes));
+    }
+
+    // Load or store of 2^sizeLog2 bytes at [x19 + disp]: scaled offset, unscaled offset or an offset register
+    void emitAccess(bool load, unsigned rt, std::int64_t disp, unsigned sizeLog2) {
+        std::uint32_t size = sizeLog2 << 30;
+        std::int64_t scaled = disp >> sizeLog2;
+        if (disp >= 0 && (disp & ((1 << sizeLog2) - 1)) == 0 && scaled < 4096) {
+            emit32((load ? 0x39400000 : 0x39000000) | size | static_cast<std::uint32_t>(scaled) << 10 | 19 << 5 | rt);
+        } else if (llvm::isInt<9>(disp)) {
+            emit32((load ? 0x38400000 : 0x38000000) | size | (static_cast<std::uint32_t>(disp) & 0x1FF) << 12 |
+                   19 << 5 | rt);
+        } else {
+            emitMovImmediate(16, disp, true);
+            emit32((load ? 0x38606800 : 0x38206800) | size | 16 << 16 | 19 << 5 | rt);
+        }
+    }
+
+    // rd = rn + value, through x17 if the value is no 12-bit immediate
+    void emitAddImmediate(unsigned rd, unsigned rn, std::int64_t value, bool wide) {
+        std::uint32_t sf = wide ? 1u << 31 : 0;
+        std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+        std::uint32_t operation = value < 0 ? 0x51000000 : 0x11000000; // SUB or ADD immediate
+        if (magnitude < 4096) {
+            if (magnitude != 0 || rd != rn) {
+                emit32(sf | operation | static_cast<std::uint32_t>(magnitude) << 10 | rn << 5 | rd);
+            }
+        } else if ((magnitude & 0xFFF) == 0 && magnitude >> 12 < 4096) {
+            emit32(sf | operation | 1 << 22 | static_cast<std::uint32_t>(magnitude >> 12) << 10 | rn << 5 | rd);
+        } else {
+            emitMovImmediate(17, value, wide);
+            emit32(sf | 0x0B000000 | 17 << 16 | rn << 5 | rd); // add rd, rn, x17
+        }
+    }
+
+    // MOVZ or MOVN, then MOVK for the remaining 16-bit chunks
+    void emitMovImmediate(unsigned rd, std::int64_t value, bool wide) {
+        unsigned chunks = wide ? 4 : 2;
+        std::uint64_t bits = wide ? static_cast<std::uint64_t>(value) : static_cast<std::uint32_t>(value);
+        auto chunk = [&](unsigned i) {
+            return static_cast<std::uint32_t>(bits >> (16 * i)) & 0xFFFF;
+        };
+
+        // MOVN when more chunks are all ones than all zeros, each remaining chunk takes one instruction
+        int balance = 0;
+        for (unsigned i{}; i < chunks; ++i) {
+            balance += (chunk(i) == 0xFFFF) - (chunk(i) == 0);
+        }
+        bool inverted = balance > 0;
+        std::uint32_t sf = wide ? 1u << 31 : 0;
+        std::uint32_t skip = inverted ? 0xFFFF : 0;
+
+        bool first = true;
+        for (unsigned i{}; i < chunks; ++i) {
+            std::uint32_t value16 = chunk(i);
+            if (value16 == skip && !(first && i == chunks - 1)) {
+                continue;
+            }
+            if (first) {
+                std::uint32_t opcode = inverted ? 0x12800000 : 0x52800000; // MOVN or MOVZ
+                emit32(sf | opcode | i << 21 | (inverted ? ~value16 & 0xFFFF : value16) << 5 | rd);
+                first = false;
+            } else {
+                emit32(sf | 0x72800000 | i << 21 | value16 << 5 | rd); // MOVK
+            }
+        }
+    }
+
+    // Branch with a 26-bit or 19-bit target, returns its position
+    std::size_t emitBranch(std::uint32_t instruction) {
+        std::size_t branch = position();
+        emit32(instruction);
+        return branch;
+    }
+
+    void bindBranch(std::size_t branch, std::size_t target) {
+        std::uint32_t instruction = static_cast<std::uint32_t>(readLE(&m_image.text[branch], 4));
+        std::int64_t distance = (static_cast<std::int64_t>(target) - static_cast<std::int64_t>(branch)) / 4;
+        if ((instruction & 0x7C000000) == 0x14000000) {
+            instruction |= static_cast<std::uint32_t>(distance) & 0x3FFFFFF; // B, BL
+        } else {
+            instruction |= (static_cast<std::uint32_t>(distance) & 0x7FFFF) << 5; // B.cond, CBZ, CBNZ
+        }
+        writeLE(&m_image.text[branch], instruction, 4);
+    }
+
+    std::vector<Loop> m_loops;
+};
+
+std::unique_ptr<Emitter> createEmitter(BrainfuckFastBackend::Arch arch, CodeImage& image, unsigned cellBytes) {
+    if (arch == BrainfuckFastBackend::Arch::AArch64) {
+        return std::make_unique<AArch64Emitter>(image, cellBytes);
+    }
+    return std::make_unique<X86Emitter>(image, cellBytes);
+}
+
+// Cell displacements and pointer steps must fit the 32-bit displacements of x86-64
+bool checkDisplacements(const BrainfuckProgram& program, std::string& error) {
+    std::int64_t cellBytes = program.cellBits() / 8;
+    auto fits = [&](std::int64_t cells) {
+        return llvm::isInt<32>(cells * cellBytes);
+    };
+    for (const BrainfuckOp& op : program.ops()) {
+        if (!fits(op.value) || !fits(op.offset) || !fits(op.srcOffset)) {
+            error = "Cell offset out of the fast backend's range at source position " + std::to_string(op.sourcePos);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Strings of Write operations in .rodata, returns their offsets
+std::vector<std::int64_t> addStrings(const BrainfuckProgram& program, CodeImage& image) {
+    std::vector<std::int64_t> offsets;
+    for (const std::string& text : program.strings()) {
+        offsets.push_back(static_cast<std::int64_t>(image.rodata.size()));
+        image.rodata.insert(image.rodata.end(), text.begin(), text.end());
+    }
+    return offsets;
+}
+
+// Resolve one reference, symbol and place are addresses in the final layout
+bool applyRelocation(std::uint8_t* place, const Relocation& relocation, std::uint64_t symbol, std::uint64_t address,
+                     std::string& error) {
+    std::uint64_t target = symbol + static_cast<std::uint64_t>(relocation.addend);
+    std::int64_t distance = static_cast<std::int64_t>(target - address);
+    switch (relocation.kind) {
+    case RelocationKind::X86PC32:
+    case RelocationKind::X86PLT32:
+        if (!llvm::isInt<32>(distance)) {
+            error = "Fast backend reference out of range";
+            return false;
+        }
+        writeLE(place, static_cast<std::uint64_t>(distance), 4);
+        return true;
+    case RelocationKind::AArch64Call26: {
+        if (!llvm::isInt<28>(distance)) {
+            error = "Fast backend call out of range";
+            return false;
+        }
+        std::uint32_t instruction = static_cast<std::uint32_t>(readLE(place, 4));
+        writeLE(place, instruction | (static_cast<std::uint32_t>(distance >> 2) & 0x3FFFFFF), 4);
+        return true;
+    }
+    case RelocationKind::AArch64AdrPage: {
+        std::int64_t pages = static_cast<std::int64_t>((target & ~std::uint64_t{0xFFF}) -
+                                                       (address & ~std::uint64_t{0xFFF})) >> 12;
+        if (!llvm::isInt<21>(pages)) {
+            error = "Fast backend reference out of range";
+            return false;
+        }
+        std::uint32_t immediate = static_cast<std::uint32_t>(pages) & 0x1FFFFF;
+        std::uint32_t instruction = static_cast<std::uint32_t>(readLE(place, 4));
+        writeLE(place, instruction | (immediate & 3) << 29 | (immediate >> 2) << 5, 4);
+        return true;
+    }
+    case RelocationKind::AArch64AddLo12: {
+        std::uint32_t instruction = static_cast<std::uint32_t>(readLE(place, 4));
+        writeLE(place, instruction | static_cast<std::uint32_t>(target & 0xFFF) << 10, 4);
+        return true;
+    }
+    }
+    return false;
+}
+
+// Relocatable ELF object of an executable's code image
+std::vector<char> writeElf(BrainfuckFastBackend::Arch arch, const CodeImage& image) {
+    bool aarch64 = arch == BrainfuckFastBackend::Arch::AArch64;
+
+    // Section indices, and the symbols: null, the three section symbols, main and the C library functions
+    enum : std::uint16_t { Text = 1, Rodata, Bss, RelaText, Symtab, Strtab, Shstrtab, NoteStack, SectionCount };
+    const char strtab[] = "\0main\0write\0read\0memcpy";
+    const char shstrtab[] = "\0.text\0.rodata\0.bss\0.rela.text\0.symtab\0.strtab\0.shstrtab\0.note.GNU-stack";
+    struct SymbolEntry {
+        std::uint32_t name;
+        std::uint8_t info;
+        std::uint16_t section;
+        std::uint64_t value;
+    };
+    const SymbolEntry symbols[] = {
+        {0, 0, 0, 0},
+        {0, 3, Text, 0}, // STT_SECTION, STB_LOCAL
+        {0, 3, Rodata, 0},
+        {0, 3, Bss, 0},
+        {1, 0x12, Text, image.definitions.at(MainFunction)}, // STT_FUNC, STB_GLOBAL
+        {6, 0x10, 0, 0}, // STT_NOTYPE, STB_GLOBAL, undefined
+        {12, 0x10, 0, 0},
+        {17, 0x10, 0, 0},
+    };
+    constexpr std::uint32_t firstGlobal = 4;
+
+    // Relocations against the section symbols with the definition in the addend, or against the library symbol
+    std::vector<std::uint8_t> rela;
+    for (const Relocation& relocation : image.relocations) {
+        std::uint64_t symbol = 0;
+        std::int64_t addend = relocation.addend;
+        switch (relocation.symbol) {
+        case TextSection:
+        case RodataSection:
+        case BssSection:
+            symbol = 1 + relocation.symbol;
+            break;
+        case SystemWrite:
+        case SystemRead:
+        case SystemMemcpy:
+            symbol = 5 + (relocation.symbol - SystemWrite);
+            break;
+        default:
+            symbol = 1;
+            addend += static_cast<std::int64_t>(image.definitions.at(relocation.symbol));
+            break;
+        }
+
+        std::uint32_t type = 0;
+        switch (relocation.kind) {
+        case RelocationKind::X86PC32:
+            type = 2; // R_X86_64_PC32
+            break;
+        case RelocationKind::X86PLT32:
+            type = 4; // R_X86_64_PLT32
+            break;
+        case RelocationKind::AArch64Call26:
+            type = 283; // R_AARCH64_CALL26
+            break;
+        case RelocationKind::AArch64AdrPage:
+            type = 275; // R_AARCH64_ADR_PREL_PG_HI21
+            break;
+        case RelocationKind::AArch64AddLo12:
+            type = 277; // R_AARCH64_ADD_ABS_LO12_NC
+            break;
+        }
+
+        std::uint8_t entry[24];
+        writeLE(entry, relocation.offset, 8);
+        writeLE(entry + 8, symbol << 32 | type, 8);
+        writeLE(entry + 16, static_cast<std::uint64_t>(addend), 8);
+        rela.insert(rela.end(), entry, entry + sizeof(entry));
+    }
+
+    std::vector<std::uint8_t> symtab;
+    for (const SymbolEntry& symbol : symbols) {
+        std::uint8_t entry[24] = {};
+        writeLE(entry, symbol.name, 4);
+        entry[4] = symbol.info;
+        writeLE(entry + 6, symbol.section, 2);
+        writeLE(entry + 8, symbol.value, 8);
+        symtab.insert(symtab.end(), entry, entry + sizeof(entry));
+    }
+
+    // Layout: header, section contents, section headers
+    std::vector<std::uint8_t> file(64);
+    auto append = [&](const std::uint8_t* data, std::size_t size, std::size_t alignment) {
+        file.resize(llvm::alignTo(file.size(), alignment));
+        std::size_t offset = file.size();
+        file.insert(file.end(), data, data + size);
+        return offset;
+    };
+    std::size_t textOffset = append(image.text.data(), image.text.size(), 16);
+    std::size_t rodataOffset = append(image.rodata.data(), image.rodata.size(), 16);
+    std::size_t relaOffset = append(rela.data(), rela.size(), 8);
+    std::size_t symtabOffset = append(symtab.data(), symtab.size(), 8);
+    std::size_t strtabOffset = append(reinterpret_cast<const std::uint8_t*>(strtab), sizeof(strtab), 1);
+    std::size_t shstrtabOffset = append(reinterpret_cast<const std::uint8_t*>(shstrtab), sizeof(shstrtab), 1);
+    std::size_t sectionHeaders = llvm::alignTo(file.size(), 8);
+    file.resize(sectionHeaders + SectionCount * 64);
+
+    auto section = [&](unsigned index, std::uint32_t name, std::uint32_t type, std::uint64_t flags,
+                       std::size_t offset, std::size_t size, std::uint32_t link, std::uint32_t info,
+                       std::uint64_t alignment, std::uint64_t entrySize) {
+        std::uint8_t* header = &file[sectionHeaders + index * 64];
+        writeLE(header, name, 4);
+        writeLE(header + 4, type, 4);
+        writeLE(header + 8, flags, 8);
+        writeLE(header + 24, offset, 8);
+        writeLE(header + 32, size, 8);
+        writeLE(header + 40, link, 4);
+        writeLE(header + 44, info, 4);
+        writeLE(header + 48, alignment, 8);
+        writeLE(header + 56, entrySize, 8);
+    };
+    section(Text, 1, 1, 0x6, textOffset, image.text.size(), 0, 0, 16, 0); // PROGBITS, ALLOC | EXECINSTR
+    section(Rodata, 7, 1, 0x2, rodataOffset, image.rodata.size(), 0, 0, 16, 0); // PROGBITS, ALLOC
+    section(Bss, 15, 8, 0x3, rodataOffset, image.bssSize, 0, 0, 64, 0); // NOBITS, WRITE | ALLOC
+    section(RelaText, 20, 4, 0x40, relaOffset, rela.size(), Symtab, Text, 8, 24); // RELA, INFO_LINK
+    section(Symtab, 31, 2, 0, symtabOffset, symtab.size(), Strtab, firstGlobal, 8, 24);
+    section(Strtab, 39, 3, 0, strtabOffset, sizeof(strtab), 0, 0, 1, 0);
+    section(Shstrtab, 47, 3, 0, shstrtabOffset, sizeof(shstrtab), 0, 0, 1, 0);
+    section(NoteStack, 57, 1, 0, shstrtabOffset, 0, 0, 0, 1, 0); // Non-executable stack
+
+    // ELF header: 64-bit little-endian relocatable file
+    const std::uint8_t ident[] = {0x7F, 'E', 'L', 'F', 2, 1, 1, 0};
+    std::copy(std::begin(ident), std::end(ident), file.begin());
+    std::uint8_t* header = file.data();
+    writeLE(header + 16, 1, 2); // ET_REL
+    writeLE(header + 18, aarch64 ? 183 : 62, 2); // EM_AARCH64, EM_X86_64
+    writeLE(header + 20, 1, 4); // EV_CURRENT
+    writeLE(header + 40, sectionHeaders, 8);
+    writeLE(header + 52, 64, 2); // Header size
+    writeLE(header + 58, 64, 2); // Section header size
+    writeLE(header + 60, SectionCount, 2);
+    writeLE(header + 62, Shstrtab, 2);
+
+    return std::vector<char>(file.begin(), file.end());
+}
+
+} // namespace
+
+std::optional<BrainfuckFastBackend::Arch> BrainfuckFastBackend::getArch(const llvm::Triple& triple) {
+    // Generated code follows the System V and AAPCS64 calling conventions, Windows uses neither for x86-64
+    if (triple.isOSWindows()) {
+        return std::nullopt;
+    }
+    switch (triple.getArch()) {
+    case llvm::Triple::x86_64:
+        return Arch::X86_64;
+    case llvm::Triple::aarch64:
+        return Arch::AArch64;
+    default:
+        return std::nullopt;
+    }
+}
+
+bool BrainfuckFastBackend::emitObject(const BrainfuckProgram& program, std::vector<char>& object,
+                                      std::string& error) const {
+    BrainfuckTimeReport::Scope phase(m_timeReport, "Code generation");
+    if (!checkDisplacements(program, error)) {
+        return false;
+    }
+
+    unsigned cellBytes = program.cellBits() / 8;
+    CodeImage image;
+    image.bssSize = tapeOffset + m_memorySize * cellBytes;
+    std::vector<std::int64_t> stringOffsets = addStrings(program, image);
+
+    // Tape state left by the precomputed program prefix, copied from .rodata when main starts
+    std::int64_t origin = static_cast<std::int64_t>(tapeOffset + m_memorySize / 2 * cellBytes);
+    EntryState entry;
+    entry.pointerOffset = origin + program.initialPointer() * cellBytes;
+    const std::vector<std::uint64_t>& initialTape = program.initialTape();
+    if (!initialTape.empty()) {
+        image.rodata.resize(llvm::alignTo(image.rodata.size(), cellBytes));
+        entry.imageRodataOffset = static_cast<std::int64_t>(image.rodata.size());
+        entry.imageOffset = origin + program.initialTapeOffset() * cellBytes;
+        entry.imageSize = initialTape.size() * cellBytes;
+        for (std::uint64_t cell : initialTape) {
+            std::uint8_t bytes[8];
+            writeLE(bytes, cell, cellBytes);
+            image.rodata.insert(image.rodata.end(), bytes, bytes + cellBytes);
+        }
+    }
+
+    std::unique_ptr<Emitter> emitter = createEmitter(m_arch, image, cellBytes);
+    emitter->emitEntry(&entry);
+    emitter->emitProgram(program, stringOffsets);
+    emitter->emitExit(true);
+    emitter->emitRuntime();
+
+    object = writeElf(m_arch, image);
+    return true;
+}
+
+std::optional<int> BrainfuckFastBackend::run(const BrainfuckProgram& program, std::uint32_t tapeFlags,
+                                             std::string& error) const {
+    unsigned cellBytes = program.cellBits() / 8;
+    llvm::sys::MemoryBlock block;
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "JIT code generation");
+        if (!checkDisplacements(program, error)) {
+            return std::nullopt;
+        }
+
+        CodeImage image;
+        std::vector<std::int64_t> stringOffsets = addStrings(program, image);
+        std::unique_ptr<Emitter> emitter = createEmitter(m_arch, image, cellBytes);
+        emitter->emitEntry(nullptr);
+        emitter->emitProgram(program, stringOffsets);
+        emitter->emitExit(false);
+
+        // Layout: code, strings, then a stub per host function, which may be out of reach of direct calls
+        const std::pair<Symbol, void*> hostFunctions[] = {
+            {OutputFunction, reinterpret_cast<void*>(&bf_output)},
+            {WriteFunction, reinterpret_cast<void*>(&bf_write)},
+            {InputFunction, reinterpret_cast<void*>(&bf_input)},
+        };
+        constexpr std::size_t stubSize = 16;
+        std::size_t rodataStart = llvm::alignTo(image.text.size(), 16);
+        std::size_t stubsStart = llvm::alignTo(rodataStart + image.rodata.size(), 16);
+        std::size_t size = stubsStart + std::size(hostFunctions) * stubSize;
+
+        std::error_code ec;
+        block = llvm::sys::Memory::allocateMappedMemory(size, nullptr,
+                                                        llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_WRITE, ec);
+        if (ec) {
+            error = "Cannot allocate memory for the generated code: " + ec.message();
+            return std::nullopt;
+        }
+
+        auto* base = static_cast<std::uint8_t*>(block.base());
+        std::copy(image.text.begin(), image.text.end(), base);
+        std::copy(image.rodata.begin(), image.rodata.end(), base + rodataStart);
+
+        std::map<Symbol, std::uint64_t> addresses = {
+            {TextSection, reinterpret_cast<std::uint64_t>(base)},
+            {RodataSection, reinterpret_cast<std::uint64_t>(base + rodataStart)},
+        };
+        for (std::size_t i{}; i < std::size(hostFunctions); ++i) {
+            std::uint8_t* stub = base + stubsStart + i * stubSize;
+            auto function = reinterpret_cast<std::uint64_t>(hostFunctions[i].second);
+            if (m_arch == Arch::AArch64) {
+                writeLE(stub, 0x58000050, 4); // ldr x16, #8
+                writeLE(stub + 4, 0xD61F0200, 4); // br x16
+            } else {
+                const std::uint8_t jump[] = {0xFF, 0x25, 0, 0, 0, 0, 0, 0}; // jmp [rip + 2]
+                std::copy(std::begin(jump), std::end(jump), stub);
+                stub[2] = 2;
+            }
+            writeLE(stub + 8, function, 8);
+            addresses[hostFunctions[i].first] = reinterpret_cast<std::uint64_t>(stub);
+        }
+
+        for (const Relocation& relocation : image.relocations) {
+            if (!applyRelocation(base + relocation.offset, relocation, addresses.at(relocation.symbol),
+                                 reinterpret_cast<std::uint64_t>(base + relocation.offset), error)) {
+                llvm::sys::Memory::releaseMappedMemory(block);
+                return std::nullopt;
+            }
+        }
+
+        ec = llvm::sys::Memory::protectMappedMemory(block, llvm::sys::Memory::MF_READ | llvm::sys::Memory::MF_EXEC);
+        if (ec) {
+            error = "Cannot make the generated code executable: " + ec.message();
+            llvm::sys::Memory::releaseMappedMemory(block);
+            return std::nullopt;
+        }
+        llvm::sys::Memory::InvalidateInstructionCache(block.base(), size);
+    }
+
+    int result = 1;
+    {
+        BrainfuckTimeReport::Scope phase(m_timeReport, "JIT execution");
+        std::size_t tapeSize = m_memorySize * cellBytes;
+        std::uint8_t* tape = bf_tape_alloc(tapeSize, 0, tapeFlags);
+        if (tape) {
+            // Data pointer starts in the middle of memory, after the tape state left by the precomputed prefix
+            std::uint8_t* origin = tape + m_memorySize / 2 * cellBytes;
+            std::uint8_t* cell = origin + program.initialTapeOffset() * cellBytes;
+            for (std::uint64_t value : program.initialTape()) {
+                writeLE(cell, value, cellBytes);
+                cell += cellBytes;
+            }
+
+            auto* entry = reinterpret_cast<int (*)(std::uint8_t*)>(block.base());
+            result = entry(origin + program.initialPointer() * cellBytes);
+            bf_flush();
+            bf_tape_free(tape, tapeSize, 0, tapeFlags);
+        }
+    }
+
+    llvm::sys::Memory::releaseMappedMemory(block);
+    return result;
+}
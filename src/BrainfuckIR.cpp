@@ -0,0 +1,624 @@
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "BrainfuckIR.h"
+
+namespace {
+
+/**
+ * Cell values known to foldConstantOutput, in a flat window over tape positions that grows on demand.
+ * Forgetting everything at a loop resets only the cells written since the previous reset.
+ */
+class KnownCells {
+public:
+    /**
+     * Value of a cell, std::nullopt if it is unknown. Cells not written since the last reset are
+     * zero while allZero holds, unknown afterwards.
+     */
+    std::optional<std::uint64_t> lookup(std::int64_t pos, bool allZero) const {
+        std::size_t index = static_cast<std::size_t>(pos - m_low);
+        if (pos < m_low || index >= m_states.size() || m_states[index] == State::Unwritten) {
+            return allZero ? std::optional<std::uint64_t>(0) : std::nullopt;
+        }
+        return m_states[index] == State::Known ? std::optional(m_values[index]) : std::nullopt;
+    }
+
+    void set(std::int64_t pos, std::optional<std::uint64_t> value) {
+        std::size_t index = reserve(pos);
+        if (m_states[index] == State::Unwritten) {
+            m_written.push_back(pos);
+        }
+        m_states[index] = value ? State::Known : State::Unknown;
+        m_values[index] = value.value_or(0);
+    }
+
+    void clear() {
+        for (std::int64_t pos : m_written) {
+            m_states[static_cast<std::size_t>(pos - m_low)] = State::Unwritten;
+        }
+        m_written.clear();
+    }
+
+private:
+    enum class State : std::uint8_t {
+        Unwritten,
+        Known,
+        Unknown,
+    };
+
+    // Index of a position, doubling the window until it covers the position
+    std::size_t reserve(std::int64_t pos) {
+        if (m_states.empty()) {
+            m_low = pos;
+        }
+        auto size = static_cast<std::int64_t>(m_states.size());
+        if (pos >= m_low && pos < m_low + size) {
+            return static_cast<std::size_t>(pos - m_low);
+        }
+
+        std::int64_t low = std::min(m_low, pos);
+        std::int64_t high = std::max(m_low + size, pos + 1);
+        std::int64_t grown = std::max<std::int64_t>({2 * size, high - low, 64});
+        low = pos < m_low ? high - grown : low;
+
+        std::vector<std::uint64_t> values(static_cast<std::size_t>(grown), 0);
+        std::vector<State> states(static_cast<std::size_t>(grown), State::Unwritten);
+        std::copy(m_values.begin(), m_values.end(), values.begin() + (m_low - low));
+        std::copy(m_states.begin(), m_states.end(), states.begin() + (m_low - low));
+        m_values = std::move(values);
+        m_states = std::move(states);
+        m_low = low;
+        return static_cast<std::size_t>(pos - m_low);
+    }
+
+    std::int64_t m_low = 0; // Tape position of the first window entry
+    std::vector<std::uint64_t> m_values; // Cell values, meaningful for Known cells
+    std::vector<State> m_states; // Cell states
+    std::vector<std::int64_t> m_written; // Positions written since the last reset
+};
+
+} // namespace
+
+std::optional<BrainfuckProgram> BrainfuckProgram::parse(std::string_view source, unsigned cellBits,
+                                                        std::string& error) {
+    BrainfuckProgram program(cellBits);
+    std::vector<std::size_t> loopStack;
+    std::size_t counts[256] = {};
+
+    const char* text = source.data();
+    std::size_t length = source.size();
+
+    // Folds a whole run of up/down characters into one operation, comments end the run
+    auto foldRun = [&](std::size_t& i, char up, char down, BrainfuckOpKind kind) {
+        std::size_t start = i;
+        std::size_t ups = 0;
+        for (; i < length && (text[i] == up || text[i] == down); ++i) {
+            ups += text[i] == up;
+        }
+        std::size_t downs = i - start - ups;
+        counts[static_cast<unsigned char>(up)] += ups;
+        counts[static_cast<unsigned char>(down)] += downs;
+        program.appendOp(kind, static_cast<std::int32_t>(ups) - static_cast<std::int32_t>(downs), start);
+    };
+
+    for (std::size_t i{}; i < length;) {
+        char c = text[i];
+
+        switch (c) {
+        case '+':
+        case '-':
+            foldRun(i, '+', '-', BrainfuckOpKind::Add);
+            continue;
+        case '>':
+        case '<':
+            foldRun(i, '>', '<', BrainfuckOpKind::Move);
+            continue;
+        case '.':
+            program.appendOp(BrainfuckOpKind::Output, 0, i);
+            break;
+        case ',':
+            program.appendOp(BrainfuckOpKind::Input, 0, i);
+            break;
+        case '[':
+            loopStack.push_back(program.m_ops.size());
+            program.appendOp(BrainfuckOpKind::LoopStart, 0, i);
+            break;
+        case ']': {
+            if (loopStack.empty()) {
+                error = "Syntax error: Extra right bracket ']' at position " + std::to_string(i);
+                return std::nullopt;
+            }
+            std::size_t start = loopStack.back();
+            loopStack.pop_back();
+            program.m_ops[start].match = program.m_ops.size();
+            program.appendOp(BrainfuckOpKind::LoopEnd, 0, i);
+            program.m_ops.back().match = start;
+            break;
+        }
+        default:
+            // Skip non-Brainfuck instruction characters
+            break;
+        }
+
+        // Count instruction usage
+        counts[static_cast<unsigned char>(c)]++;
+        ++i;
+    }
+
+    if (!loopStack.empty()) {
+        error = "Syntax error: Unmatched left bracket '[' at position " +
+                std::to_string(program.m_ops[loopStack.back()].sourcePos);
+        return std::nullopt;
+    }
+
+    for (std::size_t i{}; i < BrainfuckStatistics::instructions.size(); ++i) {
+        program.m_statistics.counts[i] = counts[static_cast<unsigned char>(BrainfuckStatistics::instructions[i])];
+    }
+    return program;
+}
+
+void BrainfuckProgram::appendOp(BrainfuckOpKind kind, std::int32_t value, std::size_t sourcePos) {
+    // Fold runs of '+'/'-' and '>'/'<' into the previous operation
+    bool foldable = kind == BrainfuckOpKind::Add || kind == BrainfuckOpKind::Move;
+    if (foldable && value == 0) {
+        return;
+    }
+    if (foldable && !m_ops.empty() && m_ops.back().kind == kind) {
+        m_ops.back().value += value;
+
+        // Drop operations that cancel out completely
+        if (m_ops.back().value == 0) {
+            m_ops.pop_back();
+        }
+        return;
+    }
+
+    m_ops.push_back(BrainfuckOp{kind, value, 0, 0, 0, sourcePos});
+}
+
+void BrainfuckProgram::recognizeLoopIdioms() {
+    // Net cell changes of the loop being lowered, reused for every loop
+    std::vector<std::pair<std::int32_t, std::int32_t>> deltas;
+    std::size_t out = 0;
+
+    for (std::size_t i{}; i < m_ops.size(); ++i) {
+        // The replacement may overwrite the loop's own slots
+        std::size_t end = m_ops[i].match;
+        if (m_ops[i].kind == BrainfuckOpKind::LoopStart && lowerLoopIdiom(i, out, deltas)) {
+            // Skip the whole loop, it has been replaced
+            i = end;
+            continue;
+        }
+        m_ops[out++] = m_ops[i];
+    }
+
+    m_ops.resize(out);
+    linkLoops();
+}
+
+bool BrainfuckProgram::lowerLoopIdiom(std::size_t start, std::size_t& out,
+                                      std::vector<std::pair<std::int32_t, std::int32_t>>& deltas) {
+    std::size_t end = m_ops[start].match;
+    std::size_t sourcePos = m_ops[start].sourcePos;
+
+    // A loop body of a single pointer move searches for the next zero cell
+    if (end == start + 2 && m_ops[start + 1].kind == BrainfuckOpKind::Move) {
+        std::int32_t stride = m_ops[start + 1].value;
+        BrainfuckOpKind kind = stride > 0 ? BrainfuckOpKind::ScanRight : BrainfuckOpKind::ScanLeft;
+        m_ops[out++] = BrainfuckOp{kind, stride > 0 ? stride : -stride, 0, 0, 0, sourcePos};
+        return true;
+    }
+
+    // Collect the net cell changes of the loop body, one entry per offset
+    deltas.clear();
+    std::int32_t offset = 0;
+    std::int32_t counterDelta = 0;
+
+    for (std::size_t i = start + 1; i < end; ++i) {
+        const BrainfuckOp& op = m_ops[i];
+        if (op.kind == BrainfuckOpKind::Add) {
+            std::int32_t cellOffset = offset + op.offset;
+            if (cellOffset == 0) {
+                counterDelta += op.value;
+                continue;
+            }
+            auto it = std::find_if(deltas.begin(), deltas.end(), [&](const auto& entry) {
+                return entry.first == cellOffset;
+            });
+            if (it != deltas.end()) {
+                it->second += op.value;
+            } else {
+                deltas.emplace_back(cellOffset, op.value);
+            }
+        } else if (op.kind == BrainfuckOpKind::Move) {
+            offset += op.value;
+        } else {
+            // I/O or nested loop, not an idiom
+            return false;
+        }
+    }
+
+    // The loop must come back to the counter cell
+    if (offset != 0) {
+        return false;
+    }
+
+    // The counter cell must step by exactly one, so the trip count is its value (or its negation)
+    std::int64_t step = signedCell(static_cast<std::uint64_t>(counterDelta));
+    if (step != 1 && step != -1) {
+        return false;
+    }
+
+    // The body has an Add for every entry, so the replacement fits in the loop's own slots
+    std::sort(deltas.begin(), deltas.end());
+    for (const auto& [cellOffset, delta] : deltas) {
+        if (delta == 0) {
+            continue;
+        }
+
+        // Counting up runs (2^cellBits - cell) iterations, which is the same as negating the factor
+        std::int32_t factor = step == -1 ? delta : -delta;
+        m_ops[out++] = BrainfuckOp{BrainfuckOpKind::MulAdd, factor, cellOffset, 0, 0, sourcePos};
+    }
+    m_ops[out++] = BrainfuckOp{BrainfuckOpKind::SetZero, 0, 0, 0, 0, sourcePos};
+
+    return true;
+}
+
+void BrainfuckProgram::foldPointerOffsets() {
+    // A pending movement stands for at least one dropped Move, so the rewrite stays in place
+    std::size_t out = 0;
+
+    // Net pointer movement not yet applied, and where it started
+    std::int32_t pending = 0;
+    std::size_t pendingPos = 0;
+
+    for (std::size_t i{}; i < m_ops.size(); ++i) {
+        BrainfuckOp op = m_ops[i];
+        switch (op.kind) {
+        case BrainfuckOpKind::Move:
+            if (pending == 0) {
+                pendingPos = op.sourcePos;
+            }
+            pending += op.value;
+            continue;
+        case BrainfuckOpKind::LoopStart:
+        case BrainfuckOpKind::LoopEnd:
+        case BrainfuckOpKind::ScanRight:
+        case BrainfuckOpKind::ScanLeft:
+            // Loop conditions test the cell under the real pointer, so apply the movement first
+            if (pending != 0) {
+                m_ops[out++] = BrainfuckOp{BrainfuckOpKind::Move, pending, 0, 0, 0, pendingPos};
+                pending = 0;
+            }
+            break;
+        case BrainfuckOpKind::MulAdd:
+            op.srcOffset += pending;
+            op.offset += pending;
+            break;
+        default:
+            op.offset += pending;
+            break;
+        }
+        m_ops[out++] = op;
+    }
+
+    // Movement after the last loop has no observable effect and is dropped
+
+    m_ops.resize(out);
+    linkLoops();
+}
+
+void BrainfuckProgram::foldConstantOutput() {
+    // A Write replaces at least one dropped Output, so the rewrite stays in place
+    std::size_t out = 0;
+
+    // Known cell values by tape position relative to the start, moves only shift the data pointer
+    KnownCells known;
+    std::int64_t ptr = 0;
+    bool allZero = m_initialTape.empty(); // No loop reached yet, untouched cells are still zero
+
+    auto lookup = [&](std::int32_t offset) {
+        return known.lookup(ptr + offset, allZero);
+    };
+
+    // Output collected but not yet written
+    std::string pending;
+    std::size_t pendingPos = 0;
+
+    auto flushPending = [&]() {
+        if (pending.empty()) {
+            return;
+        }
+        std::int32_t index = static_cast<std::int32_t>(m_strings.size());
+        m_strings.push_back(std::move(pending));
+        m_ops[out++] = BrainfuckOp{BrainfuckOpKind::Write, index, 0, 0, 0, pendingPos};
+        pending.clear();
+    };
+
+    for (std::size_t i{}; i < m_ops.size(); ++i) {
+        BrainfuckOp op = m_ops[i];
+
+        switch (op.kind) {
+        case BrainfuckOpKind::Add: {
+            std::optional<std::uint64_t> value = lookup(op.offset);
+            known.set(ptr + op.offset, value ? std::optional(wrapCell(*value + op.value)) : std::nullopt);
+            break;
+        }
+        case BrainfuckOpKind::SetZero:
+            known.set(ptr + op.offset, 0);
+            break;
+        case BrainfuckOpKind::MulAdd: {
+            std::optional<std::uint64_t> counter = lookup(op.srcOffset);
+            std::optional<std::uint64_t> value = lookup(op.offset);
+            known.set(ptr + op.offset,
+                      counter && value ? std::optional(wrapCell(*value + *counter * op.value)) : std::nullopt);
+            break;
+        }
+        case BrainfuckOpKind::Move:
+            ptr += op.value;
+            break;
+        case BrainfuckOpKind::Output: {
+            // Output writes the low byte of the cell
+            std::optional<std::uint64_t> value = lookup(op.offset);
+            if (value) {
+                if (pending.empty()) {
+                    pendingPos = op.sourcePos;
+                }
+                pending.push_back(static_cast<char>(*value));
+                continue;
+            }
+            flushPending();
+            break;
+        }
+        case BrainfuckOpKind::Input:
+            flushPending();
+            known.set(ptr + op.offset, std::nullopt);
+            break;
+        case BrainfuckOpKind::LoopStart:
+            // Loop bodies can be entered from the back edge, nothing is known
+            flushPending();
+            known.clear();
+            allZero = false;
+            break;
+        case BrainfuckOpKind::LoopEnd:
+        case BrainfuckOpKind::ScanRight:
+        case BrainfuckOpKind::ScanLeft:
+            // Loops and scans stop at a zero cell
+            flushPending();
+            known.clear();
+            allZero = false;
+            known.set(ptr, 0);
+            break;
+        case BrainfuckOpKind::Write:
+            flushPending();
+            break;
+        }
+        m_ops[out++] = op;
+    }
+    flushPending();
+
+    m_ops.resize(out);
+    linkLoops();
+}
+
+bool BrainfuckProgram::usesTape() const {
+    return std::any_of(m_ops.begin(), m_ops.end(), [](const BrainfuckOp& op) {
+        return op.kind != BrainfuckOpKind::Write;
+    });
+}
+
+std::size_t BrainfuckProgram::maxAccessStride() const {
+    // Pointer movement between consecutive accesses, both of which may be offset from the pointer
+    std::int64_t maxMove = 0;
+    std::int64_t maxOffset = 0;
+    std::int64_t move = 0;
+    for (const BrainfuckOp& op : m_ops) {
+        switch (op.kind) {
+        case BrainfuckOpKind::Move:
+            move += op.value;
+            maxMove = std::max(maxMove, std::abs(move));
+            break;
+        case BrainfuckOpKind::Write:
+            break;
+        case BrainfuckOpKind::ScanRight:
+        case BrainfuckOpKind::ScanLeft:
+            // Scans access every stride-th cell
+            maxMove = std::max({maxMove, std::abs(move), static_cast<std::int64_t>(op.value)});
+            move = 0;
+            break;
+        default:
+            // Every other operation accesses the tape, loop jumps land on accessing operations
+            move = 0;
+            maxOffset = std::max({maxOffset, std::abs(static_cast<std::int64_t>(op.offset)),
+                                  std::abs(static_cast<std::int64_t>(op.srcOffset))});
+            break;
+        }
+    }
+    return static_cast<std::size_t>(maxMove + 2 * maxOffset);
+}
+
+bool BrainfuckProgram::precomputePrefix(std::size_t memorySize, std::size_t stepBudget) {
+    // Cells evaluated at compile time, centered on the data pointer start position
+    constexpr std::size_t maxWindowSize = std::size_t{1} << 20;
+    std::size_t windowSize = std::min(memorySize, maxWindowSize);
+    std::int64_t start = static_cast<std::int64_t>(windowSize / 2);
+
+    std::vector<std::uint64_t> tape(windowSize, 0);
+    std::int64_t ptr = start;
+    std::string output;
+    std::int64_t touchedLow = start;
+    std::int64_t touchedHigh = start;
+
+    // Writes inside a top-level loop are journaled so the loop can be rolled back
+    std::vector<std::pair<std::int64_t, std::uint64_t>> undoLog;
+    std::vector<bool> journaled(windowSize, false);
+
+    // State at the last top-level operation
+    std::size_t savedIp = 0;
+    std::int64_t savedPtr = ptr;
+    std::size_t savedOutputSize = 0;
+
+    auto inWindow = [&](std::int64_t pos) {
+        return pos >= 0 && pos < static_cast<std::int64_t>(windowSize);
+    };
+
+    std::size_t depth = 0;
+    std::size_t steps = 0;
+    std::size_t ip = 0;
+    bool stopped = false;
+
+    auto store = [&](std::int64_t pos, std::uint64_t value) {
+        if (depth > 0 && !journaled[pos]) {
+            journaled[pos] = true;
+            undoLog.emplace_back(pos, tape[pos]);
+        }
+        tape[pos] = value;
+        touchedLow = std::min(touchedLow, pos);
+        touchedHigh = std::max(touchedHigh, pos + 1);
+    };
+
+    for (; ip < m_ops.size(); ++ip) {
+        const BrainfuckOp& op = m_ops[ip];
+
+        // Top-level operations are safe points, everything before them is final
+        if (depth == 0) {
+            for (const auto& entry : undoLog) {
+                journaled[entry.first] = false;
+            }
+            undoLog.clear();
+            savedIp = ip;
+            savedPtr = ptr;
+            savedOutputSize = output.size();
+        }
+
+        if (++steps > stepBudget || op.kind == BrainfuckOpKind::Input) {
+            stopped = true;
+            break;
+        }
+
+        std::int64_t cell = ptr + op.offset;
+        if (op.kind != BrainfuckOpKind::Move && op.kind != BrainfuckOpKind::Write &&
+            (!inWindow(cell) || !inWindow(ptr + op.srcOffset))) {
+            stopped = true;
+            break;
+        }
+
+        switch (op.kind) {
+        case BrainfuckOpKind::Add:
+            store(cell, wrapCell(tape[cell] + op.value));
+            break;
+        case BrainfuckOpKind::Move:
+            ptr += op.value;
+            break;
+        case BrainfuckOpKind::Output:
+            output.push_back(static_cast<char>(tape[cell]));
+            break;
+        case BrainfuckOpKind::Input:
+            break;
+        case BrainfuckOpKind::LoopStart:
+            if (tape[ptr] == 0) {
+                ip = op.match;
+            } else {
+                ++depth;
+            }
+            break;
+        case BrainfuckOpKind::LoopEnd:
+            if (tape[ptr] != 0) {
+                ip = op.match;
+            } else {
+                --depth;
+            }
+            break;
+        case BrainfuckOpKind::SetZero:
+            store(cell, 0);
+            break;
+        case BrainfuckOpKind::MulAdd:
+            store(cell, wrapCell(tape[cell] + tape[ptr + op.srcOffset] * op.value));
+            break;
+        case BrainfuckOpKind::Write:
+            output += m_strings[op.value];
+            break;
+        case BrainfuckOpKind::ScanRight:
+        case BrainfuckOpKind::ScanLeft: {
+            // The pointer only moves once the zero cell is found, so a stopped scan restarts from scratch
+            std::int64_t stride = op.kind == BrainfuckOpKind::ScanRight ? op.value : -op.value;
+            std::int64_t pos = ptr;
+            while (!stopped && tape[pos] != 0) {
+                pos += stride;
+                stopped = ++steps > stepBudget || !inWindow(pos);
+            }
+            if (!stopped) {
+                ptr = pos;
+            }
+            break;
+        }
+        }
+
+        if (stopped) {
+            break;
+        }
+    }
+
+    // Roll back a loop that could not be finished
+    std::size_t resumeIp = ip;
+    if (stopped && depth > 0) {
+        for (auto it = undoLog.rbegin(); it != undoLog.rend(); ++it) {
+            tape[it->first] = it->second;
+        }
+        resumeIp = savedIp;
+        ptr = savedPtr;
+        output.resize(savedOutputSize);
+    }
+
+    if (resumeIp == 0) {
+        return false;
+    }
+
+    // Remaining program: constant output of the prefix in the last evaluated slot, then the ops not evaluated
+    std::size_t first = resumeIp;
+    if (!output.empty()) {
+        std::int32_t index = static_cast<std::int32_t>(m_strings.size());
+        m_strings.push_back(std::move(output));
+        m_ops[--first] = BrainfuckOp{BrainfuckOpKind::Write, index, 0, 0, 0, 0};
+    }
+    m_ops.erase(m_ops.begin(), m_ops.begin() + first);
+    linkLoops();
+
+    // Keep the tape state if the rest of the program still needs it
+    if (usesTape()) {
+        m_initialTape.assign(tape.begin() + touchedLow, tape.begin() + touchedHigh);
+        m_initialTapeOffset = touchedLow - start;
+        m_initialPointer = ptr - start;
+    }
+
+    return true;
+}
+
+std::uint64_t BrainfuckProgram::wrapCell(std::uint64_t value) const {
+    return m_cellBits < 64 ? value & ((std::uint64_t{1} << m_cellBits) - 1) : value;
+}
+
+std::int64_t BrainfuckProgram::signedCell(std::uint64_t value) const {
+    // Sign-extend the low cellBits bits
+    unsigned shift = 64 - m_cellBits;
+    return static_cast<std::int64_t>(value << shift) >> shift;
+}
+
+void BrainfuckProgram::linkLoops() {
+    std::vector<std::size_t> loopStack;
+
+    for (std::size_t i{}; i < m_ops.size(); ++i) {
+        if (m_ops[i].kind == BrainfuckOpKind::LoopStart) {
+            loopStack.push_back(i);
+        } else if (m_ops[i].kind == BrainfuckOpKind::LoopEnd) {
+            std::size_t start = loopStack.back();
+            loopStack.pop_back();
+            m_ops[start].match = i;
+            m_ops[i].match = start;
+        }
+    }
+}
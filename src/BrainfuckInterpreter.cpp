@@ -0,0 +1,213 @@
+#include "BrainfuckInterpreter.h"
+#include "BrainfuckCompiler.h"
+#include "BrainfuckRuntime.h"
+#include <algorithm>
+#include <cstring>
+
+BrainfuckInterpreter::BrainfuckInterpreter(const BrainfuckProgram& program, std::size_t memorySize,
+                                           BrainfuckCompiler* compiler, std::size_t tierThreshold,
+                                           const TapeOptions& tape)
+    : m_program(program),
+      m_memorySize(memorySize),
+      m_tape(tape),
+      m_memory(bf_tape_alloc(memorySize * program.cellBits() / 8, tape.guardSize, tape.flags)),
+      m_compiler(tierThreshold > 0 ? compiler : nullptr),
+      m_tierThreshold(tierThreshold),
+      m_loopCounts(program.ops().size(), 0),
+      m_compiledLoops(new std::atomic<LoopFunction>[program.ops().size()]) {
+    for (std::size_t i{}; i < program.ops().size(); ++i) {
+        m_compiledLoops[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    if (m_compiler) {
+        m_compilerThread = std::thread(&BrainfuckInterpreter::compilerThreadMain, this);
+    }
+}
+
+BrainfuckInterpreter::~BrainfuckInterpreter() {
+    stopCompilerThread();
+    bf_tape_free(m_memory, m_memorySize * m_program.cellBits() / 8, m_tape.guardSize, m_tape.flags);
+}
+
+int BrainfuckInterpreter::run() {
+    if (!m_memory) {
+        return 1;
+    }
+
+    // Loops compiled with bounds checks run on this tape
+    bf_bounds_tape = m_memory;
+
+    switch (m_program.cellBits()) {
+    case 16:
+        return runCells<std::uint16_t>();
+    case 32:
+        return runCells<std::uint32_t>();
+    case 64:
+        return runCells<std::uint64_t>();
+    default:
+        return runCells<std::uint8_t>();
+    }
+}
+
+template <typename Cell>
+int BrainfuckInterpreter::runCells() {
+    const std::vector<BrainfuckOp>& ops = m_program.ops();
+
+    // Data pointer starts in the middle of memory, like the compiled code
+    Cell* origin = reinterpret_cast<Cell*>(m_memory) + m_memorySize / 2;
+    Cell* ptr = origin + m_program.initialPointer();
+
+    // Tape state left by the precomputed program prefix
+    const std::vector<std::uint64_t>& initialTape = m_program.initialTape();
+    std::copy(initialTape.begin(), initialTape.end(), origin + m_program.initialTapeOffset());
+
+    for (std::size_t ip{}; ip < ops.size(); ++ip) {
+        const BrainfuckOp& op = ops[ip];
+
+        switch (op.kind) {
+        case BrainfuckOpKind::Add:
+            cell(ptr, op.offset, op.sourcePos) += static_cast<Cell>(op.value);
+            break;
+        case BrainfuckOpKind::Move:
+            ptr += op.value;
+            break;
+        case BrainfuckOpKind::Output:
+            bf_output(static_cast<std::uint8_t>(cell(ptr, op.offset, op.sourcePos)));
+            break;
+        case BrainfuckOpKind::Input:
+            cell(ptr, op.offset, op.sourcePos) = bf_input();
+            break;
+        case BrainfuckOpKind::LoopStart:
+            // Guard faults report the last loop boundary
+            bf_source_pos = op.sourcePos;
+            if (LoopFunction native = m_compiledLoops[ip].load(std::memory_order_acquire)) {
+                // Run the whole loop in native code
+                ptr = reinterpret_cast<Cell*>(native(reinterpret_cast<std::uint8_t*>(ptr)));
+                ip = op.match;
+            } else if (cell(ptr, 0, op.sourcePos) == 0) {
+                ip = op.match;
+            }
+            break;
+        case BrainfuckOpKind::LoopEnd:
+            if (cell(ptr, 0, op.sourcePos) == 0) {
+                bf_source_pos = op.sourcePos;
+                break;
+            }
+
+            if (LoopFunction native = m_compiledLoops[op.match].load(std::memory_order_acquire)) {
+                // On-stack replacement at the loop header, native code finishes the remaining iterations
+                ptr = reinterpret_cast<Cell*>(native(reinterpret_cast<std::uint8_t*>(ptr)));
+                break;
+            }
+
+            if (m_compiler && ++m_loopCounts[op.match] == m_tierThreshold) {
+                requestCompilation(op.match);
+            }
+            ip = op.match;
+            break;
+        case BrainfuckOpKind::SetZero:
+            cell(ptr, op.offset, op.sourcePos) = 0;
+            break;
+        case BrainfuckOpKind::MulAdd:
+            // Products of wide cells are computed in 64 bits, int promotion could overflow
+            cell(ptr, op.offset, op.sourcePos) += static_cast<Cell>(
+                std::uint64_t{cell(ptr, op.srcOffset, op.sourcePos)} * static_cast<std::uint64_t>(op.value));
+            break;
+        case BrainfuckOpKind::Write: {
+            const std::string& text = m_program.strings()[op.value];
+            bf_write(reinterpret_cast<const std::uint8_t*>(text.data()), text.size());
+            break;
+        }
+        case BrainfuckOpKind::ScanRight:
+            bf_source_pos = op.sourcePos;
+            ptr = scanRight(ptr, op.value, op.sourcePos);
+            break;
+        case BrainfuckOpKind::ScanLeft:
+            bf_source_pos = op.sourcePos;
+            while (cell(ptr, 0, op.sourcePos) != 0) {
+                ptr -= op.value;
+            }
+            break;
+        }
+    }
+
+    bf_flush();
+    return 0;
+}
+
+template <typename Cell>
+Cell& BrainfuckInterpreter::cell(Cell* ptr, std::int32_t offset, std::size_t sourcePos) const {
+    // Address arithmetic in integers, the pointer may already be outside the tape
+    std::uintptr_t address =
+        reinterpret_cast<std::uintptr_t>(ptr) + static_cast<std::intptr_t>(offset) * sizeof(Cell);
+    std::intptr_t index = static_cast<std::intptr_t>(address - reinterpret_cast<std::uintptr_t>(m_memory)) /
+                          static_cast<std::intptr_t>(sizeof(Cell));
+    if (m_tape.checkBounds && static_cast<std::uintptr_t>(index) >= m_memorySize) {
+        bf_bounds_error(static_cast<std::int64_t>(index), sourcePos);
+    }
+    return *reinterpret_cast<Cell*>(address);
+}
+
+template <typename Cell>
+Cell* BrainfuckInterpreter::scanRight(Cell* ptr, std::int32_t stride, std::size_t sourcePos) const {
+    // Byte tapes search the rest of the tape with memchr, anything past its end is left to the checks below
+    if constexpr (sizeof(Cell) == 1) {
+        std::uintptr_t index = reinterpret_cast<std::uintptr_t>(ptr) - reinterpret_cast<std::uintptr_t>(m_memory);
+        if (stride == 1 && index < m_memorySize) {
+            Cell* end = m_memory + m_memorySize;
+            void* zero = std::memchr(ptr, 0, m_memorySize - index);
+            return zero ? static_cast<Cell*>(zero) : scanRight(end, stride, sourcePos);
+        }
+    }
+
+    while (cell(ptr, 0, sourcePos) != 0) {
+        ptr += stride;
+    }
+    return ptr;
+}
+
+void BrainfuckInterpreter::requestCompilation(std::size_t loopStart) {
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_compileQueue.push_back(loopStart);
+    }
+    m_queueCondition.notify_one();
+}
+
+void BrainfuckInterpreter::compilerThreadMain() {
+    for (;;) {
+        std::size_t loopStart;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this] {
+                return m_stopCompiler || !m_compileQueue.empty();
+            });
+
+            if (m_stopCompiler) {
+                return;
+            }
+
+            loopStart = m_compileQueue.front();
+            m_compileQueue.pop_front();
+        }
+
+        // The compiler is only used by this thread while the interpreter runs
+        if (LoopFunction native = m_compiler->compileLoop(m_program, loopStart)) {
+            m_compiledLoops[loopStart].store(native, std::memory_order_release);
+            m_compiledLoopCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void BrainfuckInterpreter::stopCompilerThread() {
+    if (!m_compilerThread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopCompiler = true;
+    }
+    m_queueCondition.notify_one();
+    m_compilerThread.join();
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <cstring>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/xxhash.h>
+
+#include "BrainfuckIR.h"
+#include "BrainfuckProfile.h"
+
+std::uint64_t BrainfuckProfile::hashSource(std::string_view source) {
+    return llvm::xxHash64(llvm::StringRef(source.data(), source.size()));
+}
+
+std::vector<std::uint64_t> BrainfuckProfile::createCounters(const BrainfuckProgram& program,
+                                                            std::uint64_t sourceHash) {
+    std::vector<std::uint64_t> words = {magic, version, sourceHash, 0};
+
+    // Operations count towards the innermost loop around them
+    std::vector<std::size_t> openLoops; // Word index of each open loop's record
+    for (const BrainfuckOp& op : program.ops()) {
+        if (op.kind == BrainfuckOpKind::LoopStart) {
+            openLoops.push_back(words.size());
+            words.insert(words.end(), {op.sourcePos, 0, 0, 0});
+        } else if (op.kind == BrainfuckOpKind::LoopEnd) {
+            openLoops.pop_back();
+        } else if (!openLoops.empty()) {
+            ++words[openLoops.back() + 1];
+        }
+    }
+
+    words[3] = (words.size() - headerWords) / loopWords;
+    return words;
+}
+
+std::optional<BrainfuckProfile> BrainfuckProfile::read(std::string_view path, std::string& error) {
+    std::string filename(path);
+    auto buffer = llvm::MemoryBuffer::getFile(filename, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        error = "Cannot open profile " + filename + ": " + buffer.getError().message();
+        return std::nullopt;
+    }
+
+    // Words are copied out, the mapping need not be aligned
+    llvm::StringRef data = (*buffer)->getBuffer();
+    std::size_t wordCount = data.size() / sizeof(std::uint64_t);
+    std::vector<std::uint64_t> words(wordCount);
+    std::memcpy(words.data(), data.data(), wordCount * sizeof(std::uint64_t));
+
+    if (data.size() % sizeof(std::uint64_t) != 0 || wordCount < headerWords || words[0] != magic) {
+        error = "Not a Brainfuck profile: " + filename;
+        return std::nullopt;
+    }
+    if (words[1] != version) {
+        error = "Unsupported profile version " + std::to_string(words[1]) + ": " + filename;
+        return std::nullopt;
+    }
+    if (words[3] != (wordCount - headerWords) / loopWords || (wordCount - headerWords) % loopWords != 0) {
+        error = "Truncated profile: " + filename;
+        return std::nullopt;
+    }
+
+    BrainfuckProfile profile;
+    profile.m_sourceHash = words[2];
+    for (std::size_t word = headerWords; word < wordCount; word += loopWords) {
+        profile.m_loops.push_back(Loop{words[word], words[word + 1], words[word + 2], words[word + 3]});
+    }
+    std::sort(profile.m_loops.begin(), profile.m_loops.end(), [](const Loop& a, const Loop& b) {
+        return a.sourcePos < b.sourcePos;
+    });
+    return profile;
+}
+
+const BrainfuckProfile::Loop* BrainfuckProfile::findLoop(std::size_t sourcePos) const {
+    auto loop = std::lower_bound(m_loops.begin(), m_loops.end(), sourcePos, [](const Loop& a, std::size_t pos) {
+        return a.sourcePos < pos;
+    });
+    return loop != m_loops.end() && loop->sourcePos == sourcePos ? &*loop : nullptr;
+}
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <io.h>
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+#include "BrainfuckRuntime.h"
+
+namespace {
+
+std::uint8_t outputBuffer[BF_RUNTIME_BUFFER_SIZE];
+std::size_t outputLength = 0;
+
+std::uint8_t inputBuffer[BF_RUNTIME_BUFFER_SIZE];
+std::size_t inputPos = 0;
+std::size_t inputEnd = 0;
+
+long writeBytes(const std::uint8_t* data, std::size_t size) {
+#ifdef _WIN32
+    return _write(1, data, static_cast<unsigned int>(size));
+#else
+    return static_cast<long>(::write(1, data, size));
+#endif
+}
+
+long readBytes(std::uint8_t* data, std::size_t size) {
+#ifdef _WIN32
+    return _read(0, data, static_cast<unsigned int>(size));
+#else
+    return static_cast<long>(::read(0, data, size));
+#endif
+}
+
+std::size_t roundToChunk(std::size_t size) {
+    return (size + BF_TAPE_CHUNK_SIZE - 1) & ~(BF_TAPE_CHUNK_SIZE - 1);
+}
+
+void writeError(const char* message, std::size_t length) {
+#ifdef _WIN32
+    _write(2, message, static_cast<unsigned int>(length));
+#else
+    static_cast<void>(::write(2, message, length));
+#endif
+}
+
+void reportTapeError() {
+    static const char message[] = "Cannot allocate tape memory\n";
+    writeError(message, sizeof(message) - 1);
+}
+
+// Formats a decimal number at the end of a buffer, returns the first digit, async-signal-safe
+char* formatNumber(char* end, std::int64_t value) {
+    std::uint64_t magnitude = value < 0 ? 0 - static_cast<std::uint64_t>(value) : static_cast<std::uint64_t>(value);
+    char* digits = end;
+    do {
+        *--digits = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        *--digits = '-';
+    }
+    return digits;
+}
+
+void writeNumber(std::int64_t value) {
+    char buffer[24];
+    char* digits = formatNumber(buffer + sizeof(buffer), value);
+    writeError(digits, static_cast<std::size_t>(buffer + sizeof(buffer) - digits));
+}
+
+#ifndef _WIN32
+// Mapped tape currently served by the fault handler
+std::uint8_t* faultTape = nullptr;
+std::size_t faultTapeSize = 0;
+bool faultTapeGrowable = false; // Tape chunks are committed on first access
+std::size_t faultGuardSize = 0; // Inaccessible region on both sides of the tape
+unsigned faultCellShift = 0; // log2 of the cell size, faults report cell indices
+
+struct sigaction previousSegvAction;
+struct sigaction previousBusAction;
+bool faultHandlerInstalled = false;
+
+void handleTapeFault(int signal, siginfo_t* info, void*) {
+    auto* address = static_cast<std::uint8_t*>(info->si_addr);
+    if (faultTape) {
+        std::int64_t offset = address - faultTape;
+        std::int64_t size = static_cast<std::int64_t>(faultTapeSize);
+        std::int64_t guard = static_cast<std::int64_t>(faultGuardSize);
+
+        // First access of a growable tape chunk
+        if (faultTapeGrowable && offset >= 0 && offset < size) {
+            std::size_t chunk = static_cast<std::size_t>(offset) & ~(BF_TAPE_CHUNK_SIZE - 1);
+            if (mprotect(faultTape + chunk, BF_TAPE_CHUNK_SIZE, PROT_READ | PROT_WRITE) == 0) {
+                return;
+            }
+        } else if (offset >= -guard && offset < size + guard) {
+            bf_bounds_error(offset >> faultCellShift, bf_source_pos);
+        }
+    }
+
+    // Not a tape access, the faulting instruction reruns under the previous handler
+    sigaction(signal, signal == SIGSEGV ? &previousSegvAction : &previousBusAction, nullptr);
+}
+
+void installFaultHandler() {
+    if (faultHandlerInstalled) {
+        return;
+    }
+
+    struct sigaction action = {};
+    action.sa_sigaction = handleTapeFault;
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+
+    // macOS reports accesses to inaccessible pages as SIGBUS
+    sigaction(SIGSEGV, &action, &previousSegvAction);
+    sigaction(SIGBUS, &action, &previousBusAction);
+    faultHandlerInstalled = true;
+}
+#endif
+
+} // namespace
+
+extern "C" {
+
+void bf_flush() {
+    std::size_t written = 0;
+    while (written < outputLength) {
+        long result = writeBytes(outputBuffer + written, outputLength - written);
+        if (result <= 0) {
+            break;
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    outputLength = 0;
+}
+
+void bf_output(std::uint8_t value) {
+    if (outputLength == BF_RUNTIME_BUFFER_SIZE) {
+        bf_flush();
+    }
+    outputBuffer[outputLength++] = value;
+}
+
+void bf_write(const std::uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        if (outputLength == BF_RUNTIME_BUFFER_SIZE) {
+            bf_flush();
+        }
+        std::size_t chunk = std::min(size, BF_RUNTIME_BUFFER_SIZE - outputLength);
+        std::memcpy(outputBuffer + outputLength, data, chunk);
+        outputLength += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+std::uint8_t bf_input() {
+    if (inputPos == inputEnd) {
+        // Prompts written so far must be visible before blocking on input
+        bf_flush();
+
+        long result = readBytes(inputBuffer, BF_RUNTIME_BUFFER_SIZE);
+        if (result <= 0) {
+            return 255;
+        }
+        inputPos = 0;
+        inputEnd = static_cast<std::size_t>(result);
+    }
+    return inputBuffer[inputPos++];
+}
+
+void bf_io_flush(bf_io* io) {
+    if (io->outputLength > 0) {
+        io->sink(io->sinkContext, io->output, io->outputLength);
+        io->outputLength = 0;
+    }
+}
+
+void bf_io_output(bf_io* io, std::uint8_t value) {
+    if (io->outputLength == io->outputCapacity) {
+        bf_io_flush(io);
+    }
+    io->output[io->outputLength++] = value;
+}
+
+void bf_io_write(bf_io* io, const std::uint8_t* data, std::size_t size) {
+    // Large constant strings go to the sink directly, keeping the output in order
+    if (size >= io->outputCapacity) {
+        bf_io_flush(io);
+        io->sink(io->sinkContext, data, size);
+        return;
+    }
+
+    if (size > io->outputCapacity - io->outputLength) {
+        bf_io_flush(io);
+    }
+    std::memcpy(io->output + io->outputLength, data, size);
+    io->outputLength += size;
+}
+
+std::uint8_t bf_io_input(bf_io* io) {
+    if (io->inputPos == io->inputSize) {
+        return 255;
+    }
+    return io->input[io->inputPos++];
+}
+
+void bf_io_bounds_error(bf_io* io, std::int64_t cell, std::size_t sourcePos) {
+    // Keep the output produced so far, the generated code returns right after the call
+    bf_io_flush(io);
+    io->boundsError = true;
+    io->errorCell = cell;
+    io->errorSourcePos = sourcePos;
+}
+
+std::size_t bf_source_pos = 0;
+std::uint8_t* bf_bounds_tape = nullptr;
+
+void bf_bounds_error(std::int64_t cell, std::size_t sourcePos) {
+    // Keep the output produced so far, then report the access
+    bf_flush();
+
+    static const char prefix[] = "Error: tape access out of bounds at cell ";
+    static const char middle[] = " (source position ";
+    static const char suffix[] = ")\n";
+    writeError(prefix, sizeof(prefix) - 1);
+    writeNumber(cell);
+    writeError(middle, sizeof(middle) - 1);
+    writeNumber(static_cast<std::int64_t>(sourcePos));
+    writeError(suffix, sizeof(suffix) - 1);
+    std::_Exit(1);
+}
+
+void bf_profile_write(const char* path, const std::uint64_t* counters, std::size_t size) {
+    std::FILE* file = std::fopen(path, "wb");
+    bool written = file && std::fwrite(counters, 1, size, file) == size;
+    if (file && std::fclose(file) != 0) {
+        written = false;
+    }
+    if (!written) {
+        static const char message[] = "Error: Cannot write profile ";
+        writeError(message, sizeof(message) - 1);
+        writeError(path, std::strlen(path));
+        writeError("\n", 1);
+    }
+}
+
+std::uint8_t* bf_tape_alloc(std::size_t size, std::size_t guardSize, std::uint32_t flags) {
+    bool growable = (flags & BF_TAPE_GROWABLE) != 0;
+    std::size_t guard = roundToChunk(guardSize);
+    std::size_t tapeSize = roundToChunk(size);
+    std::size_t mapSize = tapeSize + 2 * guard;
+
+#ifdef _WIN32
+    // Reserved pages fault, committed pages are zero-filled on first access, growable tapes are committed up front
+    static_cast<void>(growable);
+    auto* region = static_cast<std::uint8_t*>(VirtualAlloc(nullptr, mapSize, MEM_RESERVE, PAGE_NOACCESS));
+    if (!region || !VirtualAlloc(region + guard, tapeSize, MEM_COMMIT, PAGE_READWRITE)) {
+        if (region) {
+            VirtualFree(region, 0, MEM_RELEASE);
+        }
+        reportTapeError();
+        return nullptr;
+    }
+    return region + guard;
+#else
+    #ifdef MAP_NORESERVE
+    int mapFlags = MAP_PRIVATE | MAP_ANON | MAP_NORESERVE;
+    #else
+    int mapFlags = MAP_PRIVATE | MAP_ANON;
+    #endif
+
+    // Plain tapes are mapped accessible, otherwise only the committed part is
+    bool protect = growable || guard > 0;
+    void* region = mmap(nullptr, mapSize, protect ? PROT_NONE : PROT_READ | PROT_WRITE, mapFlags, -1, 0);
+    if (region == MAP_FAILED) {
+        reportTapeError();
+        return nullptr;
+    }
+
+    std::uint8_t* tape = static_cast<std::uint8_t*>(region) + guard;
+    if (protect && !growable && mprotect(tape, tapeSize, PROT_READ | PROT_WRITE) != 0) {
+        munmap(region, mapSize);
+        reportTapeError();
+        return nullptr;
+    }
+
+    if (protect) {
+        faultTape = tape;
+        faultTapeSize = tapeSize;
+        faultTapeGrowable = growable;
+        faultGuardSize = guard;
+        faultCellShift = (flags >> BF_TAPE_CELL_SHIFT) & 0xff;
+        installFaultHandler();
+    }
+    return tape;
+#endif
+}
+
+void bf_tape_free(std::uint8_t* tape, std::size_t size, std::size_t guardSize, std::uint32_t flags) {
+    if (!tape) {
+        return;
+    }
+
+    std::size_t guard = roundToChunk(guardSize);
+#ifdef _WIN32
+    static_cast<void>(size);
+    static_cast<void>(flags);
+    VirtualFree(tape - guard, 0, MEM_RELEASE);
+#else
+    static_cast<void>(flags);
+    if (tape == faultTape) {
+        faultTape = nullptr;
+        faultTapeSize = 0;
+        faultTapeGrowable = false;
+        faultGuardSize = 0;
+        faultCellShift = 0;
+    }
+    munmap(tape - guard, roundToChunk(size) + 2 * guard);
+#endif
+}
+
+} // extern "C"
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <chrono>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#include <llvm/ADT/Any.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/PassInstrumentation.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "BrainfuckTimeReport.h"
+
+namespace {
+
+// Peak resident memory of the process in bytes, 0 if unknown
+std::uint64_t peakResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    #ifdef __APPLE__
+    return static_cast<std::uint64_t>(usage.ru_maxrss);
+    #else
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+}
+
+double currentSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Pass managers, adaptors and proxies only run other passes
+bool isContainerPass(llvm::StringRef name) {
+    return name.contains("PassManager") || name.contains("PassAdaptor") || name.contains("AnalysisManagerProxy") ||
+           name.contains("ModuleInlinerWrapperPass") || name.contains("DevirtSCCRepeatedPass") ||
+           name == "PassInstrumentationAnalysis";
+}
+
+double milliseconds(double seconds) {
+    return seconds * 1000.0;
+}
+
+} // namespace
+
+BrainfuckTimeReport::Scope::Scope(BrainfuckTimeReport* report, std::string_view name)
+    : m_report(report), m_name(name) {
+    if (m_report) {
+        // TimeRecord tracks memory only with -track-memory, the heap is sampled here instead
+        m_startHeap = llvm::sys::Process::GetMallocUsage();
+        m_start = llvm::TimeRecord::getCurrentTime(true);
+    }
+}
+
+BrainfuckTimeReport::Scope::~Scope() {
+    if (m_report) {
+        llvm::TimeRecord time = llvm::TimeRecord::getCurrentTime(false);
+        time -= m_start;
+        std::int64_t heapDelta =
+            static_cast<std::int64_t>(llvm::sys::Process::GetMallocUsage()) - static_cast<std::int64_t>(m_startHeap);
+        m_report->addPhase(m_name, time, heapDelta, peakResidentMemory());
+    }
+}
+
+BrainfuckTimeReport::PassTimer::PassTimer(BrainfuckTimeReport* report, llvm::PassInstrumentationCallbacks& callbacks)
+    : m_report(report) {
+    if (!m_report) {
+        return;
+    }
+
+    callbacks.registerBeforeNonSkippedPassCallback([this](llvm::StringRef name, llvm::Any) {
+        start(name);
+    });
+    callbacks.registerAfterPassCallback([this](llvm::StringRef name, llvm::Any, const llvm::PreservedAnalyses&) {
+        stop(name);
+    });
+    callbacks.registerAfterPassInvalidatedCallback([this](llvm::StringRef name, const llvm::PreservedAnalyses&) {
+        stop(name);
+    });
+    callbacks.registerBeforeAnalysisCallback([this](llvm::StringRef name, llvm::Any) {
+        start(name);
+    });
+    callbacks.registerAfterAnalysisCallback([this](llvm::StringRef name, llvm::Any) {
+        stop(name);
+    });
+}
+
+void BrainfuckTimeReport::PassTimer::start(llvm::StringRef name) {
+    if (isContainerPass(name)) {
+        return;
+    }
+
+    // The enclosing pass pauses while this one runs
+    double now = currentSeconds();
+    if (!m_running.empty()) {
+        m_running.back().elapsed += now - m_running.back().start;
+    }
+    m_running.push_back(RunningPass{name, now, 0});
+}
+
+void BrainfuckTimeReport::PassTimer::stop(llvm::StringRef name) {
+    if (isContainerPass(name) || m_running.empty()) {
+        return;
+    }
+
+    double now = currentSeconds();
+    RunningPass pass = m_running.back();
+    m_running.pop_back();
+    m_report->addPass(pass.name, pass.elapsed + (now - pass.start));
+
+    // Resume the enclosing pass
+    if (!m_running.empty()) {
+        m_running.back().start = now;
+    }
+}
+
+void BrainfuckTimeReport::addIRCounts(bool optimized, const llvm::Module& module) {
+    IRCounts counts;
+    counts.modules = 1;
+    for (const llvm::Function& function : module) {
+        if (function.isDeclaration()) {
+            continue;
+        }
+        ++counts.functions;
+        counts.blocks += function.size();
+        counts.instructions += function.getInstructionCount();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    IRCounts& total = optimized ? m_optimized : m_unoptimized;
+    total.modules += counts.modules;
+    total.functions += counts.functions;
+    total.blocks += counts.blocks;
+    total.instructions += counts.instructions;
+}
+
+void BrainfuckTimeReport::addPhase(std::string_view name, const llvm::TimeRecord& time, std::int64_t heapDelta,
+                                   std::uint64_t peakMemory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto phase = std::find_if(m_phases.begin(), m_phases.end(), [&](const Phase& existing) {
+        return existing.name == name;
+    });
+    if (phase == m_phases.end()) {
+        phase = m_phases.insert(m_phases.end(), Phase{std::string(name)});
+    }
+
+    ++phase->runs;
+    phase->wallTime += time.getWallTime();
+    phase->userTime += time.getUserTime();
+    phase->systemTime += time.getSystemTime();
+    phase->heapDelta += heapDelta;
+    phase->peakMemory = std::max(phase->peakMemory, peakMemory);
+}
+
+void BrainfuckTimeReport::addPass(llvm::StringRef name, double wallTime) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto pass = std::find_if(m_passes.begin(), m_passes.end(), [&](const Pass& existing) {
+        return existing.name == name;
+    });
+    if (pass == m_passes.end()) {
+        pass = m_passes.insert(m_passes.end(), Pass{name.str()});
+    }
+
+    ++pass->runs;
+    pass->wallTime += wallTime;
+}
+
+void BrainfuckTimeReport::print(llvm::raw_ostream& os, Format format) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (format == Format::JSON) {
+        printJSON(os);
+    } else {
+        printText(os);
+    }
+}
+
+void BrainfuckTimeReport::printText(llvm::raw_ostream& os) const {
+    os << "\n=== Time Report ===\n";
+    os << "Phase                                Runs     Wall ms     User ms   System ms      Heap KB  Peak RSS KB\n";
+    for (const Phase& phase : m_phases) {
+        os << llvm::format("%-34s %6zu %11.3f %11.3f %11.3f %12lld %12llu\n", phase.name.c_str(), phase.runs,
+                           milliseconds(phase.wallTime), milliseconds(phase.userTime),
+                           milliseconds(phase.systemTime), static_cast<long long>(phase.heapDelta / 1024),
+                           static_cast<unsigned long long>(phase.peakMemory / 1024));
+    }
+
+    os << "\nIR size                             Modules  Functions     Blocks  Instructions\n";
+    auto printCounts = [&](const char* stage, const IRCounts& counts) {
+        if (counts.modules == 0) {
+            os << llvm::format("%-34s        -\n", stage);
+            return;
+        }
+        os << llvm::format("%-34s %8zu %10zu %10zu %13zu\n", stage, counts.modules, counts.functions, counts.blocks,
+                           counts.instructions);
+    };
+    printCounts("Before optimization", m_unoptimized);
+    printCounts("After optimization", m_optimized);
+
+    if (m_passes.empty()) {
+        return;
+    }
+
+    // Most expensive passes first
+    std::vector<Pass> passes = m_passes;
+    std::stable_sort(passes.begin(), passes.end(), [](const Pass& a, const Pass& b) {
+        return a.wallTime > b.wallTime;
+    });
+    double total = 0;
+    for (const Pass& pass : passes) {
+        total += pass.wallTime;
+    }
+
+    os << "\nOptimization passes and analyses (wall time excluding nested passes):\n";
+    os << "    Wall ms       %    Runs  Pass\n";
+    for (const Pass& pass : passes) {
+        os << llvm::format("%11.3f %6.1f%% %7zu  %s\n", milliseconds(pass.wallTime),
+                           total > 0 ? 100.0 * pass.wallTime / total : 0.0, pass.runs, pass.name.c_str());
+    }
+    os << llvm::format("%11.3f %6.1f%%          Total\n", milliseconds(total), 100.0);
+}
+
+void BrainfuckTimeReport::printJSON(llvm::raw_ostream& os) const {
+    llvm::json::OStream json(os, 2);
+    auto countsObject = [&](const IRCounts& counts) {
+        return [&json, &counts] {
+            json.attribute("modules", static_cast<std::int64_t>(counts.modules));
+            json.attribute("functions", static_cast<std::int64_t>(counts.functions));
+            json.attribute("blocks", static_cast<std::int64_t>(counts.blocks));
+            json.attribute("instructions", static_cast<std::int64_t>(counts.instructions));
+        };
+    };
+
+    json.object([&] {
+        json.attributeArray("phases", [&] {
+            for (const Phase& phase : m_phases) {
+                json.object([&] {
+                    json.attribute("name", phase.name);
+                    json.attribute("runs", static_cast<std::int64_t>(phase.runs));
+                    json.attribute("wall_ms", milliseconds(phase.wallTime));
+                    json.attribute("user_ms", milliseconds(phase.userTime));
+                    json.attribute("system_ms", milliseconds(phase.systemTime));
+                    json.attribute("heap_delta_bytes", phase.heapDelta);
+                    json.attribute("peak_memory_bytes", static_cast<std::int64_t>(phase.peakMemory));
+                });
+            }
+        });
+        json.attributeObject("ir", [&] {
+            json.attributeObject("before_optimization", countsObject(m_unoptimized));
+            json.attributeObject("after_optimization", countsObject(m_optimized));
+        });
+        json.attributeArray("passes", [&] {
+            for (const Pass& pass : m_passes) {
+                json.object([&] {
+                    json.attribute("name", pass.name);
+                    json.attribute("runs", static_cast<std::int64_t>(pass.runs));
+                    json.attribute("wall_ms", milliseconds(pass.wallTime));
+                });
+            }
+        });
+    });
+    os << "\n";
+}
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include "BrainfuckProfile.h"
+
+/**
+ * @brief Display usage help
+ */
+void showUsage(const char* programName) {
+    llvm::outs() << "Brainfuck profile report\n"
+                    "Usage: "
+                 << programName
+                 << " [options] <profile> [source]\n\n"
+                    "Lists the loops of a profile written by a program compiled with bfc --profile, hottest\n"
+                    "first. With the source, loops are shown by line and column and can be annotated.\n\n"
+                    "Options:\n"
+                    "  --top <n>      Number of loops listed, 0 lists all (default: 20)\n"
+                    "  --annotate     Print the source with the iterations of the loops starting on each line\n"
+                    "  -h, --help     Show help information\n";
+}
+
+/**
+ * @brief Command line options
+ */
+struct CommandLineOptions {
+    std::string profileFile;
+    std::string sourceFile; // Empty reports source positions only
+    std::size_t top = 20; // 0 lists all loops
+    bool annotate = false;
+    bool showHelp = false;
+};
+
+CommandLineOptions parseCommandLine(int argc, char* argv[]) {
+    CommandLineOptions options;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--top") {
+            if (i + 1 < argc) {
+                options.top = std::stoul(argv[++i]);
+            } else {
+                llvm::errs() << "Missing loop count parameter\n";
+                std::exit(1);
+            }
+        } else if (arg == "--annotate") {
+            options.annotate = true;
+        } else if (arg == "-h" || arg == "--help") {
+            options.showHelp = true;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            llvm::errs() << "Unknown option: " << arg << "\n";
+            std::exit(1);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.size() > 2) {
+        llvm::errs() << "Too many files, expected a profile and optionally its source\n";
+        std::exit(1);
+    }
+    if (!files.empty()) {
+        options.profileFile = files[0];
+    }
+    if (files.size() == 2) {
+        options.sourceFile = files[1];
+    }
+
+    return options;
+}
+
+/**
+ * @brief Line and column of source positions, both counted from 1
+ */
+class SourceLines {
+public:
+    explicit SourceLines(std::string_view source) : m_source(source) {
+        m_lineStarts.push_back(0);
+        for (std::size_t pos{}; pos < source.size(); ++pos) {
+            if (source[pos] == '\n' && pos + 1 < source.size()) {
+                m_lineStarts.push_back(pos + 1);
+            }
+        }
+    }
+
+    // Index of the line containing a position, counted from 0
+    std::size_t lineIndex(std::size_t pos) const {
+        return static_cast<std::size_t>(std::upper_bound(m_lineStarts.begin(), m_lineStarts.end(), pos) -
+                                        m_lineStarts.begin()) -
+               1;
+    }
+
+    std::string location(std::size_t pos) const {
+        std::size_t line = lineIndex(pos);
+        return std::to_string(line + 1) + ":" + std::to_string(pos - m_lineStarts[line] + 1);
+    }
+
+    // Instructions of the loop at a position up to its closing bracket, shortened to maxLength characters
+    std::string snippet(std::size_t pos, std::size_t maxLength) const {
+        std::string text;
+        int depth = 0;
+        for (std::size_t i = pos; i < m_source.size(); ++i) {
+            char c = m_source[i];
+            if (c == '\0' || !std::strchr("+-<>.,[]", c)) {
+                continue;
+            }
+            if (text.size() == maxLength) {
+                text.replace(maxLength - 3, 3, "...");
+                break;
+            }
+            text += c;
+            depth += c == '[' ? 1 : (c == ']' ? -1 : 0);
+            if (depth == 0) {
+                break;
+            }
+        }
+        return text;
+    }
+
+    std::size_t lineCount() const {
+        return m_lineStarts.size();
+    }
+
+    std::string_view line(std::size_t index) const {
+        std::size_t start = m_lineStarts[index];
+        std::size_t end = index + 1 < m_lineStarts.size() ? m_lineStarts[index + 1] - 1 : m_source.size();
+        if (end > start && m_source[end - 1] == '\n') {
+            --end;
+        }
+        return m_source.substr(start, end - start);
+    }
+
+private:
+    std::string_view m_source;
+    std::vector<std::size_t> m_lineStarts; // Position of the first character of each line
+};
+
+/**
+ * @brief List the hottest loops
+ */
+void printLoops(const BrainfuckProfile& profile, const SourceLines* lines, std::size_t top) {
+    std::vector<BrainfuckProfile::Loop> loops = profile.loops();
+    std::stable_sort(loops.begin(), loops.end(), [](const auto& a, const auto& b) {
+        return a.executedOps() > b.executedOps() || (a.executedOps() == b.executedOps() && a.iterations > b.iterations);
+    });
+
+    std::uint64_t totalOps = 0;
+    std::uint64_t totalIterations = 0;
+    std::size_t executedLoops = 0;
+    for (const BrainfuckProfile::Loop& loop : loops) {
+        totalOps += loop.executedOps();
+        totalIterations += loop.iterations;
+        executedLoops += loop.entries > 0;
+    }
+
+    llvm::outs() << "Loops: " << loops.size() << ", executed: " << executedLoops
+                 << ", iterations: " << totalIterations << ", operations in loop bodies: " << totalOps << "\n\n";
+    llvm::outs() << "Rank  Location           Entries     Iterations  Iter/entry        Operations       %  Loop\n";
+
+    std::size_t count = top == 0 ? loops.size() : std::min(top, loops.size());
+    for (std::size_t rank{}; rank < count; ++rank) {
+        const BrainfuckProfile::Loop& loop = loops[rank];
+        std::string location = lines ? lines->location(loop.sourcePos) : "@" + std::to_string(loop.sourcePos);
+        double perEntry = loop.entries > 0 ? static_cast<double>(loop.iterations) / loop.entries : 0.0;
+        double share = totalOps > 0 ? 100.0 * loop.executedOps() / totalOps : 0.0;
+        llvm::outs() << llvm::format("%4zu  %-14s %12llu %14llu %11.1f %17llu %6.1f%%", rank + 1, location.c_str(),
+                                     static_cast<unsigned long long>(loop.entries),
+                                     static_cast<unsigned long long>(loop.iterations), perEntry,
+                                     static_cast<unsigned long long>(loop.executedOps()), share);
+        if (lines) {
+            llvm::outs() << "  " << lines->snippet(loop.sourcePos, 32);
+        }
+        llvm::outs() << "\n";
+    }
+    if (count < loops.size()) {
+        llvm::outs() << "... " << loops.size() - count << " more loops, --top 0 lists all\n";
+    }
+}
+
+/**
+ * @brief Print the source with the iterations of the loops starting on each line
+ */
+void printAnnotatedSource(const BrainfuckProfile& profile, const SourceLines& lines) {
+    std::vector<std::uint64_t> lineIterations(lines.lineCount(), 0);
+    std::vector<bool> hasLoop(lines.lineCount(), false);
+    for (const BrainfuckProfile::Loop& loop : profile.loops()) {
+        std::size_t line = lines.lineIndex(loop.sourcePos);
+        lineIterations[line] += loop.iterations;
+        hasLoop[line] = true;
+    }
+
+    llvm::outs() << "\n  Iterations | Source\n";
+    for (std::size_t line{}; line < lines.lineCount(); ++line) {
+        if (hasLoop[line]) {
+            llvm::outs() << llvm::format("%12llu", static_cast<unsigned long long>(lineIterations[line]));
+        } else {
+            llvm::outs().indent(12);
+        }
+        llvm::outs() << " | " << lines.line(line) << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CommandLineOptions options = parseCommandLine(argc, argv);
+    if (options.showHelp) {
+        showUsage(argv[0]);
+        return 0;
+    }
+    if (options.profileFile.empty()) {
+        llvm::errs() << "Error: Profile file must be specified\n";
+        llvm::errs() << "Use '" << argv[0] << " --help' for usage\n";
+        return 1;
+    }
+
+    std::string error;
+    std::optional<BrainfuckProfile> profile = BrainfuckProfile::read(options.profileFile, error);
+    if (!profile) {
+        llvm::errs() << "Error: " << error << "\n";
+        return 1;
+    }
+
+    // Positions are only meaningful in the source that was profiled
+    std::unique_ptr<llvm::MemoryBuffer> sourceBuffer;
+    std::unique_ptr<SourceLines> lines;
+    if (!options.sourceFile.empty()) {
+        auto buffer = llvm::MemoryBuffer::getFileOrSTDIN(options.sourceFile, /*IsText=*/false,
+                                                         /*RequiresNullTerminator=*/false);
+        if (!buffer) {
+            llvm::errs() << "Error: Cannot open file: " << options.sourceFile << ": " << buffer.getError().message()
+                         << "\n";
+            return 1;
+        }
+        sourceBuffer = std::move(*buffer);
+        std::string_view source(sourceBuffer->getBufferStart(), sourceBuffer->getBufferSize());
+        if (BrainfuckProfile::hashSource(source) != profile->sourceHash()) {
+            llvm::errs() << "Warning: " << options.sourceFile << " is not the source of the profiled program\n";
+        }
+        lines = std::make_unique<SourceLines>(source);
+    } else if (options.annotate) {
+        llvm::errs() << "Error: --annotate requires the source file\n";
+        return 1;
+    }
+
+    llvm::outs() << "Profile: " << options.profileFile << "\n";
+    printLoops(*profile, lines.get(), options.top);
+    if (options.annotate) {
+        printAnnotatedSource(*profile, *lines);
+    }
+
+    return 0;
+}
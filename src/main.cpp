@@ -1,13 +1,31 @@
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <iostream>
-#include <sstream>
-#include <fstream>
 #include <string>
+#include <string_view>
 #include <cstring>
 #include <memory>
+#include <optional>
+#include <chrono>
+#include <vector>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include "BrainfuckBatchRunner.h"
 #include "BrainfuckCompiler.h"
 
+/**
+ * @brief Default compile-time step budget for the input-free program prefix when optimizing
+ */
+constexpr std::size_t defaultPrefixSteps = 10000000;
+
+/**
+ * @brief Default profile file of --profile, in the directory the program runs in
+ */
+constexpr const char* defaultProfileFile = "default.bfprof";
+
 /**
  * @brief Display usage help
  */
@@ -23,13 +41,37 @@ void showUsage(const char* programName) {
               << programName
               << " [options]\n\n"
                  "Options:\n"
-                 "  -i, --input <file>     Input Brainfuck source file\n"
+                 "  -i, --input <file>     Input Brainfuck source file, - reads stdin. Repeated, the programs are\n"
+                 "                         bundled into one executable run by program name, busybox style\n"
                  "  -o, --output <file>    Output executable filename\n"
-                 "  -m, --memory <size>    Memory size (default: 30000)\n"
-                 "  -O, --optimize         Enable optimization\n"
+                 "  --shared               Build a shared object exporting bf_main_<name>() for each input\n"
+                 "  -m, --memory <size>    Memory size in cells (default: 30000)\n"
+                 "  --cell-bits <bits>     Cell width: 8, 16, 32 or 64 (default: 8)\n"
+                 "  -O, --optimize         Enable optimization (same as -O2)\n"
+                 "  -O0/-O1/-O2/-O3/-Os    Select optimization level (default: -O0)\n"
+                 "  --target <triple>      Target triple of the executable, such as aarch64-linux-gnu (default: host)\n"
+                 "  --mcpu <cpu>           Target CPU, 'native' selects the host CPU (default: generic)\n"
+                 "  --mattr <features>     Target features such as +avx2, 'native' selects the host features\n"
+                 "  --tape <storage>       Tape storage: stack, static, mmap or grow (default: static)\n"
+                 "  --bounds <mode>        Tape bounds protection: none, guard or check (default: none)\n"
+                 "  --backend <name>       Code generator of executables and JIT mode: llvm or fast (default: llvm)\n"
+                 "  --prefix-steps <n>     Operations of the input-free prefix run at compile time, 0 disables\n"
+                 "                         (default: 10000000 when optimizing, 0 at -O0)\n"
+                 "  --freestanding         Build a static executable without the C library, using raw system calls\n"
+                 "  --cache-dir <dir>      Reuse executables and JIT objects compiled before from this directory\n"
+                 "  --compile-threads <n>  Optimize and generate code of executables on n threads (default: 1)\n"
                  "  -g, --debug            Generate debug info\n"
                  "  -j, --jit              JIT mode direct execution\n"
+                 "  -t, --tiered           Tiered execution: interpret, compile hot loops in the background\n"
+                 "  --tier-threshold <n>   Loop iterations before tier-up, 0 only interprets (default: 1000)\n"
+                 "  --batch <dir>          Compile once and run the program on every file in <dir> as input\n"
+                 "  --batch-output <dir>   Write the output of each batch input to <dir> under the input's name\n"
+                 "  --jobs <n>             Batch worker threads (default: one per hardware thread)\n"
+                 "  --profile[=<file>]     Count loop iterations and write them to <file> when the program ends\n"
+                 "                         (default: default.bfprof), see bfprof for reports\n"
+                 "  --profile-use <file>   Optimize with the loop profile <file> written by a --profile run\n"
                  "  -s, --stats            Show compilation statistics\n"
+                 "  --time-report[=<fmt>]  Report phase/pass times, memory and IR sizes on stderr: text or json\n"
                  "  -h, --help             Show help information\n\n"
                  "Examples:\n"
                  "  "
@@ -39,38 +81,119 @@ void showUsage(const char* programName) {
               << programName
               << " -i mandelbrot.bf -o mandelbrot -O -m 60000\n"
                  "  "
-              << programName << " -i test.bf -j -s\n";
+              << programName
+              << " -i test.bf -j -s\n"
+                 "  "
+              << programName
+              << " -i cat.bf -i rot13.bf -i wc.bf -O2 -o bftools\n"
+                 "  "
+              << programName << " -i filter.bf -O2 --batch inputs/ --batch-output outputs/ --jobs 16\n";
 }
 
 /**
  * @brief Read file content
+ *
+ * Large regular files are memory-mapped instead of copied, "-" and pipes are read from stdin.
  */
-std::string readFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::fputs(("Cannot open file: " + filename + "\n").c_str(), stderr);
+std::unique_ptr<llvm::MemoryBuffer> readFile(const std::string& filename) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFileOrSTDIN(filename, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        std::fputs(("Cannot open file: " + filename + ": " + buffer.getError().message() + "\n").c_str(), stderr);
         std::exit(1);
     }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return std::move(*buffer);
 }
 
 /**
  * @brief Parse command line arguments
  */
 struct CommandLineOptions {
-    std::string inputFile;
+    std::vector<std::string> inputFiles; // More than one builds a bundle
     std::string outputFile = "a.out";
     std::size_t memorySize = 30000;
-    bool enableOptimization = false;
+    unsigned cellBits = 8;
+    BrainfuckCompiler::OptLevel optLevel = BrainfuckCompiler::OptLevel::O0;
+    std::string targetTriple; // Empty selects the host
+    std::string targetCPU = "generic";
+    std::string targetFeatures;
+    BrainfuckCompiler::TapeStorage tapeStorage = BrainfuckCompiler::TapeStorage::Static;
+    BrainfuckCompiler::BoundsMode boundsMode = BrainfuckCompiler::BoundsMode::None;
+    BrainfuckCompiler::Backend backend = BrainfuckCompiler::Backend::LLVM;
+    std::optional<std::size_t> prefixSteps; // Defaults to the optimization level setting
+    std::string cacheDirectory; // Empty disables the compile cache
+    unsigned compileThreads = 1;
+    bool freestanding = false;
+    bool sharedLibrary = false; // Build a shared object with an entry point per input
     bool enableDebugInfo = false;
     bool enableJIT = false;
+    bool enableTiered = false;
+    std::size_t tierThreshold = 1000;
+    std::string batchDirectory; // Empty unless running a batch
+    std::string batchOutputDirectory; // Empty discards batch output
+    unsigned jobs = 0; // Batch worker threads, 0 for one per hardware thread
+    std::string profileFile; // Empty disables profiling
+    std::string profileUseFile; // Empty compiles without a profile
     bool showStats = false;
+    std::optional<BrainfuckTimeReport::Format> timeReport; // Set when the time report is requested
     bool showHelp = false;
 };
 
+/**
+ * @brief Get the command line spelling of an optimization level
+ */
+const char* optLevelName(BrainfuckCompiler::OptLevel level) {
+    switch (level) {
+    case BrainfuckCompiler::OptLevel::O0:
+        return "-O0";
+    case BrainfuckCompiler::OptLevel::O1:
+        return "-O1";
+    case BrainfuckCompiler::OptLevel::O2:
+        return "-O2";
+    case BrainfuckCompiler::OptLevel::O3:
+        return "-O3";
+    case BrainfuckCompiler::OptLevel::Os:
+        return "-Os";
+    }
+    return "-O0";
+}
+
+/**
+ * @brief Tape storage names, in TapeStorage order
+ */
+const char* const tapeStorageNames[] = {"stack", "static", "mmap", "grow"};
+
+/**
+ * @brief Get the command line spelling of a tape storage
+ */
+const char* tapeStorageName(BrainfuckCompiler::TapeStorage storage) {
+    return tapeStorageNames[static_cast<std::size_t>(storage)];
+}
+
+/**
+ * @brief Bounds mode names, in BoundsMode order
+ */
+const char* const boundsModeNames[] = {"none", "guard", "check"};
+
+/**
+ * @brief Get the command line spelling of a bounds mode
+ */
+const char* boundsModeName(BrainfuckCompiler::BoundsMode mode) {
+    return boundsModeNames[static_cast<std::size_t>(mode)];
+}
+
+/**
+ * @brief Backend names, in Backend order
+ */
+const char* const backendNames[] = {"llvm", "fast"};
+
+/**
+ * @brief Get the command line spelling of a backend
+ */
+const char* backendName(BrainfuckCompiler::Backend backend) {
+    return backendNames[static_cast<std::size_t>(backend)];
+}
+
 CommandLineOptions parseCommandLine(int argc, char* argv[]) {
     CommandLineOptions options;
 
@@ -79,7 +202,7 @@ CommandLineOptions parseCommandLine(int argc, char* argv[]) {
 
         if (arg == "-i" || arg == "--input") {
             if (i + 1 < argc) {
-                options.inputFile = argv[++i];
+                options.inputFiles.push_back(argv[++i]);
             } else {
                 std::fputs("Missing input filename parameter\n", stderr);
                 std::exit(1);
@@ -98,14 +221,179 @@ CommandLineOptions parseCommandLine(int argc, char* argv[]) {
                 std::fputs("Missing memory size parameter\n", stderr);
                 std::exit(1);
             }
-        } else if (arg == "-O" || arg == "--optimize") {
-            options.enableOptimization = true;
+        } else if (arg == "--cell-bits") {
+            if (i + 1 >= argc) {
+                std::fputs("Missing cell width parameter\n", stderr);
+                std::exit(1);
+            }
+            std::string bits = argv[++i];
+            if (bits != "8" && bits != "16" && bits != "32" && bits != "64") {
+                std::cout << "Unsupported cell width: " + bits << std::endl;
+                std::exit(1);
+            }
+            options.cellBits = static_cast<unsigned>(std::stoul(bits));
+        } else if (arg == "-O" || arg == "--optimize" || arg == "-O2") {
+            options.optLevel = BrainfuckCompiler::OptLevel::O2;
+        } else if (arg == "-O0") {
+            options.optLevel = BrainfuckCompiler::OptLevel::O0;
+        } else if (arg == "-O1") {
+            options.optLevel = BrainfuckCompiler::OptLevel::O1;
+        } else if (arg == "-O3") {
+            options.optLevel = BrainfuckCompiler::OptLevel::O3;
+        } else if (arg == "-Os") {
+            options.optLevel = BrainfuckCompiler::OptLevel::Os;
+        } else if (arg == "--target") {
+            if (i + 1 < argc) {
+                options.targetTriple = argv[++i];
+            } else {
+                std::fputs("Missing target triple parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--mcpu") {
+            if (i + 1 < argc) {
+                options.targetCPU = argv[++i];
+            } else {
+                std::fputs("Missing target CPU parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--mattr") {
+            if (i + 1 < argc) {
+                options.targetFeatures = argv[++i];
+            } else {
+                std::fputs("Missing target features parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--tape") {
+            if (i + 1 >= argc) {
+                std::fputs("Missing tape storage parameter\n", stderr);
+                std::exit(1);
+            }
+            std::string storage = argv[++i];
+            const auto* name = std::find(std::begin(tapeStorageNames), std::end(tapeStorageNames), storage);
+            if (name == std::end(tapeStorageNames)) {
+                std::cout << "Unknown tape storage: " + storage << std::endl;
+                std::exit(1);
+            }
+            options.tapeStorage = static_cast<BrainfuckCompiler::TapeStorage>(name - std::begin(tapeStorageNames));
+        } else if (arg == "--bounds" || arg.rfind("--bounds=", 0) == 0) {
+            std::string mode;
+            if (arg != "--bounds") {
+                mode = arg.substr(std::strlen("--bounds="));
+            } else if (i + 1 < argc) {
+                mode = argv[++i];
+            } else {
+                std::fputs("Missing bounds mode parameter\n", stderr);
+                std::exit(1);
+            }
+            const auto* name = std::find(std::begin(boundsModeNames), std::end(boundsModeNames), mode);
+            if (name == std::end(boundsModeNames)) {
+                std::cout << "Unknown bounds mode: " + mode << std::endl;
+                std::exit(1);
+            }
+            options.boundsMode = static_cast<BrainfuckCompiler::BoundsMode>(name - std::begin(boundsModeNames));
+        } else if (arg == "--backend" || arg.rfind("--backend=", 0) == 0) {
+            std::string backend;
+            if (arg != "--backend") {
+                backend = arg.substr(std::strlen("--backend="));
+            } else if (i + 1 < argc) {
+                backend = argv[++i];
+            } else {
+                std::fputs("Missing backend parameter\n", stderr);
+                std::exit(1);
+            }
+            const auto* name = std::find(std::begin(backendNames), std::end(backendNames), backend);
+            if (name == std::end(backendNames)) {
+                std::cout << "Unknown backend: " + backend << std::endl;
+                std::exit(1);
+            }
+            options.backend = static_cast<BrainfuckCompiler::Backend>(name - std::begin(backendNames));
+        } else if (arg == "--prefix-steps") {
+            if (i + 1 < argc) {
+                options.prefixSteps = std::stoul(argv[++i]);
+            } else {
+                std::fputs("Missing prefix steps parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--freestanding") {
+            options.freestanding = true;
+        } else if (arg == "--shared") {
+            options.sharedLibrary = true;
+        } else if (arg == "--cache-dir") {
+            if (i + 1 < argc) {
+                options.cacheDirectory = argv[++i];
+            } else {
+                std::fputs("Missing cache directory parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--compile-threads") {
+            if (i + 1 < argc) {
+                options.compileThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else {
+                std::fputs("Missing compile threads parameter\n", stderr);
+                std::exit(1);
+            }
         } else if (arg == "-g" || arg == "--debug") {
             options.enableDebugInfo = true;
         } else if (arg == "-j" || arg == "--jit") {
             options.enableJIT = true;
+        } else if (arg == "-t" || arg == "--tiered") {
+            options.enableTiered = true;
+        } else if (arg == "--tier-threshold") {
+            if (i + 1 < argc) {
+                options.tierThreshold = std::stoul(argv[++i]);
+            } else {
+                std::fputs("Missing tier threshold parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--batch") {
+            if (i + 1 < argc) {
+                options.batchDirectory = argv[++i];
+            } else {
+                std::fputs("Missing batch directory parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--batch-output") {
+            if (i + 1 < argc) {
+                options.batchOutputDirectory = argv[++i];
+            } else {
+                std::fputs("Missing batch output directory parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--jobs") {
+            if (i + 1 < argc) {
+                options.jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else {
+                std::fputs("Missing jobs parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--profile" || arg.rfind("--profile=", 0) == 0) {
+            options.profileFile = arg == "--profile" ? defaultProfileFile : arg.substr(std::strlen("--profile="));
+            if (options.profileFile.empty()) {
+                std::fputs("Missing profile filename parameter\n", stderr);
+                std::exit(1);
+            }
+        } else if (arg == "--profile-use" || arg.rfind("--profile-use=", 0) == 0) {
+            if (arg != "--profile-use") {
+                options.profileUseFile = arg.substr(std::strlen("--profile-use="));
+            } else if (i + 1 < argc) {
+                options.profileUseFile = argv[++i];
+            }
+            if (options.profileUseFile.empty()) {
+                std::fputs("Missing profile filename parameter\n", stderr);
+                std::exit(1);
+            }
         } else if (arg == "-s" || arg == "--stats") {
             options.showStats = true;
+        } else if (arg == "--time-report" || arg.rfind("--time-report=", 0) == 0) {
+            std::string format = arg == "--time-report" ? "text" : arg.substr(std::strlen("--time-report="));
+            if (format == "text") {
+                options.timeReport = BrainfuckTimeReport::Format::Text;
+            } else if (format == "json") {
+                options.timeReport = BrainfuckTimeReport::Format::JSON;
+            } else {
+                std::cout << "Unknown time report format: " + format << std::endl;
+                std::exit(1);
+            }
         } else if (arg == "-h" || arg == "--help") {
             options.showHelp = true;
         } else {
@@ -121,7 +409,7 @@ CommandLineOptions parseCommandLine(int argc, char* argv[]) {
  * @brief Display compilation statistics
  */
 void showStatistics(const BrainfuckCompiler& compiler) {
-    auto stats = compiler.getStatistics();
+    const BrainfuckStatistics& stats = compiler.getStatistics();
 
     std::cout << "\n=== Compilation Statistics ===" << std::endl;
     std::cout << "Instruction usage statistics:" << std::endl;
@@ -134,16 +422,56 @@ void showStatistics(const BrainfuckCompiler& compiler) {
 
     for (std::size_t i{}; i < 8; ++i) {
         char instr = instructionNames[i];
-        if (stats.count(instr) > 0) {
-            std::cout << "  '" << instr << "' (" << instructionDesc[i] << "): " << stats.at(instr) << " times"
-                      << std::endl;
-            totalInstructions += stats.at(instr);
+        std::size_t count = stats.count(instr);
+        if (count > 0) {
+            std::cout << "  '" << instr << "' (" << instructionDesc[i] << "): " << count << " times" << std::endl;
+            totalInstructions += count;
         }
     }
 
     std::cout << "Total instructions: " << totalInstructions << std::endl;
 }
 
+/**
+ * @brief Compile the program once and run it on every file of the batch directory
+ */
+bool runBatch(BrainfuckCompiler& compiler, std::string_view sourceCode, const CommandLineOptions& options) {
+    // Regular files of the directory, in name order for reproducible reports
+    std::vector<std::string> inputFiles;
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator entry(options.batchDirectory, ec), end; entry != end && !ec;
+         entry.increment(ec)) {
+        if (llvm::sys::fs::is_regular_file(entry->path())) {
+            inputFiles.push_back(entry->path());
+        }
+    }
+    if (ec) {
+        std::cerr << "Error: Cannot read batch directory " << options.batchDirectory << ": " << ec.message()
+                  << std::endl;
+        return false;
+    }
+    std::sort(inputFiles.begin(), inputFiles.end());
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<BrainfuckCompiledProgram> program = compiler.compileProgram(sourceCode);
+    if (!program) {
+        return false;
+    }
+    auto compiled = std::chrono::steady_clock::now();
+
+    BrainfuckBatchRunner runner(*program, options.jobs);
+    BrainfuckBatchRunner::Summary summary = runner.run(inputFiles, options.batchOutputDirectory);
+    auto finished = std::chrono::steady_clock::now();
+
+    auto milliseconds = [](auto duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    std::cout << "Batch completed: " << summary.runs << " inputs, " << summary.failures << " failed, "
+              << summary.outputBytes << " output bytes, compile " << milliseconds(compiled - start) << " ms, run "
+              << milliseconds(finished - compiled) << " ms" << std::endl;
+    return summary.failures == 0;
+}
+
 int main(int argc, char* argv[]) {
     try {
         // Parse command line arguments
@@ -156,32 +484,110 @@ int main(int argc, char* argv[]) {
         }
 
         // Check required parameters
-        if (options.inputFile.empty()) {
+        if (options.inputFiles.empty()) {
             std::cerr << "Error: Input file must be specified" << std::endl;
             std::cerr << "Use '" << argv[0] << " --help' for usage" << std::endl;
             return 1;
         }
 
-        // Read source file
-        std::string sourceCode = readFile(options.inputFile);
+        // Several inputs, or a shared object, are compiled into one bundle
+        bool bundle = options.inputFiles.size() > 1 || options.sharedLibrary;
+        if (bundle && (options.enableJIT || options.enableTiered || !options.batchDirectory.empty())) {
+            std::cerr << "Error: Bundles are only built as output files, not with -j, -t or --batch" << std::endl;
+            return 1;
+        }
+
+        // Phase timings, filled by the compiler when requested
+        BrainfuckTimeReport timeReport;
+        BrainfuckTimeReport* report = options.timeReport ? &timeReport : nullptr;
+
+        // Read source files, bundled programs are named after their files
+        std::vector<std::unique_ptr<llvm::MemoryBuffer>> sourceBuffers;
+        std::vector<BrainfuckCompiler::BundleProgram> programs;
+        {
+            BrainfuckTimeReport::Scope phase(report, "Source reading");
+            for (const std::string& inputFile : options.inputFiles) {
+                sourceBuffers.push_back(readFile(inputFile));
+                programs.push_back({llvm::sys::path::stem(inputFile).str(),
+                                    std::string_view(sourceBuffers.back()->getBufferStart(),
+                                                     sourceBuffers.back()->getBufferSize())});
+            }
+        }
+        std::string_view sourceCode = programs.front().source;
 
         // Create compiler
-        BrainfuckCompiler compiler(options.memorySize, options.enableOptimization);
+        BrainfuckCompiler compiler(options.memorySize, options.optLevel);
+        compiler.setTimeReport(report);
 
         // Set compilation options
         compiler.setDebugInfo(options.enableDebugInfo);
+        compiler.setCellBits(options.cellBits);
+        compiler.setTargetTriple(options.targetTriple);
+        compiler.setTargetCPU(options.targetCPU, options.targetFeatures);
+        compiler.setTapeStorage(options.tapeStorage);
+        compiler.setBoundsMode(options.boundsMode);
+        compiler.setBackend(options.backend);
+        compiler.setFreestanding(options.freestanding);
+        compiler.setCacheDirectory(options.cacheDirectory);
+        compiler.setCompileThreads(options.compileThreads);
+        compiler.setProfileFile(options.profileFile);
+        if (!options.profileUseFile.empty() && !compiler.loadProfile(options.profileUseFile)) {
+            return 1;
+        }
+        compiler.setPrefixStepBudget(options.prefixSteps.value_or(
+            options.optLevel == BrainfuckCompiler::OptLevel::O0 ? 0 : defaultPrefixSteps));
 
         // Compile
-        std::cout << "Compiling: " << options.inputFile << std::endl;
-        std::cout << "Memory size: " << options.memorySize << " bytes" << std::endl;
-        std::cout << "Optimization: " << (options.enableOptimization ? "Enabled" : "Disabled") << std::endl;
+        std::cout << "Compiling:";
+        for (const std::string& inputFile : options.inputFiles) {
+            std::cout << " " << inputFile;
+        }
+        std::cout << std::endl;
+        std::cout << "Memory size: " << options.memorySize << " cells" << std::endl;
+        std::cout << "Cell width: " << options.cellBits << " bits" << std::endl;
+        std::cout << "Optimization: " << optLevelName(options.optLevel) << std::endl;
+        if (!options.targetTriple.empty()) {
+            std::cout << "Target: " << options.targetTriple << std::endl;
+        }
+        std::cout << "Target CPU: " << options.targetCPU << std::endl;
+        std::cout << "Tape storage: " << tapeStorageName(options.tapeStorage) << std::endl;
+        std::cout << "Bounds mode: " << boundsModeName(options.boundsMode) << std::endl;
+        std::cout << "Backend: " << backendName(options.backend) << std::endl;
         std::cout << "Debug info: " << (options.enableDebugInfo ? "Enabled" : "Disabled") << std::endl;
-        std::cout << "Execution mode: " << (options.enableJIT ? "JIT" : "Compile") << std::endl;
+        if (!options.profileFile.empty()) {
+            std::cout << "Profile: " << options.profileFile << std::endl;
+        }
+        if (!options.profileUseFile.empty()) {
+            std::cout << "Profile use: " << options.profileUseFile << std::endl;
+        }
+        bool batch = !options.batchDirectory.empty();
+        std::cout << "Execution mode: "
+                  << (bundle ? (options.sharedLibrary ? "Shared library" : "Bundle")
+                             : (batch ? "Batch"
+                                      : (options.enableTiered ? "Tiered" : (options.enableJIT ? "JIT" : "Compile"))))
+                  << std::endl;
 
-        bool success = compiler.compile(sourceCode, options.outputFile, options.enableJIT);
+        bool success;
+        if (bundle) {
+            success = compiler.compileBundle(programs, options.outputFile,
+                                             options.sharedLibrary ? BrainfuckCompiler::BundleKind::SharedLibrary
+                                                                   : BrainfuckCompiler::BundleKind::Executable);
+        } else if (batch) {
+            success = runBatch(compiler, sourceCode, options);
+        } else if (options.enableTiered) {
+            success = compiler.interpret(sourceCode, options.tierThreshold);
+        } else {
+            success = compiler.compile(sourceCode, options.outputFile, options.enableJIT);
+        }
+
+        // Failed builds are reported as well, up to the failing phase
+        if (report) {
+            std::cout << std::flush;
+            report->print(llvm::errs(), *options.timeReport);
+        }
 
         if (!success) {
-            std::cerr << "Compilation failed" << std::endl;
+            std::cerr << (batch ? "Batch failed" : "Compilation failed") << std::endl;
             return 1;
         }
 
@@ -192,7 +598,7 @@ int main(int argc, char* argv[]) {
 
         std::cout << "Compilation successful!" << std::endl;
 
-        if (!options.enableJIT) {
+        if (!options.enableJIT && !options.enableTiered && !batch) {
             std::cout << "Output file: " << options.outputFile << std::endl;
         }
 